@@ -0,0 +1,306 @@
+/**
+ * Benchmark for the contingency table counting of VOI and RAND on very large
+ * volumes.
+ *
+ * A synthetic volume is streamed row by row through a ContingencyTable, as the
+ * ted binary does with option --streamVoiRand. The labels are chosen such that
+ * the exact contingency table is known in closed form, which allows to check
+ * the streamed counts and the resulting errors for volumes that are too large
+ * to be counted in 32 (or their squares in 64) bit.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <evaluation/ContingencyTable.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+
+using namespace logger;
+
+util::ProgramOption optionWidth(
+		util::_long_name        = "width",
+		util::_description_text = "The width of the synthetic volume.",
+		util::_default_value    = 10000);
+
+util::ProgramOption optionHeight(
+		util::_long_name        = "height",
+		util::_description_text = "The height of the synthetic volume.",
+		util::_default_value    = 10000);
+
+util::ProgramOption optionDepth(
+		util::_long_name        = "depth",
+		util::_description_text = "The number of sections of the synthetic volume.",
+		util::_default_value    = 1000);
+
+util::ProgramOption optionGtBlockWidth(
+		util::_long_name        = "gtBlockWidth",
+		util::_description_text = "The width of the ground truth regions in x.",
+		util::_default_value    = 100);
+
+util::ProgramOption optionRecBlockWidth(
+		util::_long_name        = "recBlockWidth",
+		util::_description_text = "The width of the reconstruction regions in x.",
+		util::_default_value    = 120);
+
+util::ProgramOption optionRecShift(
+		util::_long_name        = "recShift",
+		util::_description_text = "The offset in x of the reconstruction regions.",
+		util::_default_value    = 37);
+
+util::ProgramOption optionGtSlabDepth(
+		util::_long_name        = "gtSlabDepth",
+		util::_description_text = "The number of sections spanned by a ground truth region.",
+		util::_default_value    = 50);
+
+util::ProgramOption optionRecSlabDepth(
+		util::_long_name        = "recSlabDepth",
+		util::_description_text = "The number of sections spanned by a reconstruction region.",
+		util::_default_value    = 64);
+
+/**
+ * The synthetic labelling: Both ground truth and reconstruction consist of
+ * blocks that span the whole height of the volume. The reconstruction blocks
+ * have a different width, offset, and depth than the ground truth blocks.
+ */
+struct Labelling {
+
+	unsigned int width;
+	unsigned int gtBlockWidth, recBlockWidth, recShift;
+	unsigned int gtSlabDepth, recSlabDepth;
+
+	unsigned int numGtBlocks() const { return width/gtBlockWidth + 1; }
+	unsigned int numRecBlocks() const { return (width + recShift)/recBlockWidth + 1; }
+
+	float gtLabel(unsigned int x, unsigned int z) const {
+
+		return 1 + x/gtBlockWidth + numGtBlocks()*(z/gtSlabDepth);
+	}
+
+	float recLabel(unsigned int x, unsigned int z) const {
+
+		return 1 + (x + recShift)/recBlockWidth + numRecBlocks()*(z/recSlabDepth);
+	}
+};
+
+/**
+ * Count the volume location by location, a few rows at a time.
+ */
+void
+countStreamed(const Labelling& labelling, unsigned int height, unsigned int depth, ContingencyTable& table) {
+
+	const unsigned int rowsPerChunk = 64;
+
+	std::vector<float> gtRows(labelling.width*rowsPerChunk);
+	std::vector<float> recRows(labelling.width*rowsPerChunk);
+
+	for (unsigned int z = 0; z < depth; z++) {
+
+		for (unsigned int y = 0; y < rowsPerChunk; y++)
+			for (unsigned int x = 0; x < labelling.width; x++) {
+
+				gtRows[y*labelling.width + x]  = labelling.gtLabel(x, z);
+				recRows[y*labelling.width + x] = labelling.recLabel(x, z);
+			}
+
+		// all rows of a section are equal, but we count them anyway
+		for (unsigned int y = 0; y < height; y += rowsPerChunk) {
+
+			unsigned int numRows = std::min(rowsPerChunk, height - y);
+
+			table.add(recRows.begin(), recRows.begin() + numRows*labelling.width, gtRows.begin());
+		}
+
+		LOG_DEBUG(out) << "[counting] counted section " << z << std::endl;
+	}
+}
+
+/**
+ * Fill the table with the exact counts, without visiting every location.
+ */
+void
+countBulk(const Labelling& labelling, unsigned int height, unsigned int depth, ContingencyTable& table) {
+
+	for (unsigned int z = 0; z < depth;) {
+
+		// the number of sections with the same ground truth and reconstruction
+		// slabs as z
+		unsigned int gtSlabEnd  = (z/labelling.gtSlabDepth + 1)*labelling.gtSlabDepth;
+		unsigned int recSlabEnd = (z/labelling.recSlabDepth + 1)*labelling.recSlabDepth;
+		unsigned int zEnd       = std::min(depth, std::min(gtSlabEnd, recSlabEnd));
+
+		uint64_t numRows = static_cast<uint64_t>(height)*(zEnd - z);
+
+		for (unsigned int x = 0; x < labelling.width; x++)
+			table.add(labelling.recLabel(x, z), labelling.gtLabel(x, z), numRows);
+
+		z = zEnd;
+	}
+}
+
+/**
+ * Independent reference for the RAND precision and recall and the VOI,
+ * computed in long double from the exact counts.
+ */
+void
+reference(const ContingencyTable& table, long double& precision, long double& recall, long double& voiSplit, long double& voiMerge) {
+
+	long double n = table.getNumLocations();
+
+	long double sumJoint = 0;
+	long double sumRec   = 0;
+	long double sumGt    = 0;
+
+	long double H1 = 0;
+	long double H2 = 0;
+	long double H12 = 0;
+
+	ContingencyTable::LabelPair labels;
+	float                       label;
+	uint64_t                    count;
+
+	foreach (boost::tie(labels, count), table.getJointCounts()) {
+
+		sumJoint += static_cast<long double>(count)*count;
+		H12 -= (count/n)*std::log2(count/n);
+	}
+
+	foreach (boost::tie(label, count), table.getReconstructionCounts()) {
+
+		sumRec += static_cast<long double>(count)*count;
+		H1 -= (count/n)*std::log2(count/n);
+	}
+
+	foreach (boost::tie(label, count), table.getGroundTruthCounts()) {
+
+		sumGt += static_cast<long double>(count)*count;
+		H2 -= (count/n)*std::log2(count/n);
+	}
+
+	precision = sumJoint/sumGt;
+	recall    = sumJoint/sumRec;
+	voiSplit  = H12 - H2;
+	voiMerge  = H12 - H1;
+}
+
+bool
+approximatelyEqual(long double a, long double b) {
+
+	return std::abs(a - b) <= 1e-9*std::max(1.0L, std::abs(b));
+}
+
+int main(int optionc, char** optionv) {
+
+	try {
+
+		util::ProgramOptions::init(optionc, optionv);
+		LogManager::init();
+		Logger::showChannelPrefix(false);
+
+		Labelling labelling;
+		labelling.width         = optionWidth.as<unsigned int>();
+		labelling.gtBlockWidth  = optionGtBlockWidth.as<unsigned int>();
+		labelling.recBlockWidth = optionRecBlockWidth.as<unsigned int>();
+		labelling.recShift      = optionRecShift.as<unsigned int>();
+		labelling.gtSlabDepth   = optionGtSlabDepth.as<unsigned int>();
+		labelling.recSlabDepth  = optionRecSlabDepth.as<unsigned int>();
+
+		unsigned int height = optionHeight.as<unsigned int>();
+		unsigned int depth  = optionDepth.as<unsigned int>();
+
+		// labels are stored in float
+		if (static_cast<double>(labelling.numGtBlocks())*(depth/labelling.gtSlabDepth + 1) > 16777216 ||
+		    static_cast<double>(labelling.numRecBlocks())*(depth/labelling.recSlabDepth + 1) > 16777216)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"too many labels to be represented exactly in float, increase the block sizes");
+
+		const uint64_t numLocations = static_cast<uint64_t>(labelling.width)*height*depth;
+
+		LOG_USER(out) << "[counting] streaming " << numLocations << " locations" << std::endl;
+		LOG_USER(out) << "[counting] squared number of locations "
+		              << (static_cast<double>(numLocations)*numLocations > 18446744073709551615.0 ? "exceeds" : "fits into")
+		              << " 64 bit" << std::endl;
+
+		ContingencyTable streamed;
+		ContingencyTable bulk;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		countStreamed(labelling, height, depth, streamed);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+
+		countBulk(labelling, height, depth, bulk);
+
+		VariationOfInformationErrors streamedVoi, bulkVoi;
+		RandIndexErrors              streamedRand, bulkRand;
+
+		start = std::chrono::steady_clock::now();
+		streamed.computeVariationOfInformation(streamedVoi);
+		streamed.computeRandIndex(streamedRand);
+		end = std::chrono::steady_clock::now();
+
+		double computeSeconds = std::chrono::duration<double>(end - start).count();
+
+		bulk.computeVariationOfInformation(bulkVoi);
+		bulk.computeRandIndex(bulkRand);
+
+		long double precision, recall, voiSplit, voiMerge;
+		reference(bulk, precision, recall, voiSplit, voiMerge);
+
+		LOG_USER(out) << "[counting] counted in " << seconds << "s ("
+		              << (numLocations/seconds/1e9) << " gigavoxels/s), errors computed in "
+		              << computeSeconds << "s" << std::endl;
+		LOG_USER(out) << "[counting] " << streamedVoi.humanReadableErrorString() << "; "
+		              << streamedRand.humanReadableErrorString() << std::endl;
+
+		bool correct = true;
+
+		if (streamed.getNumLocations() != numLocations) {
+
+			LOG_ERROR(out) << "[counting] counted " << streamed.getNumLocations() << " locations, expected " << numLocations << std::endl;
+			correct = false;
+		}
+
+		if (streamed.getJointCounts() != bulk.getJointCounts()) {
+
+			LOG_ERROR(out) << "[counting] streamed and bulk contingency tables differ" << std::endl;
+			correct = false;
+		}
+
+		if (!approximatelyEqual(streamedRand.getPrecision(), precision) || !approximatelyEqual(streamedRand.getRecall(), recall)) {
+
+			LOG_ERROR(out)
+					<< "[counting] RAND precision and recall are " << streamedRand.getPrecision() << ", " << streamedRand.getRecall()
+					<< ", expected " << static_cast<double>(precision) << ", " << static_cast<double>(recall) << std::endl;
+			correct = false;
+		}
+
+		if (!approximatelyEqual(streamedVoi.getSplitEntropy(), voiSplit) || !approximatelyEqual(streamedVoi.getMergeEntropy(), voiMerge)) {
+
+			LOG_ERROR(out)
+					<< "[counting] VOI split and merge are " << streamedVoi.getSplitEntropy() << ", " << streamedVoi.getMergeEntropy()
+					<< ", expected " << static_cast<double>(voiSplit) << ", " << static_cast<double>(voiMerge) << std::endl;
+			correct = false;
+		}
+
+		if (streamedRand.getRandIndex() != bulkRand.getRandIndex() || streamedVoi.getEntropy() != bulkVoi.getEntropy()) {
+
+			LOG_ERROR(out) << "[counting] streamed and bulk errors differ" << std::endl;
+			correct = false;
+		}
+
+		LOG_USER(out) << "[counting] " << (correct ? "correct" : "FAILED") << std::endl;
+
+		return (correct ? 0 : 1);
+
+	} catch (Exception& e) {
+
+		handleException(e, std::cerr);
+		return 1;
+	}
+}
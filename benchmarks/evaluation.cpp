@@ -0,0 +1,474 @@
+/**
+ * Benchmarks for the hot paths of the evaluation and inference.
+ *
+ * Each benchmark is run on synthetic volumes for all combinations of the
+ * given volume sizes, region sizes (i.e., label densities), tolerance
+ * thresholds, and z resolutions it depends on:
+ *
+ *   cells      connected components of ground truth x reconstruction
+ *              (vigra::labelMultiArray), as in the cell extraction of the TED
+ *   tolerance  the boundary map, the boundary distance transform, and the
+ *              search for alternative labels of DistanceToleranceFunction
+ *   ilp        the construction of the TED ILP, its upload to the default
+ *              solver backend (Gurobi, if available), and the solve
+ *   errors     TolerantEditDistanceErrors::updateErrorCounts()
+ *   rand       RandIndex
+ *   voi        VariationOfInformation
+ *   overlap    DetectionOverlap, on the first section only (it accepts
+ *              only single 2D images)
+ *
+ * The stages inside the tolerance function and the TED are measured with the
+ * StageMetrics the evaluation records anyways. For each stage, the median and
+ * minimal wall time over the repetitions are reported, together with the
+ * item counts of the last repetition.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <vigra/multi_labeling.hxx>
+
+#include <evaluation/DetectionOverlap.h>
+#include <evaluation/DistanceToleranceFunction.h>
+#include <evaluation/RandIndex.h>
+#include <evaluation/StageMetrics.h>
+#include <evaluation/TedEngine.h>
+#include <evaluation/TolerantEditDistanceErrors.h>
+#include <evaluation/VariationOfInformation.h>
+#include <imageprocessing/ImageStack.h>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/exceptions.h>
+#include <util/foreach.h>
+
+using namespace logger;
+
+typedef std::map<std::string, size_t>::value_type count_t;
+
+util::ProgramOption optionBenchmarks(
+		util::_long_name        = "benchmarks",
+		util::_description_text = "Comma separated list of the benchmarks to run (cells, tolerance, ilp, errors, rand, voi, overlap).",
+		util::_default_value    = "cells,tolerance,ilp,errors,rand,voi,overlap");
+
+util::ProgramOption optionSizes(
+		util::_long_name        = "sizes",
+		util::_description_text = "Comma separated list of the widths and heights of the synthetic volumes.",
+		util::_default_value    = "128,256,512");
+
+util::ProgramOption optionDepth(
+		util::_long_name        = "depth",
+		util::_description_text = "The number of sections of the synthetic volumes.",
+		util::_default_value    = 16);
+
+util::ProgramOption optionRegionSizes(
+		util::_long_name        = "regionSizes",
+		util::_description_text = "Comma separated list of the sizes of the ground truth regions in x and y, in voxels. Smaller "
+		                          "regions give a higher label density.",
+		util::_default_value    = "8,32,128");
+
+util::ProgramOption optionThresholds(
+		util::_long_name        = "thresholds",
+		util::_description_text = "Comma separated list of tolerance thresholds (maximal boundary shifts) in units.",
+		util::_default_value    = "5,10");
+
+util::ProgramOption optionZResolutions(
+		util::_long_name        = "zResolutions",
+		util::_description_text = "Comma separated list of z resolutions, in units of the x and y resolution (which is 1).",
+		util::_default_value    = "1,10");
+
+util::ProgramOption optionRepetitions(
+		util::_long_name        = "repetitions",
+		util::_description_text = "The number of repetitions of each benchmark.",
+		util::_default_value    = 3);
+
+util::ProgramOption optionResultFile(
+		util::_long_name        = "resultFile",
+		util::_description_text = "Append the results as tab-separated lines to the given file.");
+
+/**
+ * The parameters of one run of a benchmark.
+ */
+struct Case {
+
+	unsigned int size;
+	unsigned int depth;
+	unsigned int regionSize;
+	float        threshold;
+	float        zResolution;
+
+	size_t numLocations() const { return static_cast<size_t>(size)*size*depth; }
+};
+
+/**
+ * The synthetic ground truth and reconstruction of a case.
+ */
+struct Volumes {
+
+	pipeline::Value<ImageStack> groundTruth;
+	pipeline::Value<ImageStack> reconstruction;
+};
+
+template <typename T>
+std::vector<T>
+parseList(const std::string& list) {
+
+	std::vector<T>     values;
+	std::istringstream stream(list);
+	std::string        item;
+
+	while (std::getline(stream, item, ',')) {
+
+		std::istringstream itemStream(item);
+		T value;
+		if (!(itemStream >> value))
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"can not parse '" << item << "' in list '" << list << "'");
+
+		values.push_back(value);
+	}
+
+	return values;
+}
+
+/**
+ * Create ground truth regions of regionSize x regionSize x regionSize
+ * voxels (the last in sections, scaled by the z resolution). The
+ * reconstruction regions are a third larger and shifted by a quarter region,
+ * such that every ground truth region is split and merged, with boundary
+ * shifts of all lengths up to the region size.
+ */
+void
+createVolumes(const Case& c, Volumes& volumes) {
+
+	unsigned int regionDepth = std::max(1u, static_cast<unsigned int>(c.regionSize/c.zResolution));
+	unsigned int recSize     = c.regionSize + c.regionSize/3 + 1;
+	unsigned int recDepth    = regionDepth + regionDepth/3 + 1;
+	unsigned int shift       = c.regionSize/4;
+
+	unsigned int numGt  = c.size/c.regionSize + 1;
+	unsigned int numRec = (c.size + shift)/recSize + 1;
+
+	volumes.groundTruth->clear();
+	volumes.reconstruction->clear();
+
+	for (unsigned int z = 0; z < c.depth; z++) {
+
+		boost::shared_ptr<Image> gt  = boost::make_shared<Image>(c.size, c.size);
+		boost::shared_ptr<Image> rec = boost::make_shared<Image>(c.size, c.size);
+
+		for (unsigned int y = 0; y < c.size; y++)
+			for (unsigned int x = 0; x < c.size; x++) {
+
+				(*gt)(x, y) =
+						1 +
+						x/c.regionSize +
+						numGt*(y/c.regionSize) +
+						numGt*numGt*(z/regionDepth);
+				(*rec)(x, y) =
+						1 +
+						(x + shift)/recSize +
+						numRec*((y + shift)/recSize) +
+						numRec*numRec*((z + regionDepth/4)/recDepth);
+			}
+
+		volumes.groundTruth->add(gt);
+		volumes.reconstruction->add(rec);
+	}
+
+	volumes.groundTruth->setResolution(1.0, 1.0, c.zResolution);
+	volumes.reconstruction->setResolution(1.0, 1.0, c.zResolution);
+}
+
+/**
+ * Find the connected components of ground truth x reconstruction, as
+ * TedEngine does for the cell extraction.
+ */
+unsigned int
+labelCells(const Volumes& volumes, vigra::MultiArray<3, unsigned int>& cellIds) {
+
+	const ImageStack& gt  = *volumes.groundTruth;
+	const ImageStack& rec = *volumes.reconstruction;
+
+	vigra::MultiArray<3, std::pair<float, float> > gtAndRec(vigra::Shape3(gt.width(), gt.height(), gt.size()));
+
+	for (unsigned int z = 0; z < gt.size(); z++)
+		for (unsigned int y = 0; y < gt.height(); y++)
+			for (unsigned int x = 0; x < gt.width(); x++)
+				gtAndRec(x, y, z) = std::make_pair((*gt[z])(x, y), (*rec[z])(x, y));
+
+	cellIds.reshape(gtAndRec.shape());
+	cellIds = 0;
+
+	return vigra::labelMultiArray(gtAndRec, cellIds);
+}
+
+void
+benchmarkCells(const Volumes& volumes, StageMetrics& metrics) {
+
+	vigra::MultiArray<3, unsigned int> cellIds;
+
+	StageMetrics::Timer timer(&metrics, "label cells");
+	unsigned int numCells = labelCells(volumes, cellIds);
+	timer.addCount("cells", numCells);
+}
+
+void
+benchmarkTolerance(const Case& c, const Volumes& volumes, StageMetrics& metrics) {
+
+	vigra::MultiArray<3, unsigned int> cellIds;
+	unsigned int numCells = labelCells(volumes, cellIds);
+
+	TedEngine::Options options = TedEngine::Options::fromProgramOptions();
+
+	DistanceToleranceFunction toleranceFunction(
+			c.threshold,
+			false,
+			0.0,
+			options.sliceWise,
+			options.numThreads);
+	toleranceFunction.setResolution(1.0, 1.0, c.zResolution);
+	toleranceFunction.setMetrics(&metrics);
+
+	toleranceFunction.clear();
+	toleranceFunction.extractCells(numCells, cellIds, *volumes.reconstruction, *volumes.groundTruth);
+}
+
+void
+benchmarkIlp(const Case& c, const Volumes& volumes, StageMetrics& metrics) {
+
+	TedEngine::Options options = TedEngine::Options::fromProgramOptions();
+	options.maxBoundaryShift = c.threshold;
+	options.computeVolumes   = false;
+
+	TedEngine            engine(options);
+	TedEngine::Workspace workspace;
+
+	engine.evaluate(*volumes.groundTruth, *volumes.reconstruction, workspace);
+
+	// only the stages of the ILP
+	foreach (const StageMetrics::Stage& stage, workspace.getMetrics()->getStages())
+		if (stage.name == "setup ILP" || stage.name == "presolve" || stage.name == "upload ILP" || stage.name == "solve ILP")
+			metrics.add(stage);
+}
+
+void
+benchmarkErrors(const Case& c, const Volumes& volumes, StageMetrics& metrics) {
+
+	vigra::MultiArray<3, unsigned int> cellIds;
+	unsigned int numCells = labelCells(volumes, cellIds);
+
+	DistanceToleranceFunction toleranceFunction(c.threshold, false);
+	toleranceFunction.setResolution(1.0, 1.0, c.zResolution);
+	toleranceFunction.clear();
+	toleranceFunction.extractCells(numCells, cellIds, *volumes.reconstruction, *volumes.groundTruth);
+
+	LocalToleranceFunction::cells_t cells = toleranceFunction.getCells();
+
+	// the errors of the reconstruction without corrections
+	TolerantEditDistanceErrors errors;
+	errors.setCells(cells);
+	for (unsigned int i = 0; i < cells->size(); i++)
+		errors.addMapping(i, (*cells)[i].getReconstructionLabel());
+
+	StageMetrics::Timer timer(&metrics, "update error counts");
+	unsigned int numErrors = errors.getNumErrors();
+	timer.addCount("cells", cells->size());
+	timer.addCount("errors", numErrors);
+}
+
+void
+benchmarkRand(const Volumes& volumes, StageMetrics& metrics) {
+
+	StageMetrics::Timer timer(&metrics, "rand index");
+
+	pipeline::Process<RandIndex> rand;
+	rand->setInput("reconstruction", volumes.reconstruction);
+	rand->setInput("ground truth", volumes.groundTruth);
+
+	pipeline::Value<RandIndexErrors> errors = rand->getOutput("errors");
+	errors->getRandIndex();
+}
+
+void
+benchmarkVoi(const Volumes& volumes, StageMetrics& metrics) {
+
+	StageMetrics::Timer timer(&metrics, "variation of information");
+
+	pipeline::Process<VariationOfInformation> voi;
+	voi->setInput("reconstruction", volumes.reconstruction);
+	voi->setInput("ground truth", volumes.groundTruth);
+
+	pipeline::Value<VariationOfInformationErrors> errors = voi->getOutput("errors");
+	errors->getEntropy();
+}
+
+void
+benchmarkOverlap(const Volumes& volumes, StageMetrics& metrics) {
+
+	// DetectionOverlap only accepts single sections
+	pipeline::Value<ImageStack> groundTruth;
+	pipeline::Value<ImageStack> reconstruction;
+	groundTruth->add((*volumes.groundTruth)[0]);
+	reconstruction->add((*volumes.reconstruction)[0]);
+
+	StageMetrics::Timer timer(&metrics, "detection overlap");
+
+	pipeline::Process<DetectionOverlap> overlap;
+	overlap->setInput("stack 1", groundTruth);
+	overlap->setInput("stack 2", reconstruction);
+
+	pipeline::Value<DetectionOverlapErrors> errors = overlap->getOutput("errors");
+	errors->errorString();
+}
+
+/**
+ * Run a benchmark several times and report the wall time of each of its
+ * stages.
+ */
+template <typename Benchmark>
+void
+run(const std::string& name, const Case& c, Benchmark benchmark, std::ostream* resultFile) {
+
+	unsigned int repetitions = std::max(1u, optionRepetitions.as<unsigned int>());
+
+	std::vector<std::string>                     stageNames;
+	std::map<std::string, std::vector<double> >  wallTimes;
+	std::map<std::string, StageMetrics::Stage>   lastStages;
+
+	for (unsigned int i = 0; i < repetitions; i++) {
+
+		StageMetrics metrics;
+		benchmark(metrics);
+
+		foreach (const StageMetrics::Stage& stage, metrics.getStages()) {
+
+			if (wallTimes.count(stage.name) == 0)
+				stageNames.push_back(stage.name);
+
+			wallTimes[stage.name].push_back(stage.wallTime);
+			lastStages[stage.name] = stage;
+		}
+	}
+
+	foreach (const std::string& stageName, stageNames) {
+
+		std::vector<double>& times = wallTimes[stageName];
+		std::sort(times.begin(), times.end());
+
+		double median = times[times.size()/2];
+		double min    = times[0];
+
+		std::stringstream counts;
+		foreach (const count_t& count, lastStages[stageName].counts)
+			counts << count.first << "=" << count.second << " ";
+
+		std::stringstream line;
+		line
+				<< name << "\t" << stageName << "\t"
+				<< c.size << "\t" << c.size << "\t" << c.depth << "\t"
+				<< c.regionSize << "\t" << c.threshold << "\t" << c.zResolution << "\t"
+				<< median << "\t" << min << "\t"
+				<< (median > 0 ? c.numLocations()/median/1e6 : 0) << "\t"
+				<< counts.str();
+
+		LOG_USER(out) << line.str() << std::endl;
+
+		if (resultFile)
+			*resultFile << line.str() << std::endl;
+	}
+}
+
+int main(int optionc, char** optionv) {
+
+	try {
+
+		util::ProgramOptions::init(optionc, optionv);
+		LogManager::init();
+		Logger::showChannelPrefix(false);
+
+		std::vector<std::string>  benchmarks   = parseList<std::string>(optionBenchmarks.as<std::string>());
+		std::vector<unsigned int> sizes        = parseList<unsigned int>(optionSizes.as<std::string>());
+		std::vector<unsigned int> regionSizes  = parseList<unsigned int>(optionRegionSizes.as<std::string>());
+		std::vector<float>        thresholds   = parseList<float>(optionThresholds.as<std::string>());
+		std::vector<float>        zResolutions = parseList<float>(optionZResolutions.as<std::string>());
+
+		std::set<std::string> selected(benchmarks.begin(), benchmarks.end());
+
+		boost::shared_ptr<std::ofstream> resultFile;
+		if (optionResultFile)
+			resultFile = boost::make_shared<std::ofstream>(optionResultFile.as<std::string>().c_str(), std::ofstream::app);
+
+		LOG_USER(out)
+				<< "benchmark\tstage\twidth\theight\tdepth\tregion size\tthreshold\tz resolution\t"
+				<< "median [s]\tmin [s]\tmegavoxels/s\tcounts" << std::endl;
+
+		Case c;
+		c.depth = optionDepth.as<unsigned int>();
+
+		foreach (c.size, sizes)
+			foreach (c.regionSize, regionSizes) {
+
+				if (c.regionSize == 0)
+					UTIL_THROW_EXCEPTION(
+							UsageError,
+							"region sizes have to be positive");
+
+				// the benchmarks that don't depend on the tolerance
+				// parameters
+
+				c.threshold   = 0;
+				c.zResolution = 1;
+
+				Volumes volumes;
+				createVolumes(c, volumes);
+
+				if (selected.count("cells"))
+					run("cells", c, [&](StageMetrics& m) { benchmarkCells(volumes, m); }, resultFile.get());
+				if (selected.count("rand"))
+					run("rand", c, [&](StageMetrics& m) { benchmarkRand(volumes, m); }, resultFile.get());
+				if (selected.count("voi"))
+					run("voi", c, [&](StageMetrics& m) { benchmarkVoi(volumes, m); }, resultFile.get());
+				if (selected.count("overlap")) {
+
+					Case section = c;
+					section.depth = 1;
+					run("overlap", section, [&](StageMetrics& m) { benchmarkOverlap(volumes, m); }, resultFile.get());
+				}
+
+				if (!selected.count("tolerance") && !selected.count("ilp") && !selected.count("errors"))
+					continue;
+
+				foreach (c.zResolution, zResolutions) {
+
+					// the regions are scaled in z with the resolution
+					createVolumes(c, volumes);
+
+					foreach (c.threshold, thresholds) {
+
+						if (selected.count("tolerance"))
+							run("tolerance", c, [&](StageMetrics& m) { benchmarkTolerance(c, volumes, m); }, resultFile.get());
+						if (selected.count("ilp"))
+							run("ilp", c, [&](StageMetrics& m) { benchmarkIlp(c, volumes, m); }, resultFile.get());
+						if (selected.count("errors"))
+							run("errors", c, [&](StageMetrics& m) { benchmarkErrors(c, volumes, m); }, resultFile.get());
+					}
+				}
+			}
+
+	} catch (Exception& e) {
+
+		handleException(e, std::cerr);
+		return 1;
+	}
+}
+
@@ -0,0 +1,288 @@
+/**
+ * Replays linear programs against solver backends, to choose backends and
+ * their parameters on the programs of real evaluations.
+ *
+ * The programs are read from MPS files, as written by the TED and the
+ * detection overlap with the program option inference.dumpLinearPrograms.
+ * Each program is solved with each backend configuration (see
+ * DefaultFactory::createLinearSolverBackend()), e.g.,
+ *
+ *   ted_bench_ilp --programs dumps --configurations "gurobi;gurobi:MIPFocus=1;gurobi:MIPFocus=2"
+ *
+ * The configuration "portfolio" races the configurations given with
+ * inference.portfolio against each other.
+ *
+ * For each program and configuration, the median wall times of the upload
+ * and the solve over the repetitions are reported, together with the solver
+ * statistics of the last repetition. Backends that don't report statistics
+ * show "n/a" for the bound, the gap, and the number of nodes.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/timer/timer.hpp>
+
+#include <inference/DefaultFactory.h>
+#include <inference/LinearProgram.h>
+#include <inference/LinearSolverBackend.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/exceptions.h>
+#include <util/foreach.h>
+
+using namespace logger;
+
+util::ProgramOption optionPrograms(
+		util::_long_name        = "programs",
+		util::_description_text = "A directory of linear programs in the free MPS format, or a single MPS file.",
+		util::_default_value    = ".");
+
+util::ProgramOption optionConfigurations(
+		util::_long_name        = "configurations",
+		util::_description_text = "Semicolon separated list of solver backend configurations <backend>[:<parameter>=<value>,...]. "
+		                          "The default are all available backends with their default parameters.");
+
+util::ProgramOption optionRepetitions(
+		util::_long_name        = "repetitions",
+		util::_description_text = "The number of times each program is solved with each configuration.",
+		util::_default_value    = 1);
+
+util::ProgramOption optionResultFile(
+		util::_long_name        = "resultFile",
+		util::_description_text = "Append the results as tab-separated lines to the given file.");
+
+std::vector<std::string>
+getProgramFiles(const std::string& programs) {
+
+	std::vector<std::string> filenames;
+
+	boost::filesystem::path path(programs);
+
+	if (boost::filesystem::is_directory(path)) {
+
+		boost::filesystem::directory_iterator i(path), end;
+		for (; i != end; i++)
+			if (boost::filesystem::is_regular_file(*i) && i->path().extension() == ".mps")
+				filenames.push_back(i->path().string());
+
+		std::sort(filenames.begin(), filenames.end());
+
+	} else if (boost::filesystem::is_regular_file(path)) {
+
+		filenames.push_back(programs);
+
+	} else {
+
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				programs << " is neither an MPS file nor a directory");
+	}
+
+	return filenames;
+}
+
+std::vector<std::string>
+getConfigurations() {
+
+	if (!optionConfigurations)
+		return DefaultFactory::getLinearSolverBackendNames();
+
+	std::vector<std::string> configurations;
+	std::istringstream       stream(optionConfigurations.as<std::string>());
+	std::string              configuration;
+
+	while (std::getline(stream, configuration, ';'))
+		if (!configuration.empty())
+			configurations.push_back(configuration);
+
+	return configurations;
+}
+
+double
+median(std::vector<double> values) {
+
+	std::sort(values.begin(), values.end());
+	return values[values.size()/2];
+}
+
+/**
+ * The outcome of the last repetition of a replay.
+ */
+struct ReplayResult {
+
+	// the backend found a solution
+	bool solved;
+
+	// the value of the solution, as reported by solve()
+	double value;
+
+	// the statistics of the backend, might not be available
+	SolverStatistics statistics;
+};
+
+/**
+ * Format a statistic for the result line, "n/a" if the backend does not
+ * report statistics.
+ */
+std::string
+formatStatistic(const SolverStatistics& statistics, double value) {
+
+	if (!statistics.available)
+		return "n/a";
+
+	std::stringstream stream;
+	stream << value;
+	return stream.str();
+}
+
+/**
+ * Solve a program with one configuration several times and report the
+ * times and the solver statistics.
+ */
+ReplayResult
+replay(
+		const std::string&   filename,
+		const LinearProgram& program,
+		const std::string&   configuration,
+		std::ostream*        resultFile) {
+
+	unsigned int repetitions = std::max(1u, optionRepetitions.as<unsigned int>());
+
+	std::vector<double> uploadTimes;
+	std::vector<double> solveTimes;
+
+	ReplayResult result;
+	result.solved = false;
+	result.value  = 0;
+
+	for (unsigned int i = 0; i < repetitions; i++) {
+
+		// a new backend for each repetition, such that nothing is reused
+		boost::shared_ptr<LinearSolverBackend> backend(DefaultFactory().createLinearSolverBackend(configuration));
+
+		boost::timer::cpu_timer uploadTimer;
+		program.setup(*backend);
+		uploadTimes.push_back(uploadTimer.elapsed().wall*1e-9);
+
+		Solution    solution;
+		std::string message;
+
+		boost::timer::cpu_timer solveTimer;
+		result.solved = backend->solve(solution, result.value, message);
+		solveTimes.push_back(solveTimer.elapsed().wall*1e-9);
+
+		result.statistics = backend->getStatistics();
+
+		if (!result.solved)
+			LOG_ERROR(out) << filename << " with " << configuration << ": " << message << std::endl;
+	}
+
+	const SolverStatistics& statistics = result.statistics;
+
+	// backends without statistics only tell whether they found a solution
+	std::string status;
+	if (!result.solved)
+		status = "failed";
+	else if (!statistics.available)
+		status = "solved";
+	else
+		status = (statistics.optimal ? "optimal" : "feasible");
+
+	std::stringstream line;
+	line
+			<< boost::filesystem::path(filename).filename().string() << "\t"
+			<< program.numVariables << "\t"
+			<< program.constraints.size() << "\t"
+			<< program.getNumNonZeros() << "\t"
+			<< configuration << "\t"
+			<< status << "\t";
+
+	if (result.solved)
+		line << result.value << "\t";
+	else
+		line << "n/a\t";
+
+	line
+			<< formatStatistic(statistics, statistics.bound) << "\t"
+			<< formatStatistic(statistics, statistics.gap) << "\t"
+			<< formatStatistic(statistics, statistics.nodes) << "\t"
+			<< median(uploadTimes) << "\t"
+			<< median(solveTimes);
+
+	LOG_USER(out) << line.str() << std::endl;
+
+	if (resultFile)
+		*resultFile << line.str() << std::endl;
+
+	return result;
+}
+
+int main(int optionc, char** optionv) {
+
+	try {
+
+		util::ProgramOptions::init(optionc, optionv);
+		LogManager::init();
+		Logger::showChannelPrefix(false);
+
+		std::vector<std::string> filenames      = getProgramFiles(optionPrograms.as<std::string>());
+		std::vector<std::string> configurations = getConfigurations();
+
+		if (configurations.empty())
+			UTIL_THROW_EXCEPTION(
+					NoSolverException,
+					"no solver backend configurations given, and no backends available");
+
+		boost::shared_ptr<std::ofstream> resultFile;
+		if (optionResultFile)
+			resultFile = boost::make_shared<std::ofstream>(optionResultFile.as<std::string>().c_str(), std::ofstream::app);
+
+		LOG_USER(out)
+				<< "program\tvariables\tconstraints\tnon-zeros\tconfiguration\tstatus\tobjective\tbound\tgap\tnodes\t"
+				<< "upload [s]\tsolve [s]" << std::endl;
+
+		foreach (const std::string& filename, filenames) {
+
+			LinearProgram program;
+			program.read(filename);
+
+			// the optimal values of all configurations have to agree
+			bool   haveOptimum = false;
+			double optimum     = 0;
+
+			foreach (const std::string& configuration, configurations) {
+
+				ReplayResult result = replay(filename, program, configuration, resultFile.get());
+
+				// without statistics, take the solution of the backend as
+				// its optimum
+				if (!result.solved || (result.statistics.available && !result.statistics.optimal))
+					continue;
+
+				if (haveOptimum && std::abs(result.value - optimum) > 1e-6*std::max(1.0, std::abs(optimum)))
+					LOG_ERROR(out)
+							<< filename << ": optimal value " << result.value << " of " << configuration
+							<< " differs from " << optimum << std::endl;
+
+				if (!haveOptimum) {
+
+					haveOptimum = true;
+					optimum     = result.value;
+				}
+			}
+		}
+
+	} catch (Exception& e) {
+
+		handleException(e, std::cerr);
+		return 1;
+	}
+}
@@ -0,0 +1,298 @@
+/**
+ * Creates a synthetic ground truth and reconstruction of any size, with
+ * injected errors of known TED counts, for scaling benchmarks and regression
+ * tests of ted. The volumes are written one section at a time, as
+ * directories of images or as HDF5 datasets (given as "file:dataset"), and
+ * never have to fit into memory.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <vigra/impex.hxx>
+#include <imageprocessing/Image.h>
+#include <evaluation/SyntheticSegmentation.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#ifdef HAVE_HDF5
+#include <vigra/hdf5impex.hxx>
+#endif
+
+using namespace logger;
+
+util::ProgramOption optionGroundTruth(
+		util::_long_name        = "groundTruth",
+		util::_description_text = "Where to write the ground truth: a directory for one image per section, or an HDF5 dataset as "
+		                          "'file:dataset'.",
+		util::_default_value    = "groundtruth");
+
+util::ProgramOption optionReconstruction(
+		util::_long_name        = "reconstruction",
+		util::_description_text = "Where to write the reconstruction, like groundTruth.",
+		util::_default_value    = "reconstruction");
+
+util::ProgramOption optionExpectedErrors(
+		util::_long_name        = "expectedErrors",
+		util::_description_text = "Write the error counts the TED is expected to report, the injected and skipped errors, and the "
+		                          "parameters to this file as JSON.");
+
+util::ProgramOption optionWidth(
+		util::_long_name        = "width",
+		util::_description_text = "The width of the volumes in voxels.",
+		util::_default_value    = 512);
+
+util::ProgramOption optionHeight(
+		util::_long_name        = "height",
+		util::_description_text = "The height of the volumes in voxels.",
+		util::_default_value    = 512);
+
+util::ProgramOption optionDepth(
+		util::_long_name        = "depth",
+		util::_description_text = "The number of sections of the volumes.",
+		util::_default_value    = 512);
+
+util::ProgramOption optionResolutionX(
+		util::_long_name        = "resolutionX",
+		util::_description_text = "The size of a voxel in x in world units.",
+		util::_default_value    = 1.0);
+
+util::ProgramOption optionResolutionY(
+		util::_long_name        = "resolutionY",
+		util::_description_text = "The size of a voxel in y in world units.",
+		util::_default_value    = 1.0);
+
+util::ProgramOption optionResolutionZ(
+		util::_long_name        = "resolutionZ",
+		util::_description_text = "The size of a voxel in z in world units.",
+		util::_default_value    = 1.0);
+
+util::ProgramOption optionRegionSize(
+		util::_long_name        = "regionSize",
+		util::_description_text = "The average diameter of the ground truth regions in world units.",
+		util::_default_value    = 100.0);
+
+util::ProgramOption optionJitter(
+		util::_long_name        = "jitter",
+		util::_description_text = "How irregular the regions are, between 0 (cubes) and 0.2.",
+		util::_default_value    = 0.1);
+
+util::ProgramOption optionSplitRate(
+		util::_long_name        = "splitRate",
+		util::_description_text = "The fraction of eligible regions (every second along each axis) to split.",
+		util::_default_value    = 0.2);
+
+util::ProgramOption optionMergeRate(
+		util::_long_name        = "mergeRate",
+		util::_description_text = "The fraction of eligible regions to merge with their neighbor in x.",
+		util::_default_value    = 0.2);
+
+util::ProgramOption optionInnerShiftRate(
+		util::_long_name        = "innerShiftRate",
+		util::_description_text = "The fraction of eligible regions to grow into their neighbor in x by innerShift, which the TED "
+		                          "tolerates.",
+		util::_default_value    = 0.2);
+
+util::ProgramOption optionOuterShiftRate(
+		util::_long_name        = "outerShiftRate",
+		util::_description_text = "The fraction of eligible regions to grow into their neighbor in x by outerShift, which the TED "
+		                          "counts as a split and a merge.",
+		util::_default_value    = 0.2);
+
+util::ProgramOption optionFalsePositiveRate(
+		util::_long_name        = "falsePositiveRate",
+		util::_description_text = "The fraction of eligible regions to make background in the ground truth. Evaluate with "
+		                          "haveBackgroundLabel, if this or falseNegativeRate is not zero.",
+		util::_default_value    = 0.1);
+
+util::ProgramOption optionFalseNegativeRate(
+		util::_long_name        = "falseNegativeRate",
+		util::_description_text = "The fraction of eligible regions to make background in the reconstruction.",
+		util::_default_value    = 0.1);
+
+util::ProgramOption optionInnerShift(
+		util::_long_name        = "innerShift",
+		util::_description_text = "The distance in world units of boundary shifts within maxBoundaryShift. The default (0) is half of "
+		                          "maxBoundaryShift.",
+		util::_default_value    = 0.0);
+
+util::ProgramOption optionOuterShift(
+		util::_long_name        = "outerShift",
+		util::_description_text = "The distance in world units of boundary shifts beyond maxBoundaryShift. The default (0) is "
+		                          "maxBoundaryShift plus three voxel diagonals, the least that is guaranteed to be beyond it.",
+		util::_default_value    = 0.0);
+
+util::ProgramOption optionSeed(
+		util::_long_name        = "seed",
+		util::_description_text = "The seed of the random regions and errors.",
+		util::_default_value    = 0);
+
+// defined in TedEngine.cpp
+extern util::ProgramOption optionToleranceDistanceThreshold;
+extern util::ProgramOption optionNumThreads;
+
+/**
+ * Writes the sections of a volume one at a time, either as images into a
+ * directory or into an HDF5 dataset (given as "file:dataset").
+ */
+class SectionWriter {
+
+public:
+
+	SectionWriter(std::string option, const SyntheticSegmentation::Parameters& parameters) :
+		_width(parameters.width),
+		_height(parameters.height) {
+
+		// hdf file given?
+		size_t sepPos = option.find_first_of(":");
+		if (sepPos != std::string::npos) {
+
+#ifdef HAVE_HDF5
+			_hdfFile = boost::make_shared<vigra::HDF5File>(option.substr(0, sepPos), vigra::HDF5File::Open);
+			_dataset = option.substr(sepPos + 1);
+
+			// chunks of parts of a section
+			_hdfFile->createDataset<3, float>(
+					_dataset,
+					vigra::Shape3(parameters.width, parameters.height, parameters.depth),
+					0.0f,
+					vigra::Shape3(std::min(parameters.width, 256u), std::min(parameters.height, 256u), 1));
+
+			vigra::MultiArray<1, float> resolution(3);
+			resolution[0] = parameters.resolutionX;
+			resolution[1] = parameters.resolutionY;
+			resolution[2] = parameters.resolutionZ;
+			_hdfFile->writeAttribute(_dataset, "resolution", resolution);
+#else
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"This build does not support writing HDF5 files. Set CMake variable BUILD_WITH_HDF5 and recompile.");
+#endif
+
+		// write images into directory
+		} else {
+
+			_directory = option;
+			boost::filesystem::create_directories(_directory);
+
+			// the resolution, as read by ted
+			std::ofstream meta((_directory/"META").string().c_str());
+			meta
+					<< "resX=" << parameters.resolutionX << std::endl
+					<< "resY=" << parameters.resolutionY << std::endl
+					<< "resZ=" << parameters.resolutionZ << std::endl;
+		}
+	}
+
+	/**
+	 * Write section z.
+	 */
+	void write(unsigned int z, const Image& section) {
+
+#ifdef HAVE_HDF5
+		if (_hdfFile) {
+
+			vigra::MultiArray<3, float> block(vigra::Shape3(_width, _height, 1));
+			block.bind<2>(0) = section;
+
+			_hdfFile->writeBlock(_dataset, vigra::Shape3(0, 0, z), block);
+			return;
+		}
+#endif
+
+		// zero padded, such that the files sort by section
+		std::ostringstream filename;
+		filename << "section_" << std::setw(8) << std::setfill('0') << z << ".tif";
+
+		vigra::exportImage(
+				vigra::srcImageRange(section),
+				vigra::ImageExportInfo((_directory/filename.str()).string().c_str()).setPixelType("FLOAT"));
+	}
+
+private:
+
+	boost::filesystem::path _directory;
+
+#ifdef HAVE_HDF5
+	boost::shared_ptr<vigra::HDF5File> _hdfFile;
+	std::string _dataset;
+#endif
+
+	unsigned int _width, _height;
+};
+
+int main(int optionc, char** optionv) {
+
+	try {
+
+		util::ProgramOptions::init(optionc, optionv);
+		LogManager::init();
+		Logger::showChannelPrefix(false);
+
+		SyntheticSegmentation::Parameters parameters;
+		parameters.width            = optionWidth.as<unsigned int>();
+		parameters.height           = optionHeight.as<unsigned int>();
+		parameters.depth            = optionDepth.as<unsigned int>();
+		parameters.resolutionX      = optionResolutionX.as<float>();
+		parameters.resolutionY      = optionResolutionY.as<float>();
+		parameters.resolutionZ      = optionResolutionZ.as<float>();
+		parameters.regionSize       = optionRegionSize.as<float>();
+		parameters.jitter           = optionJitter.as<float>();
+		parameters.maxBoundaryShift = optionToleranceDistanceThreshold.as<float>();
+		parameters.innerShift       = optionInnerShift.as<float>();
+		parameters.outerShift       = optionOuterShift.as<float>();
+		parameters.seed             = optionSeed.as<unsigned int>();
+
+		parameters.rates[SyntheticSegmentation::Split]         = optionSplitRate.as<double>();
+		parameters.rates[SyntheticSegmentation::Merge]         = optionMergeRate.as<double>();
+		parameters.rates[SyntheticSegmentation::InnerShift]    = optionInnerShiftRate.as<double>();
+		parameters.rates[SyntheticSegmentation::OuterShift]    = optionOuterShiftRate.as<double>();
+		parameters.rates[SyntheticSegmentation::FalsePositive] = optionFalsePositiveRate.as<double>();
+		parameters.rates[SyntheticSegmentation::FalseNegative] = optionFalseNegativeRate.as<double>();
+
+		SyntheticSegmentation segmentation(parameters);
+
+		SectionWriter groundTruthWriter(optionGroundTruth, parameters);
+		SectionWriter reconstructionWriter(optionReconstruction, parameters);
+
+		Image groundTruth(parameters.width, parameters.height);
+		Image reconstruction(parameters.width, parameters.height);
+
+		for (unsigned int z = 0; z < parameters.depth; z++) {
+
+			LOG_DEBUG(out) << "[main] creating section " << z << std::endl;
+
+			segmentation.createSection(z, groundTruth, reconstruction, optionNumThreads.as<unsigned int>());
+
+			groundTruthWriter.write(z, groundTruth);
+			reconstructionWriter.write(z, reconstruction);
+		}
+
+		LOG_USER(out)
+				<< "created " << segmentation.getNumRegions() << " regions, expected TED errors: "
+				<< segmentation.getExpectedSplits() << " splits, "
+				<< segmentation.getExpectedMerges() << " merges, "
+				<< segmentation.getExpectedFalsePositives() << " false positives, "
+				<< segmentation.getExpectedFalseNegatives() << " false negatives" << std::endl;
+
+		for (int type = SyntheticSegmentation::Split; type < SyntheticSegmentation::NumErrorTypes; type++)
+			if (segmentation.getNumSkipped(SyntheticSegmentation::ErrorType(type)) > 0)
+				LOG_USER(out)
+						<< "skipped " << segmentation.getNumSkipped(SyntheticSegmentation::ErrorType(type)) << " "
+						<< SyntheticSegmentation::getErrorName(SyntheticSegmentation::ErrorType(type))
+						<< " errors, for which the regions are too small" << std::endl;
+
+		if (optionExpectedErrors) {
+
+			std::ofstream f(optionExpectedErrors.as<std::string>().c_str());
+			segmentation.writeJson(f);
+		}
+
+	} catch (Exception& e) {
+
+		handleException(e, std::cerr);
+		return 1;
+	}
+}
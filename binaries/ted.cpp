@@ -4,16 +4,27 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <sstream>
+#include <imageprocessing/io/ImageFileReader.h>
 #include <imageprocessing/io/ImageStackDirectoryReader.h>
 #include <imageprocessing/io/ImageStackDirectoryWriter.h>
 #include <pipeline/Process.h>
 #include <pipeline/Value.h>
+#include <evaluation/ContingencyTable.h>
 #include <evaluation/ErrorReport.h>
 #include <evaluation/ExtractGroundTruthLabels.h>
+#include <evaluation/StageMetrics.h>
+#include <evaluation/SparseBlockVolume.h>
+#include <evaluation/SwcReader.h>
+#include <evaluation/TolerantEditDistance.h>
 #include <evaluation/TolerantEditDistanceErrorsWriter.h>
 #include <util/ProgramOptions.h>
 #include <util/Logger.h>
 #include <boost/filesystem.hpp>
+#include <vigra/impex.hxx>
 #ifdef HAVE_HDF5
 #include <vigra/hdf5impex.hxx>
 #endif
@@ -25,6 +36,11 @@ util::ProgramOption optionGroundTruth(
 		util::_description_text = "The ground truth image stack.",
 		util::_default_value    = "groundtruth");
 
+util::ProgramOption optionGroundTruthSkeletons(
+		util::_long_name        = "groundTruthSkeletons",
+		util::_description_text = "An SWC file or a directory of SWC files with ground truth skeletons, to be used instead of groundTruth. "
+		                          "Only the TED is computed, with cells and alternative labels only in the vicinity of the skeletons.");
+
 util::ProgramOption optionExtractGroundTruthLabels(
 		util::_long_name        = "extractGroundTruthLabels",
 		util::_description_text = "Indicate that the ground truth consists of a foreground/background labeling "
@@ -52,6 +68,48 @@ util::ProgramOption optionTedErrorFiles(
 		util::_description_text = "Folder where to create files splits.dat and merges.dat (with background label als fps.dat and fns.dat)"
 		                          "which report which label got split/merged into which.");
 
+util::ProgramOption optionTedMetricsFile(
+		util::_long_name        = "tedMetricsFile",
+		util::_description_text = "Write the time, peak memory growth, and item counts of the stages of reading the volumes and "
+		                          "computing the TED as JSON to the given file.");
+
+util::ProgramOption optionStreamVoiRand(
+		util::_long_name        = "streamVoiRand",
+		util::_description_text = "Compute VOI and RAND section by section, without loading the ground truth and reconstruction "
+		                          "into memory. TED and detection overlap are not computed in this mode.");
+
+util::ProgramOption optionVoiRandSamples(
+		util::_long_name        = "voiRandSamples",
+		util::_description_text = "Estimate VOI and RAND from this many sampled locations, and report 95% confidence intervals. "
+		                          "If voiRandTargetError is given, this is the sample size of the first round.");
+
+util::ProgramOption optionVoiRandTargetError(
+		util::_long_name        = "voiRandTargetError",
+		util::_description_text = "Estimate VOI and RAND from a sample of locations, doubling the sample size until the margin of "
+		                          "the 95% confidence interval of the VOI and ARAND is below this value.");
+
+util::ProgramOption optionVoiRandSampleSeed(
+		util::_long_name        = "voiRandSampleSeed",
+		util::_description_text = "The seed for sampling locations with voiRandSamples or voiRandTargetError.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionTedSampleSize(
+		util::_long_name        = "tedSampleSize",
+		util::_description_text = "Estimate the TED from this many randomly drawn ground truth and reconstruction labels, instead "
+		                          "of computing it for the whole volume. Reports 95% confidence intervals.");
+
+util::ProgramOption optionTedSampleSeed(
+		util::_long_name        = "tedSampleSeed",
+		util::_description_text = "The seed for drawing labels with tedSampleSize.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionSparseBlockSize(
+		util::_long_name        = "sparseBlockSize",
+		util::_description_text = "Read the volumes one slab of this many sections at a time into sparse volumes with blocks of "
+		                          "this size, and compute VOI and RAND on them, counting blocks with a single label at once. "
+		                          "Memory is bounded by one slab and the number of label pairs. TED and detection overlap are "
+		                          "not computed in this mode.");
+
 util::ProgramOption optionReportVoi(
 		util::_module           = "evaluation",
 		util::_long_name        = "reportVoi",
@@ -84,6 +142,15 @@ util::ProgramOption optionGrowSlices(
 		util::_long_name        = "growSlices",
 		util::_description_text = "For the computation of VOI and RAND, grow the reconstruction slices until no background label is present anymore.");
 
+/**
+ * Write stage metrics to the file given by optionTedMetricsFile.
+ */
+void writeMetrics(const StageMetrics& metrics) {
+
+	std::ofstream f(optionTedMetricsFile.as<std::string>());
+	metrics.writeJson(f);
+}
+
 std::string buildCorrectedPath(std::string root, std::string reconstructionPath) {
 	boost::filesystem::path reconstruction = reconstructionPath;
 	std::string folderName = "corrected_" + reconstruction.stem().string();
@@ -152,6 +219,305 @@ void readImageStackFromOption(ImageStack& stack, std::string option) {
 	}
 }
 
+/**
+ * Provides the sections of an image stack one at a time, either from a
+ * directory of images or from an HDF5 dataset (given as "file:dataset"). In a
+ * directory, only the files with an extension of an image format that vigra
+ * can import are sections, in the order of their names.
+ */
+class SectionReader {
+
+public:
+
+	SectionReader(std::string option) {
+
+		// hdf file given?
+		size_t sepPos = option.find_first_of(":");
+		if (sepPos != std::string::npos) {
+
+#ifdef HAVE_HDF5
+			_hdfFile = boost::make_shared<vigra::HDF5File>(option.substr(0, sepPos), vigra::HDF5File::OpenMode::ReadOnly);
+			_dataset = option.substr(sepPos + 1);
+
+			vigra::ArrayVector<hsize_t> shape = _hdfFile->getDatasetShape(_dataset);
+			if (shape.size() != 3)
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"dataset " << _dataset << " is not a volume");
+
+			_width  = shape[0];
+			_height = shape[1];
+			_depth  = shape[2];
+#else
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"This build does not support reading form HDF5 files. Set CMake variable BUILD_WITH_HDF5 and recompile.");
+#endif
+
+		// list images in directory
+		} else {
+
+			boost::filesystem::path directory(option);
+
+			if (!boost::filesystem::is_directory(directory))
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						directory << " is not a directory");
+
+			// the extensions of the image formats vigra can import
+			std::set<std::string> extensions;
+			std::istringstream    extensionList(vigra::impexListExtensions());
+			std::string           extension;
+			while (extensionList >> extension)
+				extensions.insert(extension);
+
+			boost::filesystem::directory_iterator i(directory), end;
+			for (; i != end; i++) {
+
+				if (!boost::filesystem::is_regular_file(*i))
+					continue;
+
+				extension = i->path().extension().string();
+				if (!extension.empty())
+					extension = extension.substr(1);
+				std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+				if (extensions.count(extension))
+					_files.push_back(i->path().string());
+				else
+					LOG_DEBUG(out) << "[main] skipping " << i->path() << ", it is not an image" << std::endl;
+			}
+
+			std::sort(_files.begin(), _files.end());
+
+			_depth = _files.size();
+		}
+	}
+
+	/**
+	 * The number of sections in the stack.
+	 */
+	unsigned int size() const { return _depth; }
+
+	/**
+	 * Read section z.
+	 */
+	boost::shared_ptr<Image> read(unsigned int z) {
+
+#ifdef HAVE_HDF5
+		if (_hdfFile) {
+
+			vigra::MultiArray<3, float> section(vigra::Shape3(_width, _height, 1));
+			vigra::Shape3 offset(0, 0, z);
+			vigra::Shape3 shape(_width, _height, 1);
+
+			_hdfFile->readBlock(_dataset, offset, shape, section);
+
+			boost::shared_ptr<Image> image = boost::make_shared<Image>(_width, _height);
+			vigra::MultiArrayView<2, float> imageView = *image;
+			imageView = section.bind<2>(0);
+
+			return image;
+		}
+#endif
+
+		pipeline::Process<ImageFileReader> reader(_files[z]);
+		pipeline::Value<Image> image = reader->getOutput();
+
+		return image;
+	}
+
+private:
+
+	std::vector<std::string> _files;
+
+#ifdef HAVE_HDF5
+	boost::shared_ptr<vigra::HDF5File> _hdfFile;
+	std::string _dataset;
+#endif
+
+	unsigned int _width, _height, _depth;
+};
+
+/**
+ * Read the given number of sections of an image stack, starting at section
+ * begin, into a sparse block volume. The blocks are compressed as soon as
+ * their last section is read.
+ */
+boost::shared_ptr<SparseBlockVolume>
+readSparseBlockSlab(SectionReader& reader, unsigned int begin, unsigned int depth, unsigned int blockSize) {
+
+	boost::shared_ptr<Image> section = reader.read(begin);
+
+	boost::shared_ptr<SparseBlockVolume> slab =
+			boost::make_shared<SparseBlockVolume>(section->width(), section->height(), depth, 0, blockSize);
+
+	for (unsigned int z = 0; z < depth; z++) {
+
+		if (z > 0)
+			section = reader.read(begin + z);
+
+		slab->setSection(z, *section);
+	}
+
+	return slab;
+}
+
+/**
+ * Compute VOI and RAND reading one pair of ground truth and reconstruction
+ * sections at a time. Memory is bounded by the number of label pairs, not the
+ * size of the volumes. With option sparseBlockSize, one slab of sections as
+ * deep as the blocks is read into sparse block volumes at a time, and their
+ * blocks are counted instead.
+ */
+void streamVoiRand(const ErrorReport::Parameters& parameters) {
+
+	SectionReader groundTruth(optionGroundTruth);
+	SectionReader reconstruction(optionReconstruction);
+
+	if (groundTruth.size() != reconstruction.size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("ground truth and reconstruction have different size") << STACK_TRACE);
+
+	ContingencyTable table(parameters.ignoreBackground);
+
+	if (optionSparseBlockSize) {
+
+		unsigned int blockSize = optionSparseBlockSize.as<unsigned int>();
+
+		if (blockSize == 0)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"the sparse block size has to be positive");
+
+		size_t numBlocks         = 0;
+		size_t numConstantBlocks = 0;
+
+		for (unsigned int begin = 0; begin < groundTruth.size(); begin += blockSize) {
+
+			unsigned int depth = std::min(blockSize, groundTruth.size() - begin);
+
+			LOG_DEBUG(out) << "[main] counting sections " << begin << " to " << (begin + depth - 1) << " in blocks" << std::endl;
+
+			boost::shared_ptr<SparseBlockVolume> gt  = readSparseBlockSlab(groundTruth, begin, depth, blockSize);
+			boost::shared_ptr<SparseBlockVolume> rec = readSparseBlockSlab(reconstruction, begin, depth, blockSize);
+
+			table.add(*rec, *gt);
+
+			numBlocks         += gt->getNumBlocks() + rec->getNumBlocks();
+			numConstantBlocks += gt->getNumConstantBlocks() + rec->getNumConstantBlocks();
+		}
+
+		LOG_DEBUG(out) << "[main] " << numConstantBlocks << " of " << numBlocks << " blocks were constant" << std::endl;
+
+	} else {
+
+		for (unsigned int z = 0; z < groundTruth.size(); z++) {
+
+			LOG_DEBUG(out) << "[main] counting section " << z << std::endl;
+
+			boost::shared_ptr<Image> gt  = groundTruth.read(z);
+			boost::shared_ptr<Image> rec = reconstruction.read(z);
+
+			table.add(*rec, *gt);
+		}
+	}
+
+	// assemble the report in the same way ErrorReport does
+
+	std::vector<boost::shared_ptr<Errors> > errors;
+
+	if (parameters.reportVoi) {
+
+		boost::shared_ptr<VariationOfInformationErrors> voiErrors = boost::make_shared<VariationOfInformationErrors>();
+		table.computeVariationOfInformation(*voiErrors);
+		errors.push_back(voiErrors);
+	}
+
+	if (parameters.reportRand) {
+
+		boost::shared_ptr<RandIndexErrors> randErrors = boost::make_shared<RandIndexErrors>();
+		table.computeRandIndex(*randErrors);
+		errors.push_back(randErrors);
+	}
+
+	std::string report;
+	std::string humanReadableReport;
+
+	foreach (boost::shared_ptr<Errors> e, errors) {
+
+		if (!report.empty())
+			report += "\t";
+
+		if (!humanReadableReport.empty())
+			humanReadableReport += "; ";
+
+		report              += e->errorString();
+		humanReadableReport += e->humanReadableErrorString();
+	}
+
+	LOG_USER(out) << humanReadableReport << std::endl;
+
+	if (optionPlotFile) {
+
+		std::ofstream f(optionPlotFile.as<std::string>(), std::ofstream::app);
+		f << report << std::endl;
+	}
+}
+
+// defined in TedEngine.cpp
+extern util::ProgramOption optionGroundTruthBackgroundLabel;
+
+/**
+ * Compute the TED between skeleton graphs and a reconstruction, without
+ * rasterizing the skeletons into a volume.
+ */
+void evaluateSkeletons(const ErrorReport::Parameters& parameters) {
+
+	pipeline::Process<TolerantEditDistance> ted(parameters.headerOnly, true /* skeleton graphs */);
+
+	if (parameters.headerOnly) {
+
+		pipeline::Value<TolerantEditDistanceErrors> errors = ted->getOutput("errors");
+
+		std::ofstream f(optionPlotFile.as<std::string>(), std::ofstream::app);
+		f << errors->errorHeader() << std::endl;
+		return;
+	}
+
+	pipeline::Process<SwcReader> skeletonReader(
+			optionGroundTruthSkeletons.as<std::string>(),
+			optionGroundTruthBackgroundLabel.as<float>());
+
+	StageMetrics metrics;
+
+	StageMetrics::Timer readTimer(&metrics, "read reconstruction");
+	pipeline::Value<ImageStack> reconstruction;
+	readImageStackFromOption(*reconstruction, optionReconstruction);
+	readTimer.addCount("sections", reconstruction->size());
+	readTimer.stop();
+
+	ted->setInput("skeletons", skeletonReader->getOutput("skeletons"));
+	ted->setInput("reconstruction", reconstruction);
+
+	pipeline::Value<TolerantEditDistanceErrors> errors = ted->getOutput("errors");
+
+	LOG_USER(out) << errors->humanReadableErrorString() << std::endl;
+
+	if (optionPlotFile) {
+
+		std::ofstream f(optionPlotFile.as<std::string>(), std::ofstream::app);
+		f << errors->errorString() << std::endl;
+	}
+
+	if (optionTedMetricsFile) {
+
+		pipeline::Value<StageMetrics> tedMetrics = ted->getOutput("metrics");
+		metrics.add(*tedMetrics);
+
+		writeMetrics(metrics);
+	}
+}
+
 int main(int optionc, char** optionv) {
 
 	try {
@@ -182,6 +548,44 @@ int main(int optionc, char** optionv) {
 		parameters.ignoreBackground = optionIgnoreBackground.as<bool>();
 		parameters.growSlices = optionGrowSlices.as<bool>();
 
+		if (optionVoiRandSamples)
+			parameters.voiRandSampling.numSamples = optionVoiRandSamples.as<size_t>();
+		if (optionVoiRandTargetError)
+			parameters.voiRandSampling.targetError = optionVoiRandTargetError.as<double>();
+		parameters.voiRandSampling.seed = optionVoiRandSampleSeed.as<unsigned int>();
+
+		if (optionTedSampleSize)
+			parameters.tedSampleSize = optionTedSampleSize.as<unsigned int>();
+		parameters.tedSampleSeed = optionTedSampleSeed.as<unsigned int>();
+
+		if (parameters.tedSampleSize > 0 && optionTedErrorFiles)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"option tedErrorFiles can not be used with tedSampleSize");
+
+		if (optionStreamVoiRand || optionSparseBlockSize) {
+
+			if (optionExtractGroundTruthLabels || parameters.growSlices || parameters.voiRandSampling.enabled())
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"options extractGroundTruthLabels, growSlices, and VOI/RAND sampling can not be used with streamVoiRand or sparseBlockSize");
+
+			parameters.reportTed = false;
+			parameters.reportDetectionOverlap = false;
+		}
+
+		if (optionGroundTruthSkeletons) {
+
+			if (optionExtractGroundTruthLabels || optionStreamVoiRand || optionSparseBlockSize || parameters.tedSampleSize > 0 || optionTedErrorFiles)
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"options extractGroundTruthLabels, streamVoiRand, sparseBlockSize, tedSampleSize, and tedErrorFiles can not be used with "
+						"groundTruthSkeletons");
+
+			evaluateSkeletons(parameters);
+			return 0;
+		}
+
 		pipeline::Process<ErrorReport> report(parameters);
 
 		if (optionPlotFileHeader) {
@@ -193,13 +597,28 @@ int main(int optionc, char** optionv) {
 			return 0;
 		}
 
+		if (optionStreamVoiRand || optionSparseBlockSize) {
+
+			streamVoiRand(parameters);
+			return 0;
+		}
+
 		// setup file readers and writers
 
 		pipeline::Value<ImageStack> groundTruth;
 		pipeline::Value<ImageStack> reconstruction;
 
+		StageMetrics metrics;
+
+		StageMetrics::Timer readGroundTruthTimer(&metrics, "read ground truth");
 		readImageStackFromOption(*groundTruth, optionGroundTruth);
+		readGroundTruthTimer.addCount("sections", groundTruth->size());
+		readGroundTruthTimer.stop();
+
+		StageMetrics::Timer readReconstructionTimer(&metrics, "read reconstruction");
 		readImageStackFromOption(*reconstruction, optionReconstruction);
+		readReconstructionTimer.addCount("sections", reconstruction->size());
+		readReconstructionTimer.stop();
 
 		report->setInput("reconstruction", reconstruction);
 
@@ -279,6 +698,17 @@ int main(int optionc, char** optionv) {
 
 		}
 
+		if (optionTedMetricsFile) {
+
+			if (parameters.reportTed && parameters.tedSampleSize == 0) {
+
+				pipeline::Value<StageMetrics> tedMetrics = report->getOutput("ted metrics");
+				metrics.add(*tedMetrics);
+			}
+
+			writeMetrics(metrics);
+		}
+
 	} catch (Exception& e) {
 
 		handleException(e, std::cerr);
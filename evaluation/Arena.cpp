@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <new>
+#include "Arena.h"
+
+Arena::Arena(size_t blockSize) :
+	_current(0),
+	_next(0),
+	_end(0),
+	_blockSize(blockSize),
+	_capacity(0) {}
+
+Arena::~Arena() {
+
+	for (unsigned int i = 0; i < _blocks.size(); i++)
+		::operator delete(_blocks[i].begin);
+}
+
+void
+Arena::reset() {
+
+	_current = 0;
+
+	if (_blocks.empty()) {
+
+		_next = _end = 0;
+		return;
+	}
+
+	_next = _blocks[0].begin;
+	_end  = _blocks[0].begin + _blocks[0].size;
+}
+
+void*
+Arena::allocateFromNextBlock(size_t size, size_t alignment) {
+
+	// the worst case size including the alignment
+	size_t needed = size + alignment;
+
+	// continue with the next kept block that is large enough
+	if (!_blocks.empty())
+		for (_current++; _current < _blocks.size(); _current++)
+			if (_blocks[_current].size >= needed)
+				break;
+
+	if (_current >= _blocks.size()) {
+
+		Block block;
+		block.size  = std::max(_blockSize, needed);
+		block.begin = static_cast<char*>(::operator new(block.size));
+
+		_blocks.push_back(block);
+		_current = _blocks.size() - 1;
+
+		_capacity += block.size;
+
+		if (_blockSize < MaxBlockSize)
+			_blockSize *= 2;
+	}
+
+	_next = _blocks[_current].begin;
+	_end  = _blocks[_current].begin + _blocks[_current].size;
+
+	return allocate(size, alignment);
+}
+
@@ -0,0 +1,146 @@
+#ifndef TED_EVALUATION_ARENA_H__
+#define TED_EVALUATION_ARENA_H__
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <scoped_allocator>
+#include <set>
+#include <vector>
+
+/**
+ * A monotonic memory arena for the many small objects of one evaluation, like
+ * the nodes of the label maps. Allocations are served from large blocks and
+ * are never freed individually. Instead, reset() releases everything at once
+ * and keeps the blocks for the next evaluation.
+ *
+ * An arena is not thread safe, each evaluator owns its own.
+ */
+class Arena {
+
+public:
+
+	/**
+	 * Create an arena that allocates blocks of at least the given size.
+	 */
+	Arena(size_t blockSize = 64*1024);
+
+	~Arena();
+
+	/**
+	 * Get memory for size bytes with the given alignment.
+	 */
+	void* allocate(size_t size, size_t alignment) {
+
+		char* p = align(_next, alignment);
+
+		if (p + size > _end)
+			return allocateFromNextBlock(size, alignment);
+
+		_next = p + size;
+		return p;
+	}
+
+	/**
+	 * Release all allocations. All objects in the arena have to be destructed
+	 * before. The blocks are kept for reuse.
+	 */
+	void reset();
+
+	/**
+	 * The number of bytes in all blocks of this arena.
+	 */
+	size_t getCapacity() const { return _capacity; }
+
+private:
+
+	// the block size is not doubled beyond this
+	static const size_t MaxBlockSize = 64*1024*1024;
+
+	struct Block {
+
+		char*  begin;
+		size_t size;
+	};
+
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+	static char* align(char* p, size_t alignment) {
+
+		size_t offset = reinterpret_cast<size_t>(p)%alignment;
+
+		return (offset == 0 ? p : p + alignment - offset);
+	}
+
+	void* allocateFromNextBlock(size_t size, size_t alignment);
+
+	// all blocks, in the order in which they are used
+	std::vector<Block> _blocks;
+
+	// the block that is currently used
+	size_t _current;
+
+	// the free part of the current block
+	char* _next;
+	char* _end;
+
+	// the size of the next block to create, doubled for each new block
+	size_t _blockSize;
+
+	size_t _capacity;
+};
+
+/**
+ * An STL allocator that takes its memory from an Arena. Deallocations are
+ * ignored, the memory is released with Arena::reset().
+ */
+template <typename T>
+class ArenaAllocator {
+
+public:
+
+	typedef T value_type;
+
+	ArenaAllocator(Arena& arena) :
+		_arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+		_arena(other.getArena()) {}
+
+	T* allocate(size_t n) {
+
+		return static_cast<T*>(_arena->allocate(n*sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	Arena* getArena() const { return _arena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return _arena == other.getArena(); }
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return _arena != other.getArena(); }
+
+private:
+
+	Arena* _arena;
+};
+
+/**
+ * Containers in an arena. Maps pass their arena on to the containers they
+ * hold, such that nested containers are in the same arena.
+ */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+template <typename T>
+using ArenaSet = std::set<T, std::less<T>, ArenaAllocator<T> >;
+
+template <typename K, typename V>
+using ArenaMap = std::map<K, V, std::less<K>, std::scoped_allocator_adaptor<ArenaAllocator<std::pair<const K, V> > > >;
+
+#endif // TED_EVALUATION_ARENA_H__
+
@@ -1,7 +1,10 @@
 #ifndef TED_EVALUATION_CELL_H__
 #define TED_EVALUATION_CELL_H__
 
+#include <algorithm>
 #include <set>
+#include <vector>
+#include <cstddef>
 
 /**
  * A cell is a set of connected locations build by intersecting a connected 
@@ -95,14 +98,50 @@ public:
 		return _alternativeLabels;
 	}
 
+	Cell() :
+		_size(0),
+		_min(0, 0, 0),
+		_max(0, 0, 0) {}
+
+	/**
+	 * Reserve memory for the given number of locations, if it is known in 
+	 * advance.
+	 */
+	void reserve(size_t size) {
+
+		_content.reserve(size);
+	}
+
 	/**
 	 * Add a location to this cell.
 	 */
 	void add(const Location& l) {
 
+		extend(l);
+
 		_content.push_back(l);
 	}
 
+	/**
+	 * Count a location for the size and bounding box of this cell, without 
+	 * storing it. Used for cells whose locations are not needed.
+	 */
+	void extend(const Location& l) {
+
+		if (_size == 0) {
+
+			_min = _max = l;
+
+		} else {
+
+			_min.x = std::min(_min.x, l.x); _max.x = std::max(_max.x, l.x);
+			_min.y = std::min(_min.y, l.y); _max.y = std::max(_max.y, l.y);
+			_min.z = std::min(_min.z, l.z); _max.z = std::max(_max.z, l.z);
+		}
+
+		_size++;
+	}
+
 	/**
 	 * Add a boundary location to this cell.
 	 */
@@ -124,6 +163,8 @@ public:
 		else
 			return false;
 
+		_size--;
+
 		return true;
 	}
 
@@ -140,11 +181,30 @@ public:
 	}
 
 	/**
-	 * Get the number of locations in this cell.
+	 * Get the number of locations in this cell, including the ones that were 
+	 * only counted with extend().
+	 */
+	size_t size() const {
+
+		return _size;
+	}
+
+	/**
+	 * Get the inclusive lower corner of the bounding box of all locations that 
+	 * have been added to this cell.
 	 */
-	unsigned int size() const {
+	const Location& getBoundingBoxMin() const {
 
-		return _content.size();
+		return _min;
+	}
+
+	/**
+	 * Get the inclusive upper corner of the bounding box of all locations that 
+	 * have been added to this cell.
+	 */
+	const Location& getBoundingBoxMax() const {
+
+		return _max;
 	}
 
 	const std::vector<Location>& getBoundary() const {
@@ -178,8 +238,15 @@ private:
 	// the volume locations that constitute this cell
 	std::vector<Location> _content;
 
+	// the number of locations, stored or not
+	size_t _size;
+
 	// the locations that are forming the boundary
 	std::vector<Location> _boundary;
+
+	// the bounding box of the content
+	Location _min;
+	Location _max;
 };
 
 #endif // TED_EVALUATION_CELL_H__
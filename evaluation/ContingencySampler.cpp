@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cmath>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "ContingencySampler.h"
+
+logger::LogChannel contingencysamplerlog("contingencysamplerlog", "[ContingencySampler] ");
+
+// number of samples of the first round, if only a target error is given
+static const size_t DefaultNumSamples = 100000;
+
+// two-sided 95% quantile of the normal distribution
+static const double Z95 = 1.96;
+
+ContingencySampler::ContingencySampler(const Parameters& parameters, bool ignoreBackground) :
+	_parameters(parameters),
+	_ignoreBackground(ignoreBackground),
+	_random(parameters.seed) {
+
+	if (_parameters.numGroups < 2)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"at least two replicate groups are needed to estimate a confidence interval");
+}
+
+void
+ContingencySampler::estimateVariationOfInformation(
+		const ImageStack& reconstruction,
+		const ImageStack& groundTruth,
+		VariationOfInformationErrors& errors) {
+
+	std::vector<double> estimates;
+	std::vector<double> margins;
+	double              countedFraction;
+
+	size_t numSamples = estimate(reconstruction, groundTruth, &ContingencySampler::voiStatistics, estimates, margins, countedFraction);
+
+	if (numSamples == 0) {
+
+		ContingencyTable table(_ignoreBackground);
+		table.add(reconstruction, groundTruth);
+
+		table.computeVariationOfInformation(errors);
+		errors.setMargins(0, 0, 0);
+		errors.setNumSamples(0);
+
+		return;
+	}
+
+	errors.setSplitEntropy(estimates[0]);
+	errors.setMergeEntropy(estimates[1]);
+	errors.setMargins(margins[0], margins[1], margins[2]);
+	errors.setNumSamples(numSamples);
+}
+
+void
+ContingencySampler::estimateRandIndex(
+		const ImageStack& reconstruction,
+		const ImageStack& groundTruth,
+		RandIndexErrors& errors) {
+
+	std::vector<double> estimates;
+	std::vector<double> margins;
+	double              countedFraction;
+
+	size_t numSamples = estimate(reconstruction, groundTruth, &ContingencySampler::randStatistics, estimates, margins, countedFraction);
+
+	if (numSamples == 0) {
+
+		ContingencyTable table(_ignoreBackground);
+		table.add(reconstruction, groundTruth);
+
+		table.computeRandIndex(errors);
+		errors.setMargins(0, 0);
+		errors.setNumSamples(0);
+
+		return;
+	}
+
+	// the pairs of the counted locations, as in
+	// ContingencyTable::computeRandIndex(), where the number of counted
+	// locations is estimated from the sample as well if the background is
+	// ignored
+	double numLocations = countedFraction*groundTruth.width()*groundTruth.height()*groundTruth.size();
+	double numPairs     = (numLocations/2)*(numLocations - 1);
+
+	errors.setNumPairs(numPairs);
+	errors.setNumAggreeingPairs(estimates[0]*numPairs);
+	errors.setPrecision(estimates[1]);
+	errors.setRecall(estimates[2]);
+	errors.setAdaptedRandError(estimates[3]);
+	errors.setMargins(margins[0], margins[3]);
+	errors.setNumSamples(numSamples);
+}
+
+std::vector<double>
+ContingencySampler::voiStatistics(const ContingencyTable& table) {
+
+	VariationOfInformationErrors errors;
+	table.computeVariationOfInformation(errors);
+
+	std::vector<double> statistics(3);
+	statistics[0] = errors.getSplitEntropy();
+	statistics[1] = errors.getMergeEntropy();
+	statistics[2] = errors.getEntropy();
+
+	return statistics;
+}
+
+std::vector<double>
+ContingencySampler::randStatistics(const ContingencyTable& table) {
+
+	// Same as ContingencyTable::computeRandIndex(), but with the sums of
+	// squares replaced by the number of ordered pairs of distinct locations
+	// n*(n-1), which makes the pair counts unbiased for a sample.
+
+	double m = table.getNumLocations();
+
+	double sumJoint = 0;
+	double sumRec   = 0;
+	double sumGt    = 0;
+
+	ContingencyTable::LabelPair labels;
+	float                       label;
+	uint64_t                    n;
+
+	foreach (boost::tie(labels, n), table.getJointCounts())
+		sumJoint += static_cast<double>(n)*(n - 1.0);
+
+	foreach (boost::tie(label, n), table.getReconstructionCounts())
+		sumRec += static_cast<double>(n)*(n - 1.0);
+
+	foreach (boost::tie(label, n), table.getGroundTruthCounts())
+		sumGt += static_cast<double>(n)*(n - 1.0);
+
+	std::vector<double> statistics(4);
+
+	double numPairs = m*(m - 1.0);
+
+	if (numPairs == 0) {
+
+		statistics[0] = 1;
+		statistics[1] = 1;
+		statistics[2] = 1;
+		statistics[3] = 0;
+		return statistics;
+	}
+
+	double precision = (sumGt  > 0 ? sumJoint/sumGt  : 1.0);
+	double recall    = (sumRec > 0 ? sumJoint/sumRec : 1.0);
+	double fscore    = (precision + recall > 0 ? 2*(precision*recall)/(precision + recall) : 0.0);
+
+	statistics[0] = (numPairs - sumRec - sumGt + 2*sumJoint)/numPairs;
+	statistics[1] = precision;
+	statistics[2] = recall;
+	statistics[3] = 1.0 - fscore;
+
+	return statistics;
+}
+
+size_t
+ContingencySampler::estimate(
+		const ImageStack& reconstruction,
+		const ImageStack& groundTruth,
+		Statistics statistics,
+		std::vector<double>& estimates,
+		std::vector<double>& margins,
+		double& countedFraction) {
+
+	if (reconstruction.size() != groundTruth.size() ||
+	    reconstruction.width() != groundTruth.width() ||
+	    reconstruction.height() != groundTruth.height())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("image stacks have different size") << STACK_TRACE);
+
+	size_t numLocations = 0;
+	if (groundTruth.size() > 0)
+		numLocations = static_cast<size_t>(groundTruth.width())*groundTruth.height()*groundTruth.size();
+
+	size_t numSamples = (_parameters.numSamples > 0 ? _parameters.numSamples : DefaultNumSamples);
+	numSamples = std::max(numSamples, static_cast<size_t>(_parameters.numGroups));
+
+	while (true) {
+
+		// the sample would not be smaller than the volume, the caller counts
+		// exactly
+		if (numSamples >= numLocations) {
+
+			LOG_DEBUG(contingencysamplerlog) << "sample size exceeds volume size, counting all locations" << std::endl;
+			return 0;
+		}
+
+		std::vector<ContingencyTable> groups;
+		sample(reconstruction, groundTruth, numSamples, groups);
+
+		ContingencyTable all(_ignoreBackground);
+		foreach (const ContingencyTable& group, groups)
+			all.merge(group);
+
+		estimates       = statistics(all);
+		countedFraction = static_cast<double>(all.getNumLocations())/numSamples;
+
+		// delete-a-group jackknife
+
+		const unsigned int K = groups.size();
+
+		std::vector<std::vector<double> > partialEstimates;
+		for (unsigned int g = 0; g < K; g++) {
+
+			ContingencyTable partial(_ignoreBackground);
+			for (unsigned int h = 0; h < K; h++)
+				if (h != g)
+					partial.merge(groups[h]);
+
+			partialEstimates.push_back(statistics(partial));
+		}
+
+		margins.assign(estimates.size(), 0.0);
+
+		for (unsigned int s = 0; s < estimates.size(); s++) {
+
+			double mean = 0;
+			for (unsigned int g = 0; g < K; g++)
+				mean += partialEstimates[g][s];
+			mean /= K;
+
+			// the plug-in estimates (entropies, ratios of pair counts) are
+			// biased for small samples, the jackknife removes the leading
+			// 1/numSamples term of this bias
+			estimates[s] = K*estimates[s] - (K - 1)*mean;
+
+			double variance = 0;
+			for (unsigned int g = 0; g < K; g++)
+				variance += (partialEstimates[g][s] - mean)*(partialEstimates[g][s] - mean);
+			variance *= static_cast<double>(K - 1)/K;
+
+			margins[s] = Z95*std::sqrt(variance);
+		}
+
+		LOG_DEBUG(contingencysamplerlog)
+				<< "estimated from " << numSamples << " samples, margin of main statistic is "
+				<< margins.back() << std::endl;
+
+		if (_parameters.targetError <= 0 || margins.back() <= _parameters.targetError)
+			return numSamples;
+
+		numSamples *= 2;
+	}
+}
+
+void
+ContingencySampler::sample(
+		const ImageStack& reconstruction,
+		const ImageStack& groundTruth,
+		size_t numSamples,
+		std::vector<ContingencyTable>& groups) {
+
+	const unsigned int K = _parameters.numGroups;
+
+	const size_t width        = groundTruth.width();
+	const size_t sectionSize  = width*groundTruth.height();
+	const size_t numLocations = sectionSize*groundTruth.size();
+
+	groups.assign(K, ContingencyTable(_ignoreBackground));
+
+	for (unsigned int g = 0; g < K; g++) {
+
+		size_t groupSize = numSamples/K + (g < numSamples%K ? 1 : 0);
+
+		if (groupSize == 0)
+			continue;
+
+		// one location uniformly drawn from each of groupSize strata of equal
+		// size (a purely systematic sample would alias with periodic
+		// structures in the volume)
+		double step = static_cast<double>(numLocations)/groupSize;
+
+		std::uniform_real_distribution<double> offsetDistribution(0, step);
+
+		for (size_t k = 0; k < groupSize; k++) {
+
+			size_t i = std::min(numLocations - 1, static_cast<size_t>(k*step + offsetDistribution(_random)));
+
+			size_t z = i/sectionSize;
+			size_t y = (i%sectionSize)/width;
+			size_t x = i%width;
+
+			groups[g].add((*reconstruction[z])(x, y), (*groundTruth[z])(x, y));
+		}
+	}
+}
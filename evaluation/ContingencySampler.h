@@ -0,0 +1,128 @@
+#ifndef TED_EVALUATION_CONTINGENCY_SAMPLER_H__
+#define TED_EVALUATION_CONTINGENCY_SAMPLER_H__
+
+#include <vector>
+#include <random>
+#include <imageprocessing/ImageStack.h>
+#include "ContingencyTable.h"
+#include "VariationOfInformationErrors.h"
+#include "RandIndexErrors.h"
+
+/**
+ * Estimates VOI and RAND from a sample of locations, instead of counting every
+ * location of the volumes.
+ *
+ * The sample consists of a number of independent replicate groups. Each group
+ * is a stratified sample of the flattened volume, i.e., one location drawn
+ * from each of a number of equally sized consecutive strata. Leaving out one
+ * group at a time (delete-a-group jackknife) gives a bias-corrected estimate
+ * and its standard error, which is reported as the margin of a 95% confidence
+ * interval.
+ */
+class ContingencySampler {
+
+public:
+
+	struct Parameters {
+
+		Parameters() :
+			numSamples(0),
+			targetError(0),
+			numGroups(10),
+			seed(0) {}
+
+		/**
+		 * The number of locations to sample. If targetError is set, this is
+		 * the number of samples of the first round.
+		 */
+		size_t numSamples;
+
+		/**
+		 * If larger than zero, the number of samples is doubled until the
+		 * margin of the VOI or adapted RAND error is below this value.
+		 */
+		double targetError;
+
+		/**
+		 * The number of replicate groups to estimate the standard error from.
+		 */
+		unsigned int numGroups;
+
+		/**
+		 * The seed of the random starts of the systematic samples.
+		 */
+		unsigned int seed;
+
+		/**
+		 * True, if the errors should be estimated instead of computed exactly.
+		 */
+		bool enabled() const { return numSamples > 0 || targetError > 0; }
+	};
+
+	ContingencySampler(const Parameters& parameters, bool ignoreBackground = false);
+
+	/**
+	 * Estimate the split and merge entropies and their margins. If the sample
+	 * would not be smaller than the volume, the entropies are computed
+	 * exactly instead and reported with 0 samples.
+	 */
+	void estimateVariationOfInformation(
+			const ImageStack& reconstruction,
+			const ImageStack& groundTruth,
+			VariationOfInformationErrors& errors);
+
+	/**
+	 * Estimate the RAND index and the adapted RAND error and their margins. If
+	 * the sample would not be smaller than the volume, the errors are computed
+	 * exactly instead and reported with 0 samples. If the ground truth
+	 * background is ignored, the number of pairs is estimated from the
+	 * fraction of sampled locations that are not background.
+	 */
+	void estimateRandIndex(
+			const ImageStack& reconstruction,
+			const ImageStack& groundTruth,
+			RandIndexErrors& errors);
+
+private:
+
+	// computes a vector of statistics from a contingency table, the last one
+	// is compared against the target error
+	typedef std::vector<double> (*Statistics)(const ContingencyTable&);
+
+	static std::vector<double> voiStatistics(const ContingencyTable& table);
+	static std::vector<double> randStatistics(const ContingencyTable& table);
+
+	/**
+	 * Draw samples and estimate the given statistics. Returns the number of
+	 * samples that have been drawn in the last round, or 0 if the sample would
+	 * not be smaller than the volume and the errors should be computed
+	 * exactly. countedFraction is set to the fraction of the samples of the
+	 * last round that the contingency tables counted, i.e., that are not
+	 * ground truth background if it is ignored.
+	 */
+	size_t estimate(
+			const ImageStack& reconstruction,
+			const ImageStack& groundTruth,
+			Statistics statistics,
+			std::vector<double>& estimates,
+			std::vector<double>& margins,
+			double& countedFraction);
+
+	/**
+	 * Draw numSamples locations, split into the replicate groups.
+	 */
+	void sample(
+			const ImageStack& reconstruction,
+			const ImageStack& groundTruth,
+			size_t numSamples,
+			std::vector<ContingencyTable>& groups);
+
+	Parameters _parameters;
+
+	bool _ignoreBackground;
+
+	std::mt19937 _random;
+};
+
+#endif // TED_EVALUATION_CONTINGENCY_SAMPLER_H__
+
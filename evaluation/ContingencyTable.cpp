@@ -0,0 +1,378 @@
+#include <cmath>
+#include <cstring>
+#include <util/Logger.h>
+#include "ContingencyTable.h"
+
+logger::LogChannel contingencytablelog("contingencytablelog", "[ContingencyTable] ");
+
+// magic bytes and version of the binary representation
+static const char    BlobMagic[4]  = { 'T', 'E', 'D', 'C' };
+static const uint8_t BlobVersion   = 1;
+static const size_t  HeaderSize    = 4 + 1 + 1 + 8;
+static const size_t  EntrySize     = 4 + 4 + 8;
+
+// all numbers are stored little endian, independent of the host
+
+static void appendUint64(std::string& blob, uint64_t value) {
+
+	for (int i = 0; i < 8; i++)
+		blob.push_back(static_cast<char>((value >> (8*i)) & 0xff));
+}
+
+static void appendFloat(std::string& blob, float value) {
+
+	uint32_t bits;
+	std::memcpy(&bits, &value, 4);
+
+	for (int i = 0; i < 4; i++)
+		blob.push_back(static_cast<char>((bits >> (8*i)) & 0xff));
+}
+
+static uint64_t readUint64(const std::string& blob, size_t pos) {
+
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++)
+		value |= static_cast<uint64_t>(static_cast<unsigned char>(blob[pos + i])) << (8*i);
+
+	return value;
+}
+
+static float readFloat(const std::string& blob, size_t pos) {
+
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; i++)
+		bits |= static_cast<uint32_t>(static_cast<unsigned char>(blob[pos + i])) << (8*i);
+
+	float value;
+	std::memcpy(&value, &bits, 4);
+
+	return value;
+}
+
+ContingencyTable::ContingencyTable(bool ignoreBackground) :
+	_numLocations(0),
+	_ignoreBackground(ignoreBackground) {}
+
+void
+ContingencyTable::add(const ImageStack& reconstruction, const ImageStack& groundTruth) {
+
+	if (reconstruction.size() != groundTruth.size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("image stacks have different size") << STACK_TRACE);
+
+	ImageStack::const_iterator i1 = reconstruction.begin();
+	ImageStack::const_iterator i2 = groundTruth.begin();
+
+	for (; i1 != reconstruction.end(); i1++, i2++)
+		add(**i1, **i2);
+}
+
+void
+ContingencyTable::add(const Image& reconstruction, const Image& groundTruth) {
+
+	if (reconstruction.size() != groundTruth.size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("images have different size") << STACK_TRACE);
+
+	add(reconstruction.begin(), reconstruction.end(), groundTruth.begin());
+}
+
+void
+ContingencyTable::add(const SparseBlockVolume& reconstruction, const SparseBlockVolume& groundTruth) {
+
+	if (!reconstruction.hasSameLayout(groundTruth))
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("sparse volumes have different size or block size") << STACK_TRACE);
+
+	SparseBlockVolume::const_iterator rec = reconstruction.begin();
+	SparseBlockVolume::const_iterator gt  = groundTruth.begin();
+
+	for (; rec != reconstruction.end(); rec++, gt++) {
+
+		if (gt->isConstant()) {
+
+			if (_ignoreBackground && gt->getValue() == 0)
+				continue;
+
+			if (rec->isConstant()) {
+
+				add(rec->getValue(), gt->getValue(), rec->size());
+				continue;
+			}
+
+			add(rec->getValues().begin(), rec->getValues().end(), ConstantIterator(gt->getValue(), 0));
+
+		} else {
+
+			if (rec->isConstant())
+				add(ConstantIterator(rec->getValue(), 0), ConstantIterator(rec->getValue(), rec->size()), gt->getValues().begin());
+			else
+				add(rec->getValues().begin(), rec->getValues().end(), gt->getValues().begin());
+		}
+	}
+}
+
+void
+ContingencyTable::merge(const ContingencyTable& other) {
+
+	if (other._ignoreBackground != _ignoreBackground)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"can not merge contingency tables that differ in whether they ignore the background");
+
+	LabelPair labels;
+	uint64_t  count;
+	foreach (boost::tie(labels, count), other._jointCounts)
+		_jointCounts[labels] += count;
+
+	_numLocations += other._numLocations;
+}
+
+void
+ContingencyTable::clear() {
+
+	_jointCounts.clear();
+	_numLocations = 0;
+}
+
+ContingencyTable::Counts
+ContingencyTable::getReconstructionCounts() const {
+
+	Counts counts;
+
+	LabelPair labels;
+	uint64_t  count;
+	foreach (boost::tie(labels, count), _jointCounts)
+		counts[labels.first] += count;
+
+	return counts;
+}
+
+ContingencyTable::Counts
+ContingencyTable::getGroundTruthCounts() const {
+
+	Counts counts;
+
+	LabelPair labels;
+	uint64_t  count;
+	foreach (boost::tie(labels, count), _jointCounts)
+		counts[labels.second] += count;
+
+	return counts;
+}
+
+void
+ContingencyTable::computeVariationOfInformation(VariationOfInformationErrors& errors) const {
+
+	const double n = _numLocations;
+
+	Counts recCounts = getReconstructionCounts();
+	Counts gtCounts  = getGroundTruthCounts();
+
+	// H(reconstruction)
+	double H1 = 0.0;
+	// H(ground truth)
+	double H2 = 0.0;
+	double I  = 0.0;
+
+	float    label;
+	uint64_t count;
+
+	foreach (boost::tie(label, count), recCounts) {
+
+		const double p = count/n;
+		H1 -= p * std::log2(p);
+	}
+
+	foreach (boost::tie(label, count), gtCounts) {
+
+		const double p = count/n;
+		H2 -= p * std::log2(p);
+	}
+
+	LabelPair labels;
+	foreach (boost::tie(labels, count), _jointCounts) {
+
+		const double pjk = count/n;
+		const double pj  = recCounts[labels.first]/n;
+		const double pk  = gtCounts[labels.second]/n;
+
+		I += pjk * std::log2( pjk / (pj*pk) );
+	}
+
+	// H(reconstruction, ground truth)
+	double H12 = H1 + H2 - I;
+
+	// We compare the reconstruction to the groundtruth. Thus, the split entropy
+	// represents the number of splits of ground truth regions in the
+	// reconstruction, and the merge entropy the number of merges of ground
+	// truth regions in the reconstruction.
+	//
+	// H(reconstruction|ground truth) = H(reconstruction, ground truth) - H(ground truth)
+	//   (i.e., if I know the ground truth label, how much bits do I need to
+	//   infer the reconstruction label?)
+	errors.setSplitEntropy(H12 - H2);
+	// H(ground truth|reconstruction) = H(reconstruction, ground truth) - H(reconstruction)
+	//   (i.e., if I know the reconstruction label, how much bits do I need to
+	//   infer the groundtruth label?)
+	errors.setMergeEntropy(H12 - H1);
+
+	LOG_DEBUG(contingencytablelog)
+			<< "sum of conditional entropies is " << errors.getEntropy()
+			<< ", which should be equal to " << (H1 + H2 - 2.0*I) << std::endl;
+}
+
+void
+ContingencyTable::computeRandIndex(RandIndexErrors& errors) const {
+
+	if (_numLocations == 0) {
+
+		// rand index of 1 for empty images
+		errors.setNumPairs(1);
+		errors.setNumAggreeingPairs(1);
+		errors.setPrecision(1);
+		errors.setRecall(1);
+		errors.setAdaptedRandError(0);
+		return;
+	}
+
+	// Implementation following algorith by Bjoern Andres:
+	//
+	// https://github.com/bjoern-andres/partition-comparison/blob/master/include/andres/partition-comparison.hxx
+
+	// The sums of squared counts are bounded by the squared number of
+	// locations, which does not fit into 64 bit anymore for volumes with more
+	// than about 4*10^9 locations. We therefore sum in 128 bit.
+	typedef unsigned __int128 PairCount;
+
+	const PairCount numLocations = _numLocations;
+
+	PairCount sumJointSquared = 0;
+	PairCount sumRecSquared   = 0;
+	PairCount sumGtSquared    = 0;
+
+	PairCount A = 0;
+	PairCount B = numLocations*numLocations;
+
+	LabelPair labels;
+	float     label;
+	uint64_t  count;
+
+	foreach (boost::tie(labels, count), _jointCounts) {
+
+		const PairCount n = count;
+
+		A += n*(n-1);
+		B += n*n;
+		sumJointSquared += n*n;
+	}
+
+	foreach (boost::tie(label, count), getReconstructionCounts()) {
+
+		const PairCount n = count;
+
+		B -= n*n;
+		sumRecSquared += n*n;
+	}
+
+	foreach (boost::tie(label, count), getGroundTruthCounts()) {
+
+		const PairCount n = count;
+
+		B -= n*n;
+		sumGtSquared += n*n;
+	}
+
+	double numAgree = static_cast<double>((A+B)/2);
+	double numPairs = (static_cast<double>(_numLocations)/2)*(static_cast<double>(_numLocations) - 1);
+
+	LOG_DEBUG(contingencytablelog) << "number of pairs is          " << numPairs << std::endl;
+	LOG_DEBUG(contingencytablelog) << "number of agreeing pairs is " << numAgree << std::endl;
+
+	/* The following implements the scores as described in
+	 * http://journal.frontiersin.org/article/10.3389/fnana.2015.00142/full
+	 * "Crowdsourcing the creation of image segmentation algorithms for
+	 * connectomics", Argenda-Carreras et. al., 2015
+	 *
+	 * In it, "rand split" is defined as the probability of two randomly chosen
+	 * pixels having the same label in GT and REC, given they have the same
+	 * label in GT.
+	 *
+	 * "rand merge" is defined analogously, given same labels in REC.
+	 *
+	 * "f-score" in the paper is the harmonic mean of "rand split" and "rand
+	 * merge".
+	 *
+	 * To obtain the counts, we ignore every pixel that has label 0 in GT, if
+	 * option ignoreBackground was set.
+	 */
+
+	double precision = static_cast<double>(sumJointSquared)/static_cast<double>(sumGtSquared);
+	double recall    = static_cast<double>(sumJointSquared)/static_cast<double>(sumRecSquared);
+	double fscore    = 2*(precision*recall)/(precision + recall);
+
+	LOG_DEBUG(contingencytablelog) << "sum of squared joint counts is          " << static_cast<double>(sumJointSquared) << std::endl;
+	LOG_DEBUG(contingencytablelog) << "sum of squared reconstruction counts is " << static_cast<double>(sumRecSquared) << std::endl;
+	LOG_DEBUG(contingencytablelog) << "sum of squared ground truth counts is   " << static_cast<double>(sumGtSquared) << std::endl;
+	LOG_DEBUG(contingencytablelog) << "1 - F-score is                          " << (1.0 - fscore) << std::endl;
+
+	errors.setNumPairs(numPairs);
+	errors.setNumAggreeingPairs(numAgree);
+	errors.setPrecision(precision);
+	errors.setRecall(recall);
+	errors.setAdaptedRandError(1.0 - fscore);
+}
+
+std::string
+ContingencyTable::serialize() const {
+
+	std::string blob;
+	blob.reserve(HeaderSize + EntrySize*_jointCounts.size());
+
+	blob.append(BlobMagic, 4);
+	blob.push_back(static_cast<char>(BlobVersion));
+	blob.push_back(static_cast<char>(_ignoreBackground ? 1 : 0));
+	appendUint64(blob, _jointCounts.size());
+
+	LabelPair labels;
+	uint64_t  count;
+	foreach (boost::tie(labels, count), _jointCounts) {
+
+		appendFloat(blob, labels.first);
+		appendFloat(blob, labels.second);
+		appendUint64(blob, count);
+	}
+
+	return blob;
+}
+
+void
+ContingencyTable::deserialize(const std::string& blob) {
+
+	if (blob.size() < HeaderSize || blob.compare(0, 4, BlobMagic, 4) != 0)
+		UTIL_THROW_EXCEPTION(
+				ContingencyTableFormatError,
+				"not a serialized contingency table");
+
+	if (static_cast<uint8_t>(blob[4]) != BlobVersion)
+		UTIL_THROW_EXCEPTION(
+				ContingencyTableFormatError,
+				"unsupported contingency table version " << static_cast<int>(static_cast<uint8_t>(blob[4])));
+
+	uint64_t numEntries = readUint64(blob, 6);
+
+	if (numEntries != (blob.size() - HeaderSize)/EntrySize || blob.size() != HeaderSize + EntrySize*numEntries)
+		UTIL_THROW_EXCEPTION(
+				ContingencyTableFormatError,
+				"serialized contingency table has size " << blob.size() << ", expected " << (HeaderSize + EntrySize*numEntries));
+
+	clear();
+	_ignoreBackground = (blob[5] != 0);
+
+	for (size_t pos = HeaderSize; pos < blob.size(); pos += EntrySize) {
+
+		float    recLabel = readFloat(blob, pos);
+		float    gtLabel  = readFloat(blob, pos + 4);
+		uint64_t count    = readUint64(blob, pos + 8);
+
+		_jointCounts[std::make_pair(recLabel, gtLabel)] += count;
+		_numLocations += count;
+	}
+}
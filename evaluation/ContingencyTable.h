@@ -0,0 +1,201 @@
+#ifndef TED_EVALUATION_CONTINGENCY_TABLE_H__
+#define TED_EVALUATION_CONTINGENCY_TABLE_H__
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include <imageprocessing/ImageStack.h>
+#include <util/exceptions.h>
+#include "SparseBlockVolume.h"
+#include "VariationOfInformationErrors.h"
+#include "RandIndexErrors.h"
+
+struct ContingencyTableFormatError : virtual Exception {};
+
+/**
+ * Sparse contingency table of a reconstruction and a ground truth, i.e., the
+ * number of locations for each pair of reconstruction and ground truth labels.
+ *
+ * The variation of information and the RAND index depend on this table only.
+ * Therefore, the table can be filled from arbitrary chunks of the volumes
+ * (slices, blocks, ...), serialized, and merged with the tables of other
+ * chunks, before the final errors are computed.
+ */
+class ContingencyTable {
+
+public:
+
+	// (reconstruction label, ground truth label)
+	typedef std::pair<float, float>       LabelPair;
+	typedef std::map<LabelPair, uint64_t> JointCounts;
+	typedef std::map<float, uint64_t>     Counts;
+
+	/**
+	 * Create an empty contingency table.
+	 *
+	 * @param ignoreBackground
+	 *              If set to true, locations with ground truth label 0 are not
+	 *              counted.
+	 */
+	ContingencyTable(bool ignoreBackground = false);
+
+	/**
+	 * Count all locations of the given image stacks.
+	 */
+	void add(const ImageStack& reconstruction, const ImageStack& groundTruth);
+
+	/**
+	 * Count all locations of the given images.
+	 */
+	void add(const Image& reconstruction, const Image& groundTruth);
+
+	/**
+	 * Count all locations of the given sparse volumes, which need to have the 
+	 * same block layout. Pairs of constant blocks are counted at once, and 
+	 * constant background blocks of the ground truth are skipped if the 
+	 * background is ignored.
+	 */
+	void add(const SparseBlockVolume& reconstruction, const SparseBlockVolume& groundTruth);
+
+	/**
+	 * Count the locations of a chunk given as two ranges of labels of equal
+	 * length, starting at rec and gt.
+	 */
+	template <typename RecIterator, typename GtIterator>
+	void add(RecIterator rec, RecIterator recEnd, GtIterator gt);
+
+	/**
+	 * Count count locations with the given pair of labels.
+	 */
+	void add(float recLabel, float gtLabel, uint64_t count = 1) {
+
+		if (count == 0 || (_ignoreBackground && gtLabel == 0))
+			return;
+
+		_jointCounts[std::make_pair(recLabel, gtLabel)] += count;
+		_numLocations += count;
+	}
+
+	/**
+	 * Add the counts of another table to this one.
+	 */
+	void merge(const ContingencyTable& other);
+
+	/**
+	 * Remove all counts.
+	 */
+	void clear();
+
+	/**
+	 * Get the number of locations counted so far.
+	 */
+	uint64_t getNumLocations() const { return _numLocations; }
+
+	/**
+	 * Get the number of locations for each pair of labels.
+	 */
+	const JointCounts& getJointCounts() const { return _jointCounts; }
+
+	/**
+	 * Get the number of locations for each reconstruction label.
+	 */
+	Counts getReconstructionCounts() const;
+
+	/**
+	 * Get the number of locations for each ground truth label.
+	 */
+	Counts getGroundTruthCounts() const;
+
+	/**
+	 * True, if locations with ground truth label 0 are not counted.
+	 */
+	bool ignoresBackground() const { return _ignoreBackground; }
+
+	/**
+	 * Compute the split and merge entropies from the current counts.
+	 */
+	void computeVariationOfInformation(VariationOfInformationErrors& errors) const;
+
+	/**
+	 * Compute the RAND index and adapted RAND error from the current counts.
+	 */
+	void computeRandIndex(RandIndexErrors& errors) const;
+
+	/**
+	 * Get a compact binary representation of this table.
+	 */
+	std::string serialize() const;
+
+	/**
+	 * Replace the content of this table with the content of a binary
+	 * representation created by serialize().
+	 */
+	void deserialize(const std::string& blob);
+
+private:
+
+	// iterator over a repeated label, to count constant blocks
+	class ConstantIterator {
+
+	public:
+
+		ConstantIterator(float value, size_t position) :
+			_value(value),
+			_position(position) {}
+
+		float operator*() const { return _value; }
+
+		ConstantIterator& operator++() { _position++; return *this; }
+
+		bool operator==(const ConstantIterator& other) const { return _position == other._position; }
+		bool operator!=(const ConstantIterator& other) const { return _position != other._position; }
+
+	private:
+
+		float  _value;
+		size_t _position;
+	};
+
+	JointCounts _jointCounts;
+
+	uint64_t _numLocations;
+
+	bool _ignoreBackground;
+};
+
+template <typename RecIterator, typename GtIterator>
+void
+ContingencyTable::add(RecIterator rec, RecIterator recEnd, GtIterator gt) {
+
+	if (rec == recEnd)
+		return;
+
+	// neighboring locations share their labels most of the time, so we count
+	// runs of equal label pairs before we touch the table
+	float    runRecLabel = *rec;
+	float    runGtLabel  = *gt;
+	uint64_t runLength   = 0;
+
+	for (; rec != recEnd; ++rec, ++gt) {
+
+		float recLabel = *rec;
+		float gtLabel  = *gt;
+
+		if (recLabel != runRecLabel || gtLabel != runGtLabel) {
+
+			add(runRecLabel, runGtLabel, runLength);
+
+			runRecLabel = recLabel;
+			runGtLabel  = gtLabel;
+			runLength   = 0;
+		}
+
+		runLength++;
+	}
+
+	add(runRecLabel, runGtLabel, runLength);
+}
+
+#endif // TED_EVALUATION_CONTINGENCY_TABLE_H__
+
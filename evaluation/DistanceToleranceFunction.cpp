@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <deque>
 #include "DistanceToleranceFunction.h"
+#include "ParallelFor.h"
+#include <util/exceptions.h>
 #include <util/Logger.h>
 #include <vigra/multi_distance.hxx>
 //#include <vigra/multi_impex.hxx>
@@ -8,10 +12,16 @@ logger::LogChannel distancetolerancelog("distancetolerancelog", "[DistanceTolera
 DistanceToleranceFunction::DistanceToleranceFunction(
 		float distanceThreshold,
 		bool haveBackgroundLabel,
-		float backgroundLabel) :
+		float backgroundLabel,
+		bool sliceWise,
+		unsigned int numThreads) :
 	_haveBackgroundLabel(haveBackgroundLabel),
 	_backgroundLabel(backgroundLabel),
-	_maxDistanceThreshold(distanceThreshold) {}
+	_maxDistanceThreshold(distanceThreshold),
+	_forceSliceWise(sliceWise),
+	_sliceWise(sliceWise),
+	_numThreads(numThreads),
+	_narrowBand(false) {}
 
 void
 DistanceToleranceFunction::extractCells(
@@ -24,20 +34,24 @@ DistanceToleranceFunction::extractCells(
 	_width  = gtLabels.width();
 	_height = gtLabels.height();
 
-	createBoundaryMap(recLabels);
-	createBoundaryDistanceMap();
+	computeDistanceThresholds();
 
-	//vigra::exportVolume(cellLabels, vigra::VolumeExportInfo("cell_labels/cell_labels", ".tif").setPixelType("FLOAT"));
-	//vigra::exportVolume(_boundaryMap, vigra::VolumeExportInfo("boundaries/boundaries", ".tif").setPixelType("FLOAT"));
-	//vigra::exportVolume(_boundaryDistance2, vigra::VolumeExportInfo("distances/boundary_distance2", ".tif").setPixelType("FLOAT"));
+	_narrowBand = false;
 
 	// create a cell for each found connected component in cellLabels
 	_cells->resize(numCells);
 
-	// the maximum boundary distance of any location for each cell
-	std::vector<float> maxBoundaryDistances(numCells, 0);
+	// count the locations of each cell first, such that each cell allocates 
+	// its locations only once
+	std::vector<size_t> cellSizes(numCells, 0);
+	for (unsigned int z = 0; z < _depth; z++)
+		for (unsigned int y = 0; y < _height; y++)
+			for (unsigned int x = 0; x < _width; x++)
+				cellSizes[cellLabels(x, y, z) - 1]++;
+
+	for (unsigned int i = 0; i < numCells; i++)
+		(*_cells)[i].reserve(cellSizes[i]);
 
-	std::set<unsigned int> foundCells;
 	for (unsigned int z = 0; z < _depth; z++) {
 
 		boost::shared_ptr<const Image> gt  = gtLabels[z];
@@ -52,53 +66,434 @@ DistanceToleranceFunction::extractCells(
 				// argh, vigra starts counting at 1!
 				unsigned int cellIndex = cellLabels(x, y, z) - 1;
 
+				// register the labels with the first location of a cell
+				if ((*_cells)[cellIndex].size() == 0)
+					registerPossibleMatch(gtLabel, recLabel);
+
 				(*_cells)[cellIndex].add(cell_t::Location(x, y, z));
 				(*_cells)[cellIndex].setReconstructionLabel(recLabel);
 				(*_cells)[cellIndex].setGroundTruthLabel(gtLabel);
-
-				maxBoundaryDistances[cellIndex] = std::max(maxBoundaryDistances[cellIndex], _boundaryDistance2(x, y, z));
-
-				if (foundCells.count(cellIndex) == 0) {
-
-					registerPossibleMatch(gtLabel, recLabel);
-					foundCells.insert(cellIndex);
-				}
 			}
 	}
 
-	findRelabelCandidates(maxBoundaryDistances);
+	findRelabelCandidates(recLabels);
+
+	createCellAdjacencyGraph(cellLabels);
 
 	enumerateCellLabels(recLabels);
 }
 
 void
-DistanceToleranceFunction::findRelabelCandidates(const std::vector<float>& maxBoundaryDistances) {
+DistanceToleranceFunction::findRelabelCandidates(const ImageStack& recLabels) {
+
+	createBoundaryMap(recLabels);
+
+	if (_sliceWise)
+		createSectionBoundaryDistanceMaps();
+	else
+		createBoundaryDistanceMap();
+
+	//vigra::exportVolume(_boundaryMap, vigra::VolumeExportInfo("boundaries/boundaries", ".tif").setPixelType("FLOAT"));
+	//vigra::exportVolume(_boundaryDistance2, vigra::VolumeExportInfo("distances/boundary_distance2", ".tif").setPixelType("FLOAT"));
+
+	StageMetrics::Timer timer(_metrics, "find relabel candidates");
 
 	_relabelCandidates.clear();
-	for (unsigned int cellIndex = 0; cellIndex < maxBoundaryDistances.size(); cellIndex++)
-		if (maxBoundaryDistances[cellIndex] <= _maxDistanceThreshold*_maxDistanceThreshold)
+	for (unsigned int cellIndex = 0; cellIndex < _cells->size(); cellIndex++)
+		if (isRelabelCandidate(cellIndex))
 			_relabelCandidates.push_back(cellIndex);
+
+	timer.addCount("cells", _cells->size());
+	timer.addCount("candidates", _relabelCandidates.size());
+}
+
+bool
+DistanceToleranceFunction::isRelabelCandidate(unsigned int cellIndex) {
+
+	// cells with all locations within the threshold distance to a boundary 
+	// can be relabeled
+	float maxBoundaryDistance = 0;
+	foreach (const cell_t::Location& l, (*_cells)[cellIndex])
+		maxBoundaryDistance = std::max(maxBoundaryDistance, _boundaryDistance2(l.x, l.y, l.z));
+
+	return maxBoundaryDistance <= _maxDistanceThreshold*_maxDistanceThreshold;
+}
+
+LocalToleranceFunction::CellUpdate
+DistanceToleranceFunction::updateCells(
+		vigra::MultiArray<3, unsigned int>& cellLabels,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		const cell_t::Location& changedMin,
+		const cell_t::Location& changedMax) {
+
+	if (_narrowBand)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"updates of the reconstruction need the dense boundary maps");
+
+	// The boundaries can only change up to one location away from the 
+	// changes. A cell that is further away than the thresholds from those 
+	// sees the same labels and boundaries in its neighborhood as before, and 
+	// keeps its alternatives. It also keeps its locations, since none of the 
+	// locations adjacent to it changed. All other cells are extracted again.
+	cell_t::Location min(
+			std::max(0, changedMin.x - _maxDistanceThresholdX - 1),
+			std::max(0, changedMin.y - _maxDistanceThresholdY - 1),
+			std::max(0, changedMin.z - _maxDistanceThresholdZ - 1));
+	cell_t::Location max(
+			std::min((int)_width  - 1, changedMax.x + _maxDistanceThresholdX + 1),
+			std::min((int)_height - 1, changedMax.y + _maxDistanceThresholdY + 1),
+			std::min((int)_depth  - 1, changedMax.z + _maxDistanceThresholdZ + 1));
+
+	updateBoundaryMaps(recLabels, changedMin, changedMax, min, max);
+
+	CellUpdate update;
+
+	unsigned int numPreviousCells = _cells->size();
+
+	// the cells in reach of the changes
+	std::set<unsigned int> removed;
+	for (int z = min.z; z <= max.z; z++)
+		for (int y = min.y; y <= max.y; y++)
+			for (int x = min.x; x <= max.x; x++)
+				removed.insert(cellLabels(x, y, z) - 1);
+
+	// their locations are the seeds for the new cells
+	std::vector<cell_t::Location> seeds;
+	foreach (unsigned int cellIndex, removed) {
+
+		cell_t& cell = (*_cells)[cellIndex];
+
+		update.gtLabels.insert(cell.getGroundTruthLabel());
+		update.recLabels.insert(cell.getReconstructionLabel());
+		update.recLabels.insert(cell.getAlternativeLabels().begin(), cell.getAlternativeLabels().end());
+
+		foreach (const cell_t::Location& l, cell) {
+
+			seeds.push_back(l);
+			cellLabels(l.x, l.y, l.z) = 0;
+		}
+
+		cell = cell_t();
+	}
+
+	// the previous index of the cell at each index, -1 for new cells
+	std::vector<int> origins(numPreviousCells);
+	for (unsigned int i = 0; i < numPreviousCells; i++)
+		origins[i] = (removed.count(i) ? -1 : i);
+
+	// grow a new cell from each seed that is not part of one yet, using the 
+	// indices of the removed cells first
+
+	static const int offsets[6][3] = {
+		{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+	};
+
+	std::set<unsigned int>        freeIndices = removed;
+	std::vector<cell_t::Location> stack;
+
+	foreach (const cell_t::Location& seed, seeds) {
+
+		if (cellLabels(seed.x, seed.y, seed.z) != 0)
+			continue;
+
+		unsigned int cellIndex;
+		if (freeIndices.empty()) {
+
+			cellIndex = _cells->size();
+			_cells->push_back(cell_t());
+			origins.push_back(-1);
+
+		} else {
+
+			cellIndex = *freeIndices.begin();
+			freeIndices.erase(freeIndices.begin());
+		}
+
+		cell_t& cell = (*_cells)[cellIndex];
+
+		float gtLabel  = (*gtLabels[seed.z])(seed.x, seed.y);
+		float recLabel = (*recLabels[seed.z])(seed.x, seed.y);
+
+		cell.setGroundTruthLabel(gtLabel);
+		cell.setReconstructionLabel(recLabel);
+
+		// argh, vigra starts counting at 1!
+		cellLabels(seed.x, seed.y, seed.z) = cellIndex + 1;
+		stack.push_back(seed);
+
+		while (!stack.empty()) {
+
+			cell_t::Location l = stack.back();
+			stack.pop_back();
+
+			cell.add(l);
+
+			for (int i = 0; i < 6; i++) {
+
+				cell_t::Location n(l.x + offsets[i][0], l.y + offsets[i][1], l.z + offsets[i][2]);
+
+				if (n.x < 0 || n.x >= (int)_width || n.y < 0 || n.y >= (int)_height || n.z < 0 || n.z >= (int)_depth)
+					continue;
+
+				if (cellLabels(n.x, n.y, n.z) != 0)
+					continue;
+
+				if ((*gtLabels[n.z])(n.x, n.y) != gtLabel || (*recLabels[n.z])(n.x, n.y) != recLabel)
+					continue;
+
+				cellLabels(n.x, n.y, n.z) = cellIndex + 1;
+				stack.push_back(n);
+			}
+		}
+	}
+
+	// close the remaining gaps with the last cells
+	while (!freeIndices.empty()) {
+
+		unsigned int last = _cells->size() - 1;
+
+		if (freeIndices.count(last)) {
+
+			freeIndices.erase(last);
+
+		} else {
+
+			unsigned int cellIndex = *freeIndices.begin();
+			freeIndices.erase(freeIndices.begin());
+
+			std::swap((*_cells)[cellIndex], (*_cells)[last]);
+			origins[cellIndex] = origins[last];
+
+			foreach (const cell_t::Location& l, (*_cells)[cellIndex])
+				cellLabels(l.x, l.y, l.z) = cellIndex + 1;
+		}
+
+		_cells->pop_back();
+		origins.pop_back();
+	}
+
+	update.previousToCurrent.assign(numPreviousCells, -1);
+	for (unsigned int i = 0; i < _cells->size(); i++)
+		if (origins[i] >= 0)
+			update.previousToCurrent[origins[i]] = i;
+		else
+			update.addedCells.push_back(i);
+
+	// the kept cells keep their adjacencies, the new cells find theirs in the 
+	// cell label volume
+
+	std::vector<std::vector<unsigned int> > cellAdjacency(_cells->size());
+
+	for (unsigned int i = 0; i < _cells->size(); i++) {
+
+		if (origins[i] < 0)
+			continue;
+
+		foreach (unsigned int neighbor, _cellAdjacency[origins[i]])
+			if (update.previousToCurrent[neighbor] >= 0)
+				cellAdjacency[i].push_back(update.previousToCurrent[neighbor]);
+
+		std::sort(cellAdjacency[i].begin(), cellAdjacency[i].end());
+	}
+
+	foreach (unsigned int cellIndex, update.addedCells)
+		foreach (const cell_t::Location& l, (*_cells)[cellIndex])
+			for (int i = 0; i < 6; i++) {
+
+				cell_t::Location n(l.x + offsets[i][0], l.y + offsets[i][1], l.z + offsets[i][2]);
+
+				if (n.x < 0 || n.x >= (int)_width || n.y < 0 || n.y >= (int)_height || n.z < 0 || n.z >= (int)_depth)
+					continue;
+
+				unsigned int neighbor = cellLabels(n.x, n.y, n.z) - 1;
+
+				if (neighbor == cellIndex)
+					continue;
+
+				addNeighbor(cellAdjacency[cellIndex], neighbor);
+				addNeighbor(cellAdjacency[neighbor], cellIndex);
+			}
+
+	_cellAdjacency.swap(cellAdjacency);
+
+	// only the new cells need to be tested and searched for alternatives
+
+	std::vector<unsigned int> relabelCandidates;
+	foreach (unsigned int cellIndex, _relabelCandidates)
+		if (update.previousToCurrent[cellIndex] >= 0)
+			relabelCandidates.push_back(update.previousToCurrent[cellIndex]);
+
+	std::vector<unsigned int> newCandidates;
+	foreach (unsigned int cellIndex, update.addedCells)
+		if (isRelabelCandidate(cellIndex))
+			newCandidates.push_back(cellIndex);
+
+	relabelCandidates.insert(relabelCandidates.end(), newCandidates.begin(), newCandidates.end());
+	std::sort(relabelCandidates.begin(), relabelCandidates.end());
+	_relabelCandidates.swap(relabelCandidates);
+
+	enumerateCellLabels(recLabels, newCandidates);
+
+	foreach (unsigned int cellIndex, update.addedCells) {
+
+		const cell_t& cell = (*_cells)[cellIndex];
+
+		update.gtLabels.insert(cell.getGroundTruthLabel());
+		update.recLabels.insert(cell.getReconstructionLabel());
+		update.recLabels.insert(cell.getAlternativeLabels().begin(), cell.getAlternativeLabels().end());
+	}
+
+	// matches of the removed cells might be gone
+	resetPossibleMatches();
+
+	LOG_DEBUG(distancetolerancelog)
+			<< "replaced " << removed.size() << " cells in reach of the changes by "
+			<< update.addedCells.size() << " new cells, "
+			<< newCandidates.size() << " of them can be relabeled" << std::endl;
+
+	return update;
+}
+
+void
+DistanceToleranceFunction::createBandBoundaryMap(const ImageStack& recLabels) {
+
+	StageMetrics::Timer timer(_metrics, "boundary map");
+
+	_narrowBand = true;
+
+	// no dense maps are needed
+	_boundaryMap.reshape(vigra::Shape3(0, 0, 0));
+	_boundaryDistance2.reshape(vigra::Shape3(0, 0, 0));
+
+	std::vector<cell_t::Location> neighborhood = createNeighborhood();
+
+	// collect all locations in the neighborhood of the relabel candidates
+	std::vector<size_t> band;
+
+	// the neighborhoods of close locations overlap a lot, remove duplicates 
+	// whenever the band doubled in size
+	size_t numUnique = 0;
+	auto removeDuplicates = [&]() {
+
+		std::sort(band.begin(), band.end());
+		band.erase(std::unique(band.begin(), band.end()), band.end());
+		numUnique = band.size();
+	};
+
+	foreach (unsigned int cellIndex, _relabelCandidates)
+		foreach (const cell_t::Location& i, (*_cells)[cellIndex]) {
+
+			foreach (const cell_t::Location& n, neighborhood) {
+
+				cell_t::Location j(i.x + n.x, i.y + n.y, i.z + n.z);
+
+				if (j.x < 0 || j.x >= (int)_width || j.y < 0 || j.y >= (int)_height || j.z < 0 || j.z >= (int)_depth)
+					continue;
+
+				band.push_back(bandIndex(j.x, j.y, j.z));
+			}
+
+			if (band.size() > 2*numUnique + neighborhood.size()*1024)
+				removeDuplicates();
+		}
+
+	removeDuplicates();
+
+	LOG_DEBUG(distancetolerancelog) << "creating boundary map for " << band.size() << " locations around relabel candidates" << std::endl;
+
+	// test each location of the band, keep the boundaries
+	std::vector<char> isBoundary(band.size(), false);
+	parallelFor(0, band.size(), [&](size_t k) {
+
+		size_t index = band[k];
+
+		int x = index%_width;
+		int y = (index/_width)%_height;
+		int z = index/_width/_height;
+
+		isBoundary[k] = isBoundaryVoxel(x, y, z, recLabels);
+
+	}, _numThreads);
+
+	_bandBoundaries.clear();
+	for (unsigned int k = 0; k < band.size(); k++)
+		if (isBoundary[k])
+			_bandBoundaries.push_back(band[k]);
+
+	LOG_DEBUG(distancetolerancelog) << _bandBoundaries.size() << " of them are boundaries" << std::endl;
+
+	timer.addCount("locations", band.size());
+	timer.addCount("boundaries", _bandBoundaries.size());
+}
+
+bool
+DistanceToleranceFunction::isBoundary(int x, int y, int z) const {
+
+	if (_narrowBand)
+		return std::binary_search(_bandBoundaries.begin(), _bandBoundaries.end(), bandIndex(x, y, z));
+
+	return _boundaryMap(x, y, z);
+}
+
+void
+DistanceToleranceFunction::computeDistanceThresholds() {
+
+	_maxDistanceThresholdX = std::min(_width,  (unsigned int)round(_maxDistanceThreshold/_resolutionX));
+	_maxDistanceThresholdY = std::min(_height, (unsigned int)round(_maxDistanceThreshold/_resolutionY));
+	_maxDistanceThresholdZ = std::min(_depth,  (unsigned int)round(_maxDistanceThreshold/_resolutionZ));
+
+	// If the threshold rounds to zero sections, the z resolution is more than 
+	// twice the threshold. No location in a neighboring section is then 
+	// within the threshold distance, and the sections can be processed 
+	// independently without changing the result. The same holds for a single 
+	// section.
+	_sliceWise = _forceSliceWise || _maxDistanceThresholdZ == 0 || _depth == 1;
+
+	if (_forceSliceWise)
+		_maxDistanceThresholdZ = 0;
+
+	LOG_DEBUG(distancetolerancelog)
+			<< "distance thresholds in pixels (x, y, z) are ("
+			<< _maxDistanceThresholdX << ", "
+			<< _maxDistanceThresholdY << ", "
+			<< _maxDistanceThresholdZ << ")" << std::endl;
+
+	if (_sliceWise)
+		LOG_DEBUG(distancetolerancelog) << "processing sections independently" << std::endl;
 }
 
 void
 DistanceToleranceFunction::createBoundaryMap(const ImageStack& recLabels) {
 
+	StageMetrics::Timer timer(_metrics, "boundary map");
+	timer.addCount("locations", static_cast<size_t>(_width)*_height*_depth);
+
 	vigra::Shape3 shape(_width, _height, _depth);
 	_boundaryMap.reshape(shape);
 
 	// create boundary map
 	LOG_DEBUG(distancetolerancelog) << "creating boundary map of size " << shape << std::endl;
 	_boundaryMap = 0.0f;
-	for (unsigned int x = 0; x < _width; x++)
+
+	// each section only writes its own part of the boundary map
+	parallelFor(0, _depth, [&](size_t z) {
+
 		for (unsigned int y = 0; y < _height; y++)
-			for (unsigned int z = 0; z < _depth; z++)
+			for (unsigned int x = 0; x < _width; x++)
 				if (isBoundaryVoxel(x, y, z, recLabels))
 					_boundaryMap(x, y, z) = 1.0f;
+
+	}, _numThreads);
 }
 
 void
 DistanceToleranceFunction::createBoundaryDistanceMap() {
 
+	StageMetrics::Timer timer(_metrics, "distance transform");
+	timer.addCount("locations", static_cast<size_t>(_width)*_height*_depth);
+
 	vigra::Shape3 shape(_width, _height, _depth);
 	_boundaryDistance2.reshape(shape);
 
@@ -117,23 +512,115 @@ DistanceToleranceFunction::createBoundaryDistanceMap() {
 }
 
 void
-DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
+DistanceToleranceFunction::createSectionBoundaryDistanceMaps() {
 
-	_maxDistanceThresholdX = std::min(_width,  (unsigned int)round(_maxDistanceThreshold/_resolutionX));
-	_maxDistanceThresholdY = std::min(_height, (unsigned int)round(_maxDistanceThreshold/_resolutionY));
-	_maxDistanceThresholdZ = std::min(_depth,  (unsigned int)round(_maxDistanceThreshold/_resolutionZ));
+	StageMetrics::Timer timer(_metrics, "distance transform");
+	timer.addCount("locations", static_cast<size_t>(_width)*_height*_depth);
 
-	LOG_DEBUG(distancetolerancelog)
-			<< "distance thresholds in pixels (x, y, z) are ("
-			<< _maxDistanceThresholdX << ", "
-			<< _maxDistanceThresholdY << ", "
-			<< _maxDistanceThresholdZ << ")" << std::endl;
+	vigra::Shape3 shape(_width, _height, _depth);
+	_boundaryDistance2.reshape(shape);
+
+	float pitch[2];
+	pitch[0] = _resolutionX;
+	pitch[1] = _resolutionY;
+
+	// compute in-plane l2 distance for each pixel to boundary
+	LOG_DEBUG(distancetolerancelog) << "computing boundary distances for each section" << std::endl;
+	parallelFor(0, _depth, [&](size_t z) {
+
+		vigra::MultiArrayView<2, bool,  vigra::StridedArrayTag> boundaries = _boundaryMap.bind<2>(z);
+		vigra::MultiArrayView<2, float, vigra::StridedArrayTag> distances  = _boundaryDistance2.bind<2>(z);
+
+		vigra::separableMultiDistSquared(
+				boundaries,
+				distances,
+				true /* background */,
+				pitch);
+
+	}, _numThreads);
+}
+
+void
+DistanceToleranceFunction::updateBoundaryMaps(
+		const ImageStack& recLabels,
+		const cell_t::Location& changedMin,
+		const cell_t::Location& changedMax,
+		const cell_t::Location& reachMin,
+		const cell_t::Location& reachMax) {
+
+	// the boundary property depends on the face-adjacent locations
+	for (int z = std::max(0, changedMin.z - 1); z <= std::min((int)_depth - 1, changedMax.z + 1); z++)
+		for (int y = std::max(0, changedMin.y - 1); y <= std::min((int)_height - 1, changedMax.y + 1); y++)
+			for (int x = std::max(0, changedMin.x - 1); x <= std::min((int)_width - 1, changedMax.x + 1); x++)
+				_boundaryMap(x, y, z) = isBoundaryVoxel(x, y, z, recLabels);
+
+	// The distances are only compared to the threshold. A boundary within 
+	// the threshold of a location in reach is inside the reach grown by the 
+	// thresholds, and a distance transform of this crop is exact where it 
+	// matters. Outside of the reach, the distances don't change their side 
+	// of the threshold.
+	vigra::Shape3 cropMin(
+			std::max(0, reachMin.x - _maxDistanceThresholdX - 1),
+			std::max(0, reachMin.y - _maxDistanceThresholdY - 1),
+			std::max(0, reachMin.z - _maxDistanceThresholdZ - 1));
+	vigra::Shape3 cropEnd(
+			std::min((int)_width,  reachMax.x + _maxDistanceThresholdX + 2),
+			std::min((int)_height, reachMax.y + _maxDistanceThresholdY + 2),
+			std::min((int)_depth,  reachMax.z + _maxDistanceThresholdZ + 2));
+
+	vigra::MultiArrayView<3, bool, vigra::StridedArrayTag> boundaries = _boundaryMap.subarray(cropMin, cropEnd);
+	vigra::MultiArray<3, float> distances(vigra::Shape3(cropEnd[0] - cropMin[0], cropEnd[1] - cropMin[1], cropEnd[2] - cropMin[2]));
+
+	float pitch[3];
+	pitch[0] = _resolutionX;
+	pitch[1] = _resolutionY;
+	pitch[2] = _resolutionZ;
+
+	if (_sliceWise) {
+
+		for (int z = 0; z < cropEnd[2] - cropMin[2]; z++) {
+
+			vigra::MultiArrayView<2, bool,  vigra::StridedArrayTag> sectionBoundaries = boundaries.bind<2>(z);
+			vigra::MultiArrayView<2, float, vigra::StridedArrayTag> sectionDistances  = distances.bind<2>(z);
+
+			vigra::separableMultiDistSquared(
+					sectionBoundaries,
+					sectionDistances,
+					true /* background */,
+					pitch);
+		}
+
+	} else {
+
+		vigra::separableMultiDistSquared(
+				boundaries,
+				distances,
+				true /* background */,
+				pitch);
+	}
+
+	for (int z = reachMin.z; z <= reachMax.z; z++)
+		for (int y = reachMin.y; y <= reachMax.y; y++)
+			for (int x = reachMin.x; x <= reachMax.x; x++)
+				_boundaryDistance2(x, y, z) = distances(x - cropMin[0], y - cropMin[1], z - cropMin[2]);
+}
+
+void
+DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 
 	LOG_DEBUG(distancetolerancelog) << "there are " << _relabelCandidates.size() << " cells that can be relabeled" << std::endl;
 
-	if (_relabelCandidates.size() == 0)
+	enumerateCellLabels(recLabels, _relabelCandidates);
+}
+
+void
+DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels, const std::vector<unsigned int>& candidates) {
+
+	if (candidates.size() == 0)
 		return;
 
+	StageMetrics::Timer timer(_metrics, "enumerate cell labels");
+
 	LOG_DEBUG(distancetolerancelog) << "creating distance threshold neighborhood" << std::endl;
 
 	// list of all location offsets within threshold distance
@@ -141,16 +628,44 @@ DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 
 	LOG_DEBUG(distancetolerancelog) << "there are " << neighborhood.size() << " pixels in the neighborhood for a threshold of " << _maxDistanceThreshold << std::endl;
 
-	// for each cell
-	int i = 0;
-	foreach (unsigned int index, _relabelCandidates) {
+	// the alternative labels of each relabel candidate
+	std::vector<std::set<float> > alternativeLabels(candidates.size());
+
+	// whether a relabel candidate has no other label in reach
+	std::vector<char> isolated(candidates.size(), false);
+
+	// The search for alternative labels only reads the cells and the 
+	// boundary map, and can thus be done for all cells 
+	// in parallel. Matches are registered afterwards.
+	LOG_DEBUG(distancetolerancelog) << "searching alternative labels" << std::endl;
+	parallelFor(0, candidates.size(), [&](size_t i) {
 
-		i++;
-		LOG_DEBUG(distancetolerancelog)
-				<< logger::delline << "processing cell "
-				<< i << "/" << _relabelCandidates.size()
-				<< std::flush;
+		unsigned int index = candidates[i];
 
+		// only labels of cells that are within the threshold distance can 
+		// cover this cell
+		std::vector<float> candidateLabels = getCandidateLabels(index);
+
+		if (candidateLabels.empty()) {
+
+			isolated[i] = true;
+			return;
+		}
+
+		alternativeLabels[i] = getAlternativeLabels((*_cells)[index], neighborhood, recLabels, candidateLabels);
+
+	}, _numThreads);
+
+	// the number of cells without any label in reach
+	unsigned int numIsolated = 0;
+
+	// the number of alternative labels of all cells
+	size_t numAlternatives = 0;
+
+	// for each cell
+	for (unsigned int i = 0; i < candidates.size(); i++) {
+
+		unsigned int index = candidates[i];
 		cell_t& cell = (*_cells)[index];
 
 		LOG_ALL(distancetolerancelog)
@@ -159,7 +674,13 @@ DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 				<< " (gt label " << cell.getGroundTruthLabel() << ")"
 				<< std::endl;
 
-		std::set<float> alternativeLabels = getAlternativeLabels(cell, neighborhood, recLabels);
+		if (isolated[i]) {
+
+			LOG_ALL(distancetolerancelog) << "\tno candidate labels in reach" << std::endl;
+
+			numIsolated++;
+			continue;
+		}
 
 		// if there are alternatives, include the background label as well (since a 
 		// background label can be created between two foreground labels -- 
@@ -167,13 +688,13 @@ DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 		// different label, which is the case when there is at least one 
 		// alternative)
 		if (_haveBackgroundLabel)
-			if (alternativeLabels.size() > 0 && cell.getReconstructionLabel() != _backgroundLabel)
-				alternativeLabels.insert(_backgroundLabel);
+			if (alternativeLabels[i].size() > 0 && cell.getReconstructionLabel() != _backgroundLabel)
+				alternativeLabels[i].insert(_backgroundLabel);
 
 		LOG_ALL(distancetolerancelog) << "\tcan map to ";
 
 		// for each alternative label
-		foreach (float recLabel, alternativeLabels) {
+		foreach (float recLabel, alternativeLabels[i]) {
 
 			LOG_ALL(distancetolerancelog) << recLabel << " ";
 
@@ -182,9 +703,189 @@ DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 			registerPossibleMatch(cell.getGroundTruthLabel(), recLabel);
 		}
 		LOG_ALL(distancetolerancelog) << std::endl;
+
+		numAlternatives += alternativeLabels[i].size();
 	}
 
 	LOG_DEBUG(distancetolerancelog) << std::endl;
+	LOG_DEBUG(distancetolerancelog) << numIsolated << " cells have no other label in reach" << std::endl;
+
+	timer.addCount("candidates", candidates.size());
+	timer.addCount("neighborhood", neighborhood.size());
+	timer.addCount("isolated cells", numIsolated);
+	timer.addCount("alternative labels", numAlternatives);
+}
+
+void
+DistanceToleranceFunction::createCellAdjacencyGraph(const vigra::MultiArray<3, unsigned int>& cellLabels) {
+
+	StageMetrics::Timer timer(_metrics, "cell adjacency");
+
+	LOG_DEBUG(distancetolerancelog) << "creating cell adjacency graph" << std::endl;
+
+	_cellAdjacency.assign(_cells->size(), std::vector<unsigned int>());
+
+	for (unsigned int z = 0; z < _depth; z++)
+		for (unsigned int y = 0; y < _height; y++)
+			for (unsigned int x = 0; x < _width; x++) {
+
+				// argh, vigra starts counting at 1!
+				unsigned int cellIndex = cellLabels(x, y, z) - 1;
+
+				unsigned int neighbors[3] = {
+					(x + 1 < _width  ? cellLabels(x + 1, y, z) : 0),
+					(y + 1 < _height ? cellLabels(x, y + 1, z) : 0),
+					(z + 1 < _depth  ? cellLabels(x, y, z + 1) : 0)
+				};
+
+				for (int i = 0; i < 3; i++) {
+
+					if (neighbors[i] == 0 || neighbors[i] - 1 == cellIndex)
+						continue;
+
+					addNeighbor(_cellAdjacency[cellIndex], neighbors[i] - 1);
+					addNeighbor(_cellAdjacency[neighbors[i] - 1], cellIndex);
+				}
+			}
+
+	size_t numEdges = 0;
+	foreach (const std::vector<unsigned int>& neighbors, _cellAdjacency)
+		numEdges += neighbors.size();
+
+	LOG_DEBUG(distancetolerancelog) << "cell adjacency graph has " << numEdges/2 << " edges" << std::endl;
+}
+
+void
+DistanceToleranceFunction::addNeighbor(std::vector<unsigned int>& neighbors, unsigned int neighbor) {
+
+	std::vector<unsigned int>::iterator i = std::lower_bound(neighbors.begin(), neighbors.end(), neighbor);
+
+	if (i == neighbors.end() || *i != neighbor)
+		neighbors.insert(i, neighbor);
+}
+
+std::vector<float>
+DistanceToleranceFunction::getCandidateLabels(unsigned int cellIndex) {
+
+	// A boundary location j in the neighborhood of a location i of the cell 
+	// is connected to i by a path of face-adjacent locations inside the box 
+	// spanned by i and j. All cells along this path are therefore within the 
+	// reach of the neighborhood, and so are their bounding boxes. Expanding 
+	// the adjacency graph only into cells whose bounding box is within reach 
+	// thus finds all labels that can cover the cell.
+
+	// the neighborhood contains the axis locations up to the rounded 
+	// thresholds, which can be a bit further away than the threshold itself
+	float reach2 = std::max(
+			std::max(
+					_maxDistanceThreshold*_maxDistanceThreshold,
+					_maxDistanceThresholdX*_resolutionX*_maxDistanceThresholdX*_resolutionX),
+			std::max(
+					_maxDistanceThresholdY*_resolutionY*_maxDistanceThresholdY*_resolutionY,
+					_maxDistanceThresholdZ*_resolutionZ*_maxDistanceThresholdZ*_resolutionZ));
+
+	const cell_t& cell      = (*_cells)[cellIndex];
+	float         cellLabel = cell.getReconstructionLabel();
+
+	std::set<unsigned int> visited;
+	std::deque<unsigned int> queue;
+
+	// the bounding box of all cells in reach, by label
+	typedef std::map<float, std::pair<cell_t::Location, cell_t::Location> > LabelBoxes;
+	LabelBoxes labelBoxes;
+
+	visited.insert(cellIndex);
+	queue.push_back(cellIndex);
+
+	while (!queue.empty()) {
+
+		unsigned int current = queue.front();
+		queue.pop_front();
+
+		foreach (unsigned int neighbor, _cellAdjacency[current]) {
+
+			if (visited.count(neighbor))
+				continue;
+
+			visited.insert(neighbor);
+
+			const cell_t::Location& neighborMin = (*_cells)[neighbor].getBoundingBoxMin();
+			const cell_t::Location& neighborMax = (*_cells)[neighbor].getBoundingBoxMax();
+
+			if (!reachesBox(cell, neighborMin, neighborMax) || boundingBoxDistance2(cellIndex, neighbor) > reach2)
+				continue;
+
+			float label = (*_cells)[neighbor].getReconstructionLabel();
+			if (label != cellLabel) {
+
+				LabelBoxes::iterator i = labelBoxes.find(label);
+
+				if (i == labelBoxes.end()) {
+
+					labelBoxes.insert(std::make_pair(label, std::make_pair(neighborMin, neighborMax)));
+
+				} else {
+
+					cell_t::Location& min = i->second.first;
+					cell_t::Location& max = i->second.second;
+
+					min.x = std::min(min.x, neighborMin.x); max.x = std::max(max.x, neighborMax.x);
+					min.y = std::min(min.y, neighborMin.y); max.y = std::max(max.y, neighborMax.y);
+					min.z = std::min(min.z, neighborMin.z); max.z = std::max(max.z, neighborMax.z);
+				}
+			}
+
+			queue.push_back(neighbor);
+		}
+	}
+
+	// skip labels that can not reach all sides of the cell
+	std::vector<float> labels;
+	for (LabelBoxes::const_iterator i = labelBoxes.begin(); i != labelBoxes.end(); i++)
+		if (reachesAllSides(cell, i->second.first, i->second.second))
+			labels.push_back(i->first);
+
+	return labels;
+}
+
+bool
+DistanceToleranceFunction::reachesAllSides(
+		const cell_t& cell,
+		const cell_t::Location& min,
+		const cell_t::Location& max) {
+
+	const cell_t::Location& cellMin = cell.getBoundingBoxMin();
+	const cell_t::Location& cellMax = cell.getBoundingBoxMax();
+
+	// the cell has a location on each side of its bounding box, each of them 
+	// needs a covering location within its neighborhood
+	return
+			min.x - cellMin.x <= _maxDistanceThresholdX &&
+			cellMax.x - max.x <= _maxDistanceThresholdX &&
+			min.y - cellMin.y <= _maxDistanceThresholdY &&
+			cellMax.y - max.y <= _maxDistanceThresholdY &&
+			min.z - cellMin.z <= _maxDistanceThresholdZ &&
+			cellMax.z - max.z <= _maxDistanceThresholdZ;
+}
+
+bool
+DistanceToleranceFunction::reachesBox(
+		const cell_t& cell,
+		const cell_t::Location& min,
+		const cell_t::Location& max) {
+
+	const cell_t::Location& cellMin = cell.getBoundingBoxMin();
+	const cell_t::Location& cellMax = cell.getBoundingBoxMax();
+
+	// the neighborhood does not extend further than the thresholds in voxels 
+	// along each axis
+	return
+			min.x - cellMax.x <= _maxDistanceThresholdX &&
+			cellMin.x - max.x <= _maxDistanceThresholdX &&
+			min.y - cellMax.y <= _maxDistanceThresholdY &&
+			cellMin.y - max.y <= _maxDistanceThresholdY &&
+			min.z - cellMax.z <= _maxDistanceThresholdZ &&
+			cellMin.z - max.z <= _maxDistanceThresholdZ;
 }
 
 bool
@@ -271,89 +972,78 @@ std::set<float>
 DistanceToleranceFunction::getAlternativeLabels(
 		const cell_t& cell,
 		const std::vector<cell_t::Location>& neighborhood,
-		const ImageStack& recLabels) {
+		const ImageStack& recLabels,
+		const std::vector<float>& candidateLabels) {
 
 	float cellLabel = cell.getReconstructionLabel();
 
-	// counts for each neighbor label, how often it was found while iterating 
-	// over the cells locations
-	std::map<float, unsigned int> counts;
+	// the sorted candidate labels that covered all locations visited so far
+	std::vector<float> remaining = candidateLabels;
 
-	// the number of cell locations visited so far
-	unsigned int numVisited = 0;
-
-	// the maximal number of alternative labels, starts with number of labels 
-	// found at first location and decreases whenever one label was not found
-	unsigned int maxAlternativeLabels = 0;
+	// the neighborhoods of the cell's locations stay within the bounding box, 
+	// grown by the threshold -- if this is inside the volume, there is no 
+	// need to check each location
+	const cell_t::Location& min = cell.getBoundingBoxMin();
+	const cell_t::Location& max = cell.getBoundingBoxMax();
+	bool inside =
+			min.x - _maxDistanceThresholdX >= 0 && max.x + _maxDistanceThresholdX < (int)_width &&
+			min.y - _maxDistanceThresholdY >= 0 && max.y + _maxDistanceThresholdY < (int)_height &&
+			min.z - _maxDistanceThresholdZ >= 0 && max.z + _maxDistanceThresholdZ < (int)_depth;
 
 	// for each location i in that cell
 	foreach (const cell_t::Location& i, cell) {
 
-		// all the labels in the neighborhood of i
-		std::set<float> neighborhoodLabels;
-
-		numVisited++;
+		// which of the remaining candidates have been seen around i
+		std::vector<bool> seen(remaining.size(), false);
+		unsigned int numSeen = 0;
 
-		// the number of complete neighbor labels that have been seen at the 
-		// current location
-		unsigned int numComplete = 0;
-
-		// for all locations within the neighborhood, get alternative labels
+		// for all locations within the neighborhood, look for the candidates
 		foreach (const cell_t::Location& n, neighborhood) {
 
 			cell_t::Location j(i.x + n.x, i.y + n.y, i.z + n.z);
 
 			// are we leaving the image?
-			if (j.x < 0 || j.x >= (int)_width || j.y < 0 || j.y >= (int)_height || j.z < 0 || j.z >= (int)_depth)
-				continue;
+			if (!inside)
+				if (j.x < 0 || j.x >= (int)_width || j.y < 0 || j.y >= (int)_height || j.z < 0 || j.z >= (int)_depth)
+					continue;
 
 			// is this a boundary?
-			if (!_boundaryMap(j.x, j.y, j.z))
+			if (!isBoundary(j.x, j.y, j.z))
 				continue;
 
 			// now we have found a boundary pixel within our neighborhood
 			float label = (*(recLabels)[j.z])(j.x, j.y);
 
-			// count how often we see a neighbor label the first time
-			if (label != cellLabel) {
+			if (label == cellLabel)
+				continue;
 
-				bool firstTime = neighborhoodLabels.insert(label).second;
+			std::vector<float>::iterator k = std::lower_bound(remaining.begin(), remaining.end(), label);
 
-				// seen the first time for the current location i
-				if (firstTime)
-					// is a potential alternative label (covers all visited 
-					// locations so far)
-					if (++counts[label] == numVisited) {
+			if (k == remaining.end() || *k != label || seen[k - remaining.begin()])
+				continue;
 
-						numComplete++;
+			seen[k - remaining.begin()] = true;
 
-						// if we have seen all the possible complete labels 
-						// already, there is no need to search further for the 
-						// current location i
-						if (numComplete == maxAlternativeLabels)
-							break;
-					}
-			}
+			// if we have seen all remaining candidates already, there is no 
+			// need to search further for the current location i
+			if (++numSeen == remaining.size())
+				break;
 		}
 
-		// the number of labels that we have seen for each location visited so 
-		// far is the maximal possible number of alternative labels
-		maxAlternativeLabels = numComplete;
+		// candidates not seen around i don't cover the cell
+		if (numSeen < remaining.size()) {
 
-		// none of the neighbor labels covers the cell
-		if (maxAlternativeLabels == 0)
+			std::vector<float> covering;
+			for (unsigned int k = 0; k < remaining.size(); k++)
+				if (seen[k])
+					covering.push_back(remaining[k]);
+			remaining.swap(covering);
+		}
+
+		// none of the candidates covers the cell
+		if (remaining.empty())
 			break;
 	}
 
-	std::set<float> alternativeLabels;
-
-	// collect all neighbor labels that we have seen for every location of the 
-	// cell
-	float label;
-	unsigned int count;
-	foreach (boost::tie(label, count), counts)
-		if (count == cell.size())
-			alternativeLabels.insert(label);
-
-	return alternativeLabels;
+	return std::set<float>(remaining.begin(), remaining.end());
 }
@@ -7,10 +7,23 @@ class DistanceToleranceFunction : public LocalToleranceFunction {
 
 public:
 
+	/**
+	 * @param sliceWise
+	 *              Restrict the tolerance to within each section, i.e., never 
+	 *              relabel a cell because of labels in neighboring sections. 
+	 *              This is done automatically if the distance threshold is 
+	 *              smaller than half the z resolution.
+	 *
+	 * @param numThreads
+	 *              The number of threads to use for the per-section and 
+	 *              per-cell stages. The default (0) uses all available CPUs.
+	 */
 	DistanceToleranceFunction(
 			float distanceThreshold,
 			bool haveBackgroundLabel,
-			float backgroundLabel = 0.0);
+			float backgroundLabel = 0.0,
+			bool sliceWise = false,
+			unsigned int numThreads = 0);
 
 	void extractCells(
 			unsigned int numCells,
@@ -18,40 +31,57 @@ public:
 			const ImageStack& recLabels,
 			const ImageStack& gtLabels);
 
+	/**
+	 * Update the boundary maps, cells, and alternative labels in reach of the 
+	 * changed box. Needs the dense boundary maps, i.e., is not supported if 
+	 * the boundaries are only known in a narrow band.
+	 */
+	CellUpdate updateCells(
+			vigra::MultiArray<3, unsigned int>& cellLabels,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			const cell_t::Location& min,
+			const cell_t::Location& max);
+
 protected:
 
-	virtual void findRelabelCandidates(const std::vector<float>& maxBoundaryDistances);
+	// find the cells that can be relabeled, by default all cells that are 
+	// within the distance threshold to a boundary
+	virtual void findRelabelCandidates(const ImageStack& recLabels);
 
-	std::vector<unsigned int> _relabelCandidates;
+	// instead of the dense boundary map, find the boundaries only in the 
+	// neighborhood of the relabel candidates (which is all that 
+	// enumerateCellLabels() needs)
+	void createBandBoundaryMap(const ImageStack& recLabels);
 
-	bool _haveBackgroundLabel;
-	float _backgroundLabel;
+	std::vector<unsigned int> _relabelCandidates;
 
-private:
+	// create the region adjacency graph of the cells
+	void createCellAdjacencyGraph(const vigra::MultiArray<3, unsigned int>& cellLabels);
 
 	// find alternative cell labels
 	void enumerateCellLabels(const ImageStack& recLabels);
 
-	// create a b/w image of reconstruction label changes
-	void createBoundaryMap(const ImageStack& recLabels);
-
-	// create a distance2 image of boundary distances
-	void createBoundaryDistanceMap();
+	// compute the distance thresholds in voxels and decide whether to 
+	// process each section independently
+	void computeDistanceThresholds();
 
 	// find all offset locations for the given distance threshold
 	std::vector<cell_t::Location> createNeighborhood();
 
-	// search for all relabeling alternatives for the given cell and 
-	// neighborhood
-	std::set<float> getAlternativeLabels(
-			const cell_t& cell,
-			const std::vector<cell_t::Location>& neighborhood,
-			const ImageStack& recLabels);
-
 	// test, whether a voxel is surrounded by at least one other voxel with a 
 	// different label
 	bool isBoundaryVoxel(int x, int y, int z, const ImageStack& stack);
 
+	// the linear index of a location, to store the band sparsely
+	size_t bandIndex(int x, int y, int z) const {
+
+		return (static_cast<size_t>(z)*_height + y)*_width + x;
+	}
+
+	bool _haveBackgroundLabel;
+	float _backgroundLabel;
+
 	// the distance threshold in nm
 	float _maxDistanceThreshold;
 
@@ -60,11 +90,88 @@ private:
 	int _maxDistanceThresholdY;
 	int _maxDistanceThresholdZ;
 
+	// process each section independently, because it was requested or 
+	// because the tolerance does not reach into neighboring sections
+	bool _forceSliceWise;
+	bool _sliceWise;
+
+	unsigned int _numThreads;
+
 	// the extends of the ground truth and reconstruction
 	unsigned int _width, _height, _depth;
 
+private:
+
+	// test, whether all locations of a cell are within the threshold distance 
+	// to a boundary
+	bool isRelabelCandidate(unsigned int cellIndex);
+
+	// find alternative cell labels for the given relabel candidates
+	void enumerateCellLabels(const ImageStack& recLabels, const std::vector<unsigned int>& candidates);
+
+	// add a neighbor to a sorted list of neighbors, unless it is in there 
+	// already -- adjacent cells share many faces, and this keeps each edge 
+	// only once while scanning
+	static void addNeighbor(std::vector<unsigned int>& neighbors, unsigned int neighbor);
+
+	// find all reconstruction labels that have cells within the distance 
+	// threshold of the given cell, by expanding the region adjacency graph
+	std::vector<float> getCandidateLabels(unsigned int cellIndex);
+
+	// test, whether locations of the given bounding box can be in the 
+	// neighborhood of each side of the cell's bounding box
+	bool reachesAllSides(
+			const cell_t& cell,
+			const cell_t::Location& min,
+			const cell_t::Location& max);
+
+	// test, whether locations of the given bounding box can be in the 
+	// neighborhood of any location of the cell's bounding box
+	bool reachesBox(
+			const cell_t& cell,
+			const cell_t::Location& min,
+			const cell_t::Location& max);
+
+	// create a b/w image of reconstruction label changes
+	void createBoundaryMap(const ImageStack& recLabels);
+
+	// create a distance2 image of boundary distances
+	void createBoundaryDistanceMap();
+
+	// create a distance2 image of in-plane boundary distances, independently 
+	// for each section
+	void createSectionBoundaryDistanceMaps();
+
+	// update the boundary map around the changed box, and the boundary 
+	// distances inside the given reach of the changes
+	void updateBoundaryMaps(
+			const ImageStack& recLabels,
+			const cell_t::Location& changedMin,
+			const cell_t::Location& changedMax,
+			const cell_t::Location& reachMin,
+			const cell_t::Location& reachMax);
+
+	// search for all relabeling alternatives for the given cell and 
+	// neighborhood among the given candidate labels
+	std::set<float> getAlternativeLabels(
+			const cell_t& cell,
+			const std::vector<cell_t::Location>& neighborhood,
+			const ImageStack& recLabels,
+			const std::vector<float>& candidateLabels);
+
+	// the indices of the face-adjacent cells of each cell
+	std::vector<std::vector<unsigned int> > _cellAdjacency;
+
+	// look up a location in the dense or narrow band boundary map
+	bool isBoundary(int x, int y, int z) const;
+
 	vigra::MultiArray<3, bool>  _boundaryMap;
 	vigra::MultiArray<3, float> _boundaryDistance2;
+
+	// the boundary map is only given in a narrow band around the relabel 
+	// candidates, as the sorted band indices of the boundary locations
+	bool                _narrowBand;
+	std::vector<size_t> _bandBoundaries;
 };
 
 #endif // TED_EVALUATION_DISTANCE_TOLERANCE_FUNCTION_H__
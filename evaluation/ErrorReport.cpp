@@ -8,10 +8,11 @@
 logger::LogChannel errorreportlog("errorreportlog", "[ErrorReport] ");
 
 ErrorReport::ErrorReport(const Parameters& parameters) :
-	_voi(parameters.headerOnly, parameters.ignoreBackground),
-	_rand(parameters.headerOnly, parameters.ignoreBackground),
+	_voi(parameters.headerOnly, parameters.ignoreBackground, parameters.voiRandSampling),
+	_rand(parameters.headerOnly, parameters.ignoreBackground, parameters.voiRandSampling),
 	_detectionOverlap(parameters.headerOnly),
 	_ted(parameters.headerOnly),
+	_sampledTed(parameters.headerOnly, parameters.tedSampleSize, parameters.tedSampleSeed),
 	_reportAssembler(parameters.headerOnly),
 	_pipelineSetup(false),
 	_parameters(parameters) {
@@ -42,8 +43,16 @@ ErrorReport::ErrorReport(const Parameters& parameters) :
 
 	if (parameters.reportTed) {
 
-		_reportAssembler->addInput("errors", _ted->getOutput("errors"));
-		registerOutput(_ted->getOutput("errors"), "ted errors");
+		if (parameters.tedSampleSize > 0) {
+
+			_reportAssembler->addInput("errors", _sampledTed->getOutput("errors"));
+			registerOutput(_sampledTed->getOutput("errors"), "ted error estimate");
+
+		} else {
+
+			_reportAssembler->addInput("errors", _ted->getOutput("errors"));
+			registerOutput(_ted->getOutput("errors"), "ted errors");
+		}
 	}
 
 	registerOutput(_reportAssembler->getOutput("error report header"), "error report header");
@@ -53,8 +62,11 @@ ErrorReport::ErrorReport(const Parameters& parameters) :
 		registerOutput(_reportAssembler->getOutput("error report"), "error report");
 		registerOutput(_reportAssembler->getOutput("human readable error report"), "human readable error report");
 
-		if (parameters.reportTed)
+		if (parameters.reportTed && parameters.tedSampleSize == 0) {
+
 			registerOutput(_ted->getOutput("corrected reconstruction"), "ted corrected reconstruction");
+			registerOutput(_ted->getOutput("metrics"), "ted metrics");
+		}
 
 	} else {
 
@@ -92,6 +104,8 @@ ErrorReport::updateOutputs() {
 	_detectionOverlap->setInput("stack 2", _reconstruction);
 	_ted->setInput("ground truth", _groundTruthIdMap);
 	_ted->setInput("reconstruction", _reconstruction);
+	_sampledTed->setInput("ground truth", _groundTruthIdMap);
+	_sampledTed->setInput("reconstruction", _reconstruction);
 
 	_pipelineSetup = true;
 
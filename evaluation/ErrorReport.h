@@ -8,6 +8,7 @@
 #include "RandIndex.h"
 #include "DetectionOverlap.h"
 #include "TolerantEditDistance.h"
+#include "SampledTolerantEditDistance.h"
 
 class ErrorReport : public pipeline::SimpleProcessNode<> {
 
@@ -22,7 +23,9 @@ public:
 			reportVoi(false),
 			reportDetectionOverlap(false),
 			ignoreBackground(false),
-			growSlices(false) {}
+			growSlices(false),
+			tedSampleSize(0),
+			tedSampleSeed(0) {}
 
 		/**
 		 * If set to true, no error will be computed, only the header 
@@ -60,6 +63,24 @@ public:
 		 * eliminate background.
 		 */
 		bool growSlices;
+
+		/**
+		 * If enabled, estimate VOI and RAND from a sample of locations (with 
+		 * confidence intervals) instead of counting all locations.
+		 */
+		ContingencySampler::Parameters voiRandSampling;
+
+		/**
+		 * If larger than zero, estimate the TED from this many ground truth 
+		 * and reconstruction labels, instead of computing it exactly. The 
+		 * estimate is available as output "ted error estimate".
+		 */
+		unsigned int tedSampleSize;
+
+		/**
+		 * The seed to draw the labels for the TED estimate.
+		 */
+		unsigned int tedSampleSeed;
 	};
 
 	/**
@@ -158,6 +179,7 @@ private:
 	pipeline::Process<RandIndex>              _rand;
 	pipeline::Process<DetectionOverlap>       _detectionOverlap;
 	pipeline::Process<TolerantEditDistance>   _ted;
+	pipeline::Process<SampledTolerantEditDistance> _sampledTed;
 	pipeline::Process<ReportAssembler>        _reportAssembler;
 
 	pipeline::Output<VariationOfInformationErrors> _voiErrors;
@@ -1,28 +1,68 @@
+#include <algorithm>
+#include <util/exceptions.h>
+#include <util/foreach.h>
 #include "LocalToleranceFunction.h"
 
 void
 LocalToleranceFunction::clear() {
 
-	_groundTruthLabels.clear();
-	_reconstructionLabels.clear();
 	_cells = boost::make_shared<std::vector<cell_t> >();
-	_possibleGroundTruthMatches.clear();
-	_possibleReconstructionMatches.clear();
-	_cellsByRecToGtLabel.clear();
+
+	clearLabels();
+}
+
+LocalToleranceFunction::CellUpdate
+LocalToleranceFunction::updateCells(
+		vigra::MultiArray<3, unsigned int>&,
+		const ImageStack&,
+		const ImageStack&,
+		const cell_t::Location&,
+		const cell_t::Location&) {
+
+	UTIL_THROW_EXCEPTION(
+			UsageError,
+			"this tolerance function does not support updates of the reconstruction");
 }
 
-std::set<float>&
+float
+LocalToleranceFunction::boundingBoxDistance2(unsigned int cellA, unsigned int cellB) const {
+
+	const cell_t::Location& minA = (*_cells)[cellA].getBoundingBoxMin();
+	const cell_t::Location& maxA = (*_cells)[cellA].getBoundingBoxMax();
+	const cell_t::Location& minB = (*_cells)[cellB].getBoundingBoxMin();
+	const cell_t::Location& maxB = (*_cells)[cellB].getBoundingBoxMax();
+
+	float dx = std::max(0, std::max(minA.x - maxB.x, minB.x - maxA.x))*_resolutionX;
+	float dy = std::max(0, std::max(minA.y - maxB.y, minB.y - maxA.y))*_resolutionY;
+	float dz = std::max(0, std::max(minA.z - maxB.z, minB.z - maxA.z))*_resolutionZ;
+
+	return dx*dx + dy*dy + dz*dz;
+}
+
+LocalToleranceFunction::label_set_t&
 LocalToleranceFunction::getReconstructionLabels() {
 
 	return _reconstructionLabels;
 }
 
-std::set<float>&
+LocalToleranceFunction::label_set_t&
 LocalToleranceFunction::getGroundTruthLabels() {
 
 	return _groundTruthLabels;
 }
 
+void
+LocalToleranceFunction::clearLabels() {
+
+	// all objects in the arena have to be gone before it is reset
+	_groundTruthLabels.clear();
+	_reconstructionLabels.clear();
+	_possibleGroundTruthMatches.clear();
+	_possibleReconstructionMatches.clear();
+
+	_arena.reset();
+}
+
 void
 LocalToleranceFunction::registerPossibleMatch(float gtLabel, float recLabel) {
 
@@ -32,13 +72,27 @@ LocalToleranceFunction::registerPossibleMatch(float gtLabel, float recLabel) {
 	_reconstructionLabels.insert(recLabel);
 }
 
-std::set<float>&
+void
+LocalToleranceFunction::resetPossibleMatches() {
+
+	clearLabels();
+
+	foreach (const cell_t& cell, *_cells) {
+
+		registerPossibleMatch(cell.getGroundTruthLabel(), cell.getReconstructionLabel());
+
+		foreach (float recLabel, cell.getAlternativeLabels())
+			registerPossibleMatch(cell.getGroundTruthLabel(), recLabel);
+	}
+}
+
+LocalToleranceFunction::label_set_t&
 LocalToleranceFunction::getPossibleMatchesByGt(float gtLabel) {
 
 	return _possibleGroundTruthMatches[gtLabel];
 }
 
-std::set<float>&
+LocalToleranceFunction::label_set_t&
 LocalToleranceFunction::getPossibleMathesByRec(float recLabel) {
 
 	return _possibleReconstructionMatches[recLabel];
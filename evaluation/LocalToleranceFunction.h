@@ -8,7 +8,9 @@
 #include <boost/shared_ptr.hpp>
 
 #include <imageprocessing/ImageStack.h>
+#include "Arena.h"
 #include "Cell.h"
+#include "StageMetrics.h"
 
 #include <vigra/multi_array.hxx>
 
@@ -23,10 +25,36 @@ public:
 	typedef Cell<float>                             cell_t;
 	typedef boost::shared_ptr<std::vector<cell_t> > cells_t;
 
+	// sets of labels, kept in the arena of the tolerance function
+	typedef ArenaSet<float> label_set_t;
+
+	/**
+	 * The changes of the cells after an update of the reconstruction.
+	 */
+	struct CellUpdate {
+
+		// for each previous cell index the current one, or -1 if the cell was 
+		// removed
+		std::vector<int> previousToCurrent;
+
+		// the indices of the cells that replaced the removed ones
+		std::vector<unsigned int> addedCells;
+
+		// the ground truth and reconstruction labels (including alternatives) 
+		// of the removed and added cells
+		std::set<float> gtLabels;
+		std::set<float> recLabels;
+	};
+
 	LocalToleranceFunction() :
 		_resolutionX(1.0),
 		_resolutionY(1.0),
-		_resolutionZ(1.0) {}
+		_resolutionZ(1.0),
+		_metrics(0),
+		_groundTruthLabels(_arena),
+		_reconstructionLabels(_arena),
+		_possibleGroundTruthMatches(_arena),
+		_possibleReconstructionMatches(_arena) {}
 
 	virtual ~LocalToleranceFunction() {}
 
@@ -41,7 +69,17 @@ public:
 	}
 
 	/**
-	 * Clear all extracted cells and supplemental data structures.
+	 * Record the stages of the cell extraction in the given metrics, if not 
+	 * null.
+	 */
+	void setMetrics(StageMetrics* metrics) {
+
+		_metrics = metrics;
+	}
+
+	/**
+	 * Clear all extracted cells and supplemental data structures. The label 
+	 * tables are released at once with the arena they are kept in.
 	 */
 	void clear();
 
@@ -66,6 +104,30 @@ public:
 			const ImageStack& recLabels,
 			const ImageStack& gtLabels) = 0;
 
+	/**
+	 * Update the cells and their alternative labels after the reconstruction 
+	 * changed inside the given bounding box. Only the cells in reach of the 
+	 * box are extracted again, all other cells keep their index and 
+	 * alternatives. The default implementation does not support updates and 
+	 * throws a UsageError.
+	 *
+	 * @param cellLabels
+	 *             The cell label volume that was passed to extractCells(). It 
+	 *             is updated to the new cells.
+	 * @param recLabels
+	 *             The changed reconstruction.
+	 * @param gtLabels
+	 *             The ground truth.
+	 * @param min, max
+	 *             The inclusive bounding box of all changed locations.
+	 */
+	virtual CellUpdate updateCells(
+			vigra::MultiArray<3, unsigned int>& cellLabels,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			const cell_t::Location& min,
+			const cell_t::Location& max);
+
 	/**
 	 * Get all the cells that have been extracted.
 	 */
@@ -74,29 +136,40 @@ public:
 	/**
 	 * Get all the ground truth labels.
 	 */
-	std::set<float>& getGroundTruthLabels();
+	label_set_t& getGroundTruthLabels();
 
 	/**
 	 * Get all the reconstruction labels.
 	 */
-	std::set<float>& getReconstructionLabels();
+	label_set_t& getReconstructionLabels();
 
 	/**
 	 * Get all reconstruction labels that might be assigned to a given 
 	 * ground-truth label.
 	 */
-	std::set<float>& getPossibleMatchesByGt(float gtLabel);
+	label_set_t& getPossibleMatchesByGt(float gtLabel);
 
 	/**
 	 * Get all ground-truth labels that might be assigned to a given 
 	 * reconstruction label.
 	 */
-	std::set<float>& getPossibleMathesByRec(float recLabel);
+	label_set_t& getPossibleMathesByRec(float recLabel);
 
 protected:
 
 	void registerPossibleMatch(float gtLabel, float recLabel);
 
+	/**
+	 * Forget all possible matches and register them again for the original 
+	 * and alternative labels of the current cells.
+	 */
+	void resetPossibleMatches();
+
+	/**
+	 * The squared distance in units between the bounding boxes of two cells.
+	 */
+	float boundingBoxDistance2(unsigned int cellA, unsigned int cellB) const;
+
 	// all extracted cells
 	cells_t _cells;
 
@@ -105,22 +178,29 @@ protected:
 	float _resolutionY;
 	float _resolutionZ;
 
+	// where to record the stages, might be null
+	StageMetrics* _metrics;
+
 private:
 
+	// forget the label tables and release their memory
+	void clearLabels();
+
+	// the memory of the label tables below, which are rebuilt for each 
+	// evaluation
+	Arena _arena;
+
 	// set of all ground truth labels
-	std::set<float> _groundTruthLabels;
+	label_set_t _groundTruthLabels;
 
 	// set of all reconstruction labels
-	std::set<float> _reconstructionLabels;
+	label_set_t _reconstructionLabels;
 
 	// all possible label matchings, from ground truth to reconstruction
-	std::map<float, std::set<float> > _possibleGroundTruthMatches;
+	ArenaMap<float, label_set_t> _possibleGroundTruthMatches;
 
 	// all possible label matchings, from reconstruction to ground truth
-	std::map<float, std::set<float> > _possibleReconstructionMatches;
-
-	// map from rec labels to maps from gt label to cell indices
-	std::map<float, std::map<float, std::vector<unsigned int> > > _cellsByRecToGtLabel;
+	ArenaMap<float, label_set_t> _possibleReconstructionMatches;
 };
 
 #endif // TED_EVALUATION_LOCAL_TOLERANCE_FUNCTION_H__
@@ -0,0 +1,105 @@
+#ifndef TED_EVALUATION_PARALLEL_FOR_H__
+#define TED_EVALUATION_PARALLEL_FOR_H__
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "StageMetrics.h"
+
+/**
+ * Call f(i) for each i in [begin, end), distributed over several threads.
+ * Indices are handed out one at a time, such that threads that got cheap
+ * indices continue with the next ones.
+ *
+ * The calls have to be independent of each other. If one of them throws, the
+ * remaining indices are skipped and the first exception is rethrown in the
+ * calling thread.
+ *
+ * The CPU time of the worker threads is added to the calling thread, such
+ * that it counts for the stage metrics of the caller.
+ *
+ * @param numThreads
+ *              The number of threads to use. The default (0) uses all
+ *              available CPUs.
+ */
+template <typename F>
+void parallelFor(size_t begin, size_t end, F f, unsigned int numThreads = 0) {
+
+	if (begin >= end)
+		return;
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	if (numThreads > end - begin)
+		numThreads = end - begin;
+
+	if (numThreads == 1) {
+
+		for (size_t i = begin; i < end; i++)
+			f(i);
+		return;
+	}
+
+	std::atomic<size_t> next(begin);
+	std::exception_ptr  error;
+	std::mutex          errorMutex;
+
+	// the CPU time of each worker thread, including the workers they started
+	std::vector<double> cpuTimes(numThreads, 0);
+
+	auto work = [&]() {
+
+		while (true) {
+
+			size_t i = next++;
+
+			if (i >= end)
+				return;
+
+			try {
+
+				f(i);
+
+			} catch (...) {
+
+				std::lock_guard<std::mutex> lock(errorMutex);
+
+				if (!error)
+					error = std::current_exception();
+
+				// skip all remaining indices
+				next = end;
+				return;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++)
+		threads.push_back(std::thread([&, t]() {
+
+			double start = StageMetrics::getCpuTime();
+			work();
+			cpuTimes[t] = StageMetrics::getCpuTime() - start;
+		}));
+
+	// the calling thread participates
+	work();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (unsigned int t = 1; t < numThreads; t++)
+		StageMetrics::addWorkerCpuTime(cpuTimes[t]);
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+#endif // TED_EVALUATION_PARALLEL_FOR_H__
+
@@ -3,7 +3,9 @@
 
 #include <pipeline/all.h>
 #include <imageprocessing/ImageStack.h>
+#include "SparseBlockVolume.h"
 #include "RandIndexErrors.h"
+#include "ContingencySampler.h"
 
 class RandIndex : public pipeline::SimpleProcessNode<> {
 
@@ -15,30 +17,42 @@ public:
 	 * @param headerOnly
 	 *              If set to true, no error will be computed, only the header 
 	 *              information in Errors::errorHeader() will be set.
+	 *
+	 * @param ignoreBackground
+	 *              Do not count locations with ground truth label 0.
+	 *
+	 * @param sampling
+	 *              If enabled, estimate the errors from a sample of locations.
+	 *
+	 * Instead of the image stacks "reconstruction" and "ground truth", the 
+	 * inputs "sparse reconstruction" and "sparse ground truth" can be set. In 
+	 * this case, the work is proportional to the number of non-constant 
+	 * blocks. Sampling is not supported for sparse inputs.
 	 */
-	RandIndex(bool headerOnly = false, bool ignoreBackground = false);
+	RandIndex(
+			bool headerOnly = false,
+			bool ignoreBackground = false,
+			const ContingencySampler::Parameters& sampling = ContingencySampler::Parameters());
 
 private:
 
 	void updateOutputs();
 
-	uint64_t getNumAgreeingPairs(
-			const ImageStack& stack1,
-			const ImageStack& stack2,
-			uint64_t& numLocations,
-			uint64_t& numSameComponentPairs1,
-			uint64_t& numSameComponentPairs2,
-			uint64_t& numSameComponentPairs12);
-
 	// input image stacks
 	pipeline::Input<ImageStack> _reconstruction;
 	pipeline::Input<ImageStack> _groundTruth;
 
+	// alternative sparse inputs, used instead of the image stacks if set
+	pipeline::Input<SparseBlockVolume> _sparseReconstruction;
+	pipeline::Input<SparseBlockVolume> _sparseGroundTruth;
+
 	pipeline::Output<RandIndexErrors> _errors;
 
 	// do not count statistics for pixels that belong to the background
 	bool _ignoreBackground;
 
+	ContingencySampler::Parameters _sampling;
+
 	bool _headerOnly;
 };
 
@@ -9,7 +9,10 @@ public:
 
 	RandIndexErrors() :
 		_numPairs(0),
-		_numAgreeing(0) {}
+		_numAgreeing(0),
+		_randMargin(0),
+		_arandMargin(0),
+		_numSamples(0) {}
 
 	void setNumPairs(double numPairs) { _numPairs = numPairs; }
 
@@ -29,6 +32,30 @@ public:
 
 	double getAdaptedRandError() { return _arand; }
 
+	/**
+	 * For estimated errors, set the margins of the 95% confidence intervals of
+	 * the RAND index and the adapted RAND error.
+	 */
+	void setMargins(double randMargin, double arandMargin) {
+
+		_randMargin  = randMargin;
+		_arandMargin = arandMargin;
+	}
+
+	double getRandIndexMargin() { return _randMargin; }
+
+	double getAdaptedRandErrorMargin() { return _arandMargin; }
+
+	/**
+	 * For estimated errors, set the number of locations that were sampled.
+	 */
+	void setNumSamples(size_t numSamples) { _numSamples = numSamples; }
+
+	/**
+	 * The number of sampled locations, or 0 if the errors are exact.
+	 */
+	size_t getNumSamples() { return _numSamples; }
+
 	std::string errorHeader() { return "RAND\tARAND"; }
 
 	std::string errorString() {
@@ -43,8 +70,18 @@ public:
 	std::string humanReadableErrorString() {
 
 		std::stringstream ss;
-		ss << "RAND: " << getRandIndex();
-		ss << ", ARAND: " << getAdaptedRandError();
+
+		if (_numSamples == 0) {
+
+			ss << "RAND: " << getRandIndex();
+			ss << ", ARAND: " << getAdaptedRandError();
+
+		} else {
+
+			ss << "RAND: " << getRandIndex() << " +- " << getRandIndexMargin();
+			ss << ", ARAND: " << getAdaptedRandError() << " +- " << getAdaptedRandErrorMargin();
+			ss << " (estimated from " << _numSamples << " samples)";
+		}
 
 		return ss.str();
 	}
@@ -56,6 +93,11 @@ private:
 	double _precision;
 	double _recall;
 	double _arand;
+
+	double _randMargin;
+	double _arandMargin;
+
+	size_t _numSamples;
 };
 
 #endif // TED_EVALUATION_RAND_INDEX_ERRORS_H__
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cmath>
+#include <util/exceptions.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "SampledTolerantEditDistance.h"
+#include "TolerantEditDistance.h"
+
+logger::LogChannel sampledtedlog("sampledtedlog", "[SampledTolerantEditDistance] ");
+
+// defined in TedEngine.cpp
+extern util::ProgramOption optionGroundTruthFromSkeletons;
+extern util::ProgramOption optionToleranceDistanceThreshold;
+extern util::ProgramOption optionHaveBackgroundLabel;
+extern util::ProgramOption optionGroundTruthBackgroundLabel;
+extern util::ProgramOption optionReconstructionBackgroundLabel;
+
+// two-sided 95% quantile of the normal distribution
+static const double Z95 = 1.96;
+
+SampledTolerantEditDistance::SampledTolerantEditDistance(bool headerOnly, unsigned int numSamples, unsigned int seed) :
+	_errors(new TolerantEditDistanceErrorEstimate()),
+	_haveBackgroundLabel(optionHaveBackgroundLabel || optionGroundTruthFromSkeletons),
+	_gtBackgroundLabel(optionGroundTruthBackgroundLabel),
+	_recBackgroundLabel(optionReconstructionBackgroundLabel),
+	_numSamples(numSamples),
+	_random(seed),
+	_headerOnly(headerOnly) {
+
+	if (!_headerOnly) {
+
+		registerInput(_groundTruth, "ground truth");
+		registerInput(_reconstruction, "reconstruction");
+	}
+
+	registerOutput(_errors, "errors");
+}
+
+void
+SampledTolerantEditDistance::updateOutputs() {
+
+	if (_headerOnly)
+		return;
+
+	if (_groundTruth->size() != _reconstruction->size() ||
+	    _groundTruth->height() != _reconstruction->height() ||
+	    _groundTruth->width() != _reconstruction->width())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("ground truth and reconstruction have different size") << STACK_TRACE);
+
+	std::map<float, BoundingBox> gtBoxes;
+	std::map<float, BoundingBox> recBoxes;
+	findBoundingBoxes(gtBoxes, recBoxes);
+
+	std::vector<float> gtLabels  = sampleLabels(gtBoxes, _gtBackgroundLabel);
+	std::vector<float> recLabels = sampleLabels(recBoxes, _recBackgroundLabel);
+
+	size_t numGtLabels  = gtBoxes.size()  - (_haveBackgroundLabel && gtBoxes.count(_gtBackgroundLabel)   ? 1 : 0);
+	size_t numRecLabels = recBoxes.size() - (_haveBackgroundLabel && recBoxes.count(_recBackgroundLabel) ? 1 : 0);
+
+	LOG_DEBUG(sampledtedlog)
+			<< "evaluating " << gtLabels.size() << " of " << numGtLabels << " ground truth labels and "
+			<< recLabels.size() << " of " << numRecLabels << " reconstruction labels" << std::endl;
+
+	// splits and false negatives of the sampled ground truth labels
+
+	std::vector<SampleErrors> gtSamples;
+	foreach (float gtLabel, gtLabels) {
+
+		pipeline::Value<TolerantEditDistanceErrors> errors = evaluate(gtBoxes[gtLabel]);
+
+		std::vector<float> partners = errors->getReconstructionLabels(gtLabel);
+
+		SampleErrors sample;
+		sample.errors           = (partners.empty() ? 0 : partners.size() - 1);
+		sample.backgroundErrors = (_haveBackgroundLabel && std::count(partners.begin(), partners.end(), _recBackgroundLabel) ? 1 : 0);
+		gtSamples.push_back(sample);
+
+		LOG_ALL(sampledtedlog) << "ground truth label " << gtLabel << " has " << sample.errors << " splits" << std::endl;
+	}
+
+	// merges and false positives of the sampled reconstruction labels
+
+	std::vector<SampleErrors> recSamples;
+	foreach (float recLabel, recLabels) {
+
+		pipeline::Value<TolerantEditDistanceErrors> errors = evaluate(recBoxes[recLabel]);
+
+		std::vector<float> partners = errors->getGroundTruthLabels(recLabel);
+
+		SampleErrors sample;
+		sample.errors           = (partners.empty() ? 0 : partners.size() - 1);
+		sample.backgroundErrors = (_haveBackgroundLabel && std::count(partners.begin(), partners.end(), _gtBackgroundLabel) ? 1 : 0);
+		recSamples.push_back(sample);
+
+		LOG_ALL(sampledtedlog) << "reconstruction label " << recLabel << " has " << sample.errors << " merges" << std::endl;
+	}
+
+	double numSplits, splitMargin, numFalseNegatives, falseNegativeMargin, gtVariance;
+	double numMerges, mergeMargin, numFalsePositives, falsePositiveMargin, recVariance;
+
+	extrapolate(gtSamples,  numGtLabels,  numSplits, splitMargin, numFalseNegatives, falseNegativeMargin, gtVariance);
+	extrapolate(recSamples, numRecLabels, numMerges, mergeMargin, numFalsePositives, falsePositiveMargin, recVariance);
+
+	_errors->setNumSplits(numSplits, splitMargin);
+	_errors->setNumMerges(numMerges, mergeMargin);
+	_errors->setNumFalsePositives(numFalsePositives, falsePositiveMargin);
+	_errors->setNumFalseNegatives(numFalseNegatives, falseNegativeMargin);
+	// both samples are independent
+	_errors->setNumErrorsMargin(Z95*std::sqrt(gtVariance + recVariance));
+	_errors->setSampleSizes(gtLabels.size(), numGtLabels, recLabels.size(), numRecLabels);
+}
+
+void
+SampledTolerantEditDistance::findBoundingBoxes(
+		std::map<float, BoundingBox>& gtBoxes,
+		std::map<float, BoundingBox>& recBoxes) {
+
+	for (unsigned int z = 0; z < _groundTruth->size(); z++) {
+
+		const Image& gt  = *(*_groundTruth)[z];
+		const Image& rec = *(*_reconstruction)[z];
+
+		for (unsigned int y = 0; y < gt.height(); y++)
+			for (unsigned int x = 0; x < gt.width(); x++) {
+
+				gtBoxes[gt(x, y)].fit(x, y, z);
+				recBoxes[rec(x, y)].fit(x, y, z);
+			}
+	}
+}
+
+std::vector<float>
+SampledTolerantEditDistance::sampleLabels(const std::map<float, BoundingBox>& boxes, float backgroundLabel) {
+
+	std::vector<float> labels;
+
+	float label;
+	BoundingBox box;
+	foreach (boost::tie(label, box), boxes)
+		if (!_haveBackgroundLabel || label != backgroundLabel)
+			labels.push_back(label);
+
+	// draw without replacement
+	std::shuffle(labels.begin(), labels.end(), _random);
+
+	if (labels.size() > _numSamples)
+		labels.resize(_numSamples);
+
+	return labels;
+}
+
+pipeline::Value<TolerantEditDistanceErrors>
+SampledTolerantEditDistance::evaluate(BoundingBox box) {
+
+	// the tolerance halo in voxels
+	float threshold = optionToleranceDistanceThreshold.as<float>();
+	int haloX = static_cast<int>(std::ceil(threshold/_groundTruth->getResolutionX())) + 1;
+	int haloY = static_cast<int>(std::ceil(threshold/_groundTruth->getResolutionY())) + 1;
+	int haloZ = static_cast<int>(std::ceil(threshold/_groundTruth->getResolutionZ())) + 1;
+
+	box.grow(haloX, haloY, haloZ, _groundTruth->width(), _groundTruth->height(), _groundTruth->size());
+
+	pipeline::Process<TolerantEditDistance> ted(false);
+	ted->setInput("ground truth", crop(*_groundTruth, box));
+	ted->setInput("reconstruction", crop(*_reconstruction, box));
+
+	pipeline::Value<TolerantEditDistanceErrors> errors = ted->getOutput("errors");
+
+	return errors;
+}
+
+pipeline::Value<ImageStack>
+SampledTolerantEditDistance::crop(const ImageStack& stack, const BoundingBox& box) {
+
+	pipeline::Value<ImageStack> cropped;
+
+	unsigned int width  = box.maxX - box.minX + 1;
+	unsigned int height = box.maxY - box.minY + 1;
+
+	for (int z = box.minZ; z <= box.maxZ; z++) {
+
+		const Image& image = *stack[z];
+
+		boost::shared_ptr<Image> section = boost::make_shared<Image>(width, height);
+
+		for (unsigned int y = 0; y < height; y++)
+			for (unsigned int x = 0; x < width; x++)
+				(*section)(x, y) = image(box.minX + x, box.minY + y);
+
+		cropped->add(section);
+	}
+
+	cropped->setResolution(stack.getResolutionX(), stack.getResolutionY(), stack.getResolutionZ());
+
+	return cropped;
+}
+
+void
+SampledTolerantEditDistance::extrapolate(
+		const std::vector<SampleErrors>& samples,
+		size_t populationSize,
+		double& errors,
+		double& errorsMargin,
+		double& backgroundErrors,
+		double& backgroundErrorsMargin,
+		double& variance) {
+
+	errors = errorsMargin = backgroundErrors = backgroundErrorsMargin = variance = 0;
+
+	const double n = samples.size();
+	const double N = populationSize;
+
+	if (n == 0)
+		return;
+
+	double meanErrors = 0;
+	double meanBackgroundErrors = 0;
+	foreach (const SampleErrors& sample, samples) {
+
+		meanErrors           += sample.errors;
+		meanBackgroundErrors += sample.backgroundErrors;
+	}
+	meanErrors           /= n;
+	meanBackgroundErrors /= n;
+
+	errors           = N*meanErrors;
+	backgroundErrors = N*meanBackgroundErrors;
+
+	if (n < 2)
+		return;
+
+	// sample variances of the per-label counts, and of their sum
+	double varErrors = 0;
+	double varBackgroundErrors = 0;
+	double varSum = 0;
+	foreach (const SampleErrors& sample, samples) {
+
+		double e = sample.errors - meanErrors;
+		double b = sample.backgroundErrors - meanBackgroundErrors;
+
+		varErrors           += e*e;
+		varBackgroundErrors += b*b;
+		varSum              += (e + b)*(e + b);
+	}
+	varErrors           /= n - 1;
+	varBackgroundErrors /= n - 1;
+	varSum              /= n - 1;
+
+	// variance of N*mean for sampling without replacement
+	double factor = N*N*(1.0 - n/N)/n;
+
+	errorsMargin           = Z95*std::sqrt(factor*varErrors);
+	backgroundErrorsMargin = Z95*std::sqrt(factor*varBackgroundErrors);
+	variance               = factor*varSum;
+}
+
+void
+SampledTolerantEditDistance::BoundingBox::fit(int x, int y, int z) {
+
+	if (minX < 0) {
+
+		minX = maxX = x;
+		minY = maxY = y;
+		minZ = maxZ = z;
+		return;
+	}
+
+	minX = std::min(minX, x); maxX = std::max(maxX, x);
+	minY = std::min(minY, y); maxY = std::max(maxY, y);
+	minZ = std::min(minZ, z); maxZ = std::max(maxZ, z);
+}
+
+void
+SampledTolerantEditDistance::BoundingBox::grow(int haloX, int haloY, int haloZ, int width, int height, int depth) {
+
+	minX = std::max(0, minX - haloX); maxX = std::min(width  - 1, maxX + haloX);
+	minY = std::max(0, minY - haloY); maxY = std::min(height - 1, maxY + haloY);
+	minZ = std::max(0, minZ - haloZ); maxZ = std::min(depth  - 1, maxZ + haloZ);
+}
@@ -0,0 +1,109 @@
+#ifndef TED_EVALUATION_SAMPLED_TOLERANT_EDIT_DISTANCE_H__
+#define TED_EVALUATION_SAMPLED_TOLERANT_EDIT_DISTANCE_H__
+
+#include <random>
+#include <imageprocessing/ImageStack.h>
+#include <pipeline/SimpleProcessNode.h>
+#include <pipeline/Value.h>
+#include "TolerantEditDistanceErrors.h"
+#include "TolerantEditDistanceErrorEstimate.h"
+
+/**
+ * Estimates the TED errors from a random subset of ground truth and
+ * reconstruction labels.
+ *
+ * For each sampled ground truth label, the TED is computed on the bounding box
+ * of the label, enlarged by the maximal boundary shift, and the splits and
+ * false negatives of this label are recorded. In the same way, merges and
+ * false positives are recorded for sampled reconstruction labels. The totals
+ * are extrapolated to all labels, with a finite population corrected 95%
+ * confidence interval.
+ *
+ * Since each sample is solved in isolation, cells outside of the enlarged
+ * bounding box do not compete for the labels of the sample. The estimate is
+ * therefore not exactly unbiased, but close whenever the errors are local.
+ */
+class SampledTolerantEditDistance : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	/**
+	 * Create a new estimator.
+	 *
+	 * @param headerOnly
+	 *              If set to true, no error will be computed, only the header
+	 *              information in Errors::errorHeader() will be set.
+	 *
+	 * @param numSamples
+	 *              The number of ground truth labels and the number of
+	 *              reconstruction labels to evaluate.
+	 *
+	 * @param seed
+	 *              The seed to draw the labels.
+	 */
+	SampledTolerantEditDistance(bool headerOnly = false, unsigned int numSamples = 100, unsigned int seed = 0);
+
+private:
+
+	struct BoundingBox {
+
+		BoundingBox() :
+			minX(-1), minY(-1), minZ(-1),
+			maxX(-1), maxY(-1), maxZ(-1) {}
+
+		void fit(int x, int y, int z);
+
+		void grow(int haloX, int haloY, int haloZ, int width, int height, int depth);
+
+		// inclusive bounds
+		int minX, minY, minZ;
+		int maxX, maxY, maxZ;
+	};
+
+	// the error counts found for one sampled label
+	struct SampleErrors {
+
+		double errors;
+		double backgroundErrors;
+	};
+
+	void updateOutputs();
+
+	void findBoundingBoxes(
+			std::map<float, BoundingBox>& gtBoxes,
+			std::map<float, BoundingBox>& recBoxes);
+
+	std::vector<float> sampleLabels(const std::map<float, BoundingBox>& boxes, float backgroundLabel);
+
+	pipeline::Value<TolerantEditDistanceErrors> evaluate(BoundingBox box);
+
+	pipeline::Value<ImageStack> crop(const ImageStack& stack, const BoundingBox& box);
+
+	void extrapolate(
+			const std::vector<SampleErrors>& samples,
+			size_t populationSize,
+			double& errors,
+			double& errorsMargin,
+			double& backgroundErrors,
+			double& backgroundErrorsMargin,
+			double& variance);
+
+	pipeline::Input<ImageStack> _groundTruth;
+	pipeline::Input<ImageStack> _reconstruction;
+
+	pipeline::Output<TolerantEditDistanceErrorEstimate> _errors;
+
+	bool _haveBackgroundLabel;
+
+	float _gtBackgroundLabel;
+	float _recBackgroundLabel;
+
+	unsigned int _numSamples;
+
+	std::mt19937 _random;
+
+	bool _headerOnly;
+};
+
+#endif // TED_EVALUATION_SAMPLED_TOLERANT_EDIT_DISTANCE_H__
+
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <cmath>
+#include <util/exceptions.h>
+#include <util/Logger.h>
+#include "SkeletonGraphToleranceFunction.h"
+#include "ParallelFor.h"
+
+logger::LogChannel skeletongraphtolerancelog("skeletongraphtolerancelog", "[SkeletonGraphToleranceFunction] ");
+
+SkeletonGraphToleranceFunction::SkeletonGraphToleranceFunction(
+		float distanceThreshold,
+		float backgroundLabel,
+		bool sliceWise,
+		unsigned int numThreads) :
+	DistanceToleranceFunction(
+			distanceThreshold,
+			true, /* have background label */
+			backgroundLabel,
+			sliceWise,
+			numThreads) {}
+
+void
+SkeletonGraphToleranceFunction::extractCells(
+		unsigned int,
+		const vigra::MultiArray<3, unsigned int>&,
+		const ImageStack&,
+		const ImageStack&) {
+
+	UTIL_THROW_EXCEPTION(
+			UsageError,
+			"the skeleton graph tolerance function needs the ground truth as skeletons");
+}
+
+void
+SkeletonGraphToleranceFunction::extractCells(
+		const Skeletons& skeletons,
+		const ImageStack& recLabels) {
+
+	_depth  = recLabels.size();
+	_width  = recLabels.width();
+	_height = recLabels.height();
+
+	computeDistanceThresholds();
+
+	StageMetrics::Timer rasterizeTimer(_metrics, "rasterize skeletons");
+
+	for (Skeletons::const_iterator i = skeletons.begin(); i != skeletons.end(); i++) {
+
+		std::vector<cell_t::Location>                       locations;
+		std::vector<std::pair<unsigned int, unsigned int> > adjacencies;
+
+		rasterize(i->second, locations, adjacencies);
+		addCells(i->first, locations, adjacencies, recLabels);
+	}
+
+	LOG_DEBUG(skeletongraphtolerancelog) << "found " << _cells->size() << " cells along " << skeletons.size() << " skeletons" << std::endl;
+
+	unsigned int numSkeletonCells = _cells->size();
+
+	rasterizeTimer.addCount("skeletons", skeletons.size());
+	rasterizeTimer.addCount("cells", numSkeletonCells);
+	rasterizeTimer.stop();
+
+	addBackgroundCells(recLabels);
+
+	StageMetrics::Timer timer(_metrics, "enumerate cell labels");
+
+	std::vector<cell_t::Location> neighborhood = createNeighborhood();
+
+	LOG_DEBUG(skeletongraphtolerancelog) << "there are " << neighborhood.size() << " pixels in the neighborhood for a threshold of " << _maxDistanceThreshold << std::endl;
+
+	// all skeleton cells are relabel candidates, their search for
+	// alternatives only reads the reconstruction
+	std::vector<std::set<float> > alternativeLabels(numSkeletonCells);
+
+	parallelFor(0, numSkeletonCells, [&](size_t i) {
+
+		alternativeLabels[i] = getAlternativeLabels((*_cells)[i], neighborhood, recLabels);
+
+	}, _numThreads);
+
+	for (unsigned int i = 0; i < numSkeletonCells; i++) {
+
+		cell_t& cell = (*_cells)[i];
+
+		// as in the dense case, a background label can be created between
+		// the cell's label and any alternative
+		if (alternativeLabels[i].size() > 0 && cell.getReconstructionLabel() != _backgroundLabel)
+			alternativeLabels[i].insert(_backgroundLabel);
+
+		foreach (float recLabel, alternativeLabels[i]) {
+
+			cell.addAlternativeLabel(recLabel);
+			registerPossibleMatch(cell.getGroundTruthLabel(), recLabel);
+		}
+	}
+
+	timer.addCount("candidates", numSkeletonCells);
+	timer.addCount("neighborhood", neighborhood.size());
+}
+
+void
+SkeletonGraphToleranceFunction::rasterize(
+		const Skeletons::Skeleton& skeleton,
+		std::vector<cell_t::Location>& locations,
+		std::vector<std::pair<unsigned int, unsigned int> >& adjacencies) {
+
+	// the index of each location in locations
+	std::map<cell_t::Location, unsigned int> indices;
+
+	// get the index of a location, -1 if outside of the volume
+	auto indexOf = [&](float x, float y, float z) -> int {
+
+		cell_t::Location l(
+				static_cast<int>(round(x)),
+				static_cast<int>(round(y)),
+				static_cast<int>(round(z)));
+
+		if (l.x < 0 || l.x >= (int)_width || l.y < 0 || l.y >= (int)_height || l.z < 0 || l.z >= (int)_depth)
+			return -1;
+
+		std::map<cell_t::Location, unsigned int>::const_iterator i = indices.find(l);
+		if (i != indices.end())
+			return i->second;
+
+		indices.insert(std::make_pair(l, locations.size()));
+		locations.push_back(l);
+
+		return locations.size() - 1;
+	};
+
+	// nodes without edges are locations as well
+	foreach (const Skeletons::Node& node, skeleton.nodes)
+		indexOf(node.x/_resolutionX, node.y/_resolutionY, node.z/_resolutionZ);
+
+	typedef std::pair<unsigned int, unsigned int> Edge;
+	foreach (const Edge& edge, skeleton.edges) {
+
+		const Skeletons::Node& a = skeleton.nodes[edge.first];
+		const Skeletons::Node& b = skeleton.nodes[edge.second];
+
+		float ax = a.x/_resolutionX, ay = a.y/_resolutionY, az = a.z/_resolutionZ;
+		float dx = b.x/_resolutionX - ax;
+		float dy = b.y/_resolutionY - ay;
+		float dz = b.z/_resolutionZ - az;
+
+		// sample the edge with at most one voxel between samples along each
+		// axis
+		unsigned int numSteps = std::max(1, (int)std::ceil(std::max(std::fabs(dx), std::max(std::fabs(dy), std::fabs(dz)))));
+
+		int previous = indexOf(ax, ay, az);
+		for (unsigned int k = 1; k <= numSteps; k++) {
+
+			float t = static_cast<float>(k)/numSteps;
+
+			int current = indexOf(ax + t*dx, ay + t*dy, az + t*dz);
+
+			if (previous >= 0 && current >= 0 && previous != current)
+				adjacencies.push_back(std::make_pair(previous, current));
+
+			previous = current;
+		}
+	}
+}
+
+void
+SkeletonGraphToleranceFunction::addCells(
+		float gtLabel,
+		const std::vector<cell_t::Location>& locations,
+		const std::vector<std::pair<unsigned int, unsigned int> >& adjacencies,
+		const ImageStack& recLabels) {
+
+	std::vector<float> labels(locations.size());
+	for (unsigned int i = 0; i < locations.size(); i++)
+		labels[i] = (*recLabels[locations[i].z])(locations[i].x, locations[i].y);
+
+	// union-find of adjacent locations with the same reconstruction label
+
+	std::vector<unsigned int> parents(locations.size());
+	for (unsigned int i = 0; i < locations.size(); i++)
+		parents[i] = i;
+
+	auto find = [&](unsigned int i) {
+
+		while (parents[i] != i)
+			i = parents[i] = parents[parents[i]];
+
+		return i;
+	};
+
+	typedef std::pair<unsigned int, unsigned int> Adjacency;
+	foreach (const Adjacency& adjacency, adjacencies)
+		if (labels[adjacency.first] == labels[adjacency.second])
+			parents[find(adjacency.first)] = find(adjacency.second);
+
+	// one cell per component
+
+	std::map<unsigned int, unsigned int> cellIndices;
+
+	for (unsigned int i = 0; i < locations.size(); i++) {
+
+		unsigned int root = find(i);
+
+		std::map<unsigned int, unsigned int>::const_iterator c = cellIndices.find(root);
+
+		unsigned int cellIndex;
+		if (c == cellIndices.end()) {
+
+			cellIndex = _cells->size();
+			cellIndices[root] = cellIndex;
+
+			_cells->push_back(cell_t());
+			(*_cells)[cellIndex].setGroundTruthLabel(gtLabel);
+			(*_cells)[cellIndex].setReconstructionLabel(labels[i]);
+
+			registerPossibleMatch(gtLabel, labels[i]);
+
+		} else {
+
+			cellIndex = c->second;
+		}
+
+		(*_cells)[cellIndex].add(locations[i]);
+	}
+}
+
+void
+SkeletonGraphToleranceFunction::addBackgroundCells(const ImageStack& recLabels) {
+
+	StageMetrics::Timer timer(_metrics, "add background cells");
+
+	// the number of skeleton locations of each reconstruction label, where
+	// skeletons that pass through the same location count it once
+
+	std::vector<cell_t::Location> skeletonLocations;
+	foreach (const cell_t& cell, *_cells)
+		skeletonLocations.insert(skeletonLocations.end(), cell.begin(), cell.end());
+
+	std::sort(skeletonLocations.begin(), skeletonLocations.end());
+	skeletonLocations.erase(
+			std::unique(
+					skeletonLocations.begin(),
+					skeletonLocations.end(),
+					[](const cell_t::Location& a, const cell_t::Location& b) { return !(a < b) && !(b < a); }),
+			skeletonLocations.end());
+
+	std::map<float, size_t> skeletonSizes;
+	foreach (const cell_t::Location& l, skeletonLocations)
+		skeletonSizes[(*recLabels[l.z])(l.x, l.y)]++;
+
+	// the number of locations of each reconstruction label in the whole
+	// volume, counted in runs of the same label
+
+	std::vector<std::map<float, size_t> > sectionSizes(_depth);
+
+	parallelFor(0, _depth, [&](size_t z) {
+
+		const Image& section = *recLabels[z];
+
+		for (unsigned int y = 0; y < _height; y++) {
+
+			float  label = section(0, y);
+			size_t run   = 0;
+
+			for (unsigned int x = 0; x < _width; x++) {
+
+				if (section(x, y) != label) {
+
+					sectionSizes[z][label] += run;
+					label = section(x, y);
+					run   = 0;
+				}
+
+				run++;
+			}
+
+			sectionSizes[z][label] += run;
+		}
+
+	}, _numThreads);
+
+	typedef std::map<float, size_t>::value_type label_size_t;
+
+	std::map<float, size_t> sizes;
+	for (unsigned int z = 0; z < _depth; z++)
+		foreach (const label_size_t& size, sectionSizes[z])
+			sizes[size.first] += size.second;
+
+	// one background cell for each label with locations away from the
+	// skeletons
+
+	unsigned int numBackgroundCells = 0;
+
+	foreach (const label_size_t& size, sizes) {
+
+		float recLabel = size.first;
+
+		if (size.second <= skeletonSizes[recLabel])
+			continue;
+
+		_cells->push_back(cell_t());
+
+		cell_t& cell = _cells->back();
+		cell.setGroundTruthLabel(_backgroundLabel);
+		cell.setReconstructionLabel(recLabel);
+		registerPossibleMatch(_backgroundLabel, recLabel);
+
+		if (recLabel != _backgroundLabel) {
+
+			cell.addAlternativeLabel(_backgroundLabel);
+			registerPossibleMatch(_backgroundLabel, _backgroundLabel);
+		}
+
+		numBackgroundCells++;
+	}
+
+	LOG_DEBUG(skeletongraphtolerancelog) << "added " << numBackgroundCells << " background cells" << std::endl;
+
+	timer.addCount("background cells", numBackgroundCells);
+}
+
+std::set<float>
+SkeletonGraphToleranceFunction::getAlternativeLabels(
+		const cell_t& cell,
+		const std::vector<cell_t::Location>& neighborhood,
+		const ImageStack& recLabels) {
+
+	float cellLabel = cell.getReconstructionLabel();
+
+	// the labels that covered all locations visited so far
+	std::set<float> remaining;
+
+	bool first = true;
+	foreach (const cell_t::Location& i, cell) {
+
+		// the labels with a boundary location around i
+		std::set<float> seen;
+
+		foreach (const cell_t::Location& n, neighborhood) {
+
+			cell_t::Location j(i.x + n.x, i.y + n.y, i.z + n.z);
+
+			if (j.x < 0 || j.x >= (int)_width || j.y < 0 || j.y >= (int)_height || j.z < 0 || j.z >= (int)_depth)
+				continue;
+
+			float label = (*recLabels[j.z])(j.x, j.y);
+
+			if (label == cellLabel || seen.count(label))
+				continue;
+
+			// after the first location, only the remaining labels matter
+			if (!first && !remaining.count(label))
+				continue;
+
+			// the boundary is only evaluated for the few locations around the
+			// skeleton that get here
+			if (!isBoundaryVoxel(j.x, j.y, j.z, recLabels))
+				continue;
+
+			seen.insert(label);
+
+			if (!first && seen.size() == remaining.size())
+				break;
+		}
+
+		remaining.swap(seen);
+		first = false;
+
+		if (remaining.empty())
+			break;
+	}
+
+	return remaining;
+}
@@ -0,0 +1,88 @@
+#ifndef TED_EVALUATION_SKELETON_GRAPH_TOLERANCE_FUNCTION_H__
+#define TED_EVALUATION_SKELETON_GRAPH_TOLERANCE_FUNCTION_H__
+
+#include "DistanceToleranceFunction.h"
+#include "Skeletons.h"
+
+/**
+ * Distance tolerance function for skeleton ground truth that is given as
+ * graphs, instead of rasterized into a volume. The skeletons are rasterized
+ * into voxel locations along their edges (a node at position x is in voxel
+ * round(x/resX)), and cells are formed by the connected parts of each
+ * skeleton with the same reconstruction label.
+ *
+ * Only the locations on the skeletons and their neighborhoods are visited to
+ * find cells and alternative labels. The parts of the reconstruction away
+ * from the skeletons are ground truth background. As in the dense skeleton
+ * mode, they result in one background cell for each reconstruction label
+ * they contain, which can be relabeled to background. These cells have no
+ * locations, they are only found by counting the locations of each
+ * reconstruction label. A reconstruction label that does not survive on the
+ * skeletons is therefore kept by a background cell and counted as a false
+ * positive, and the ground truth background matches the reconstruction
+ * background, such that the false negatives are counted as in the dense
+ * mode.
+ */
+class SkeletonGraphToleranceFunction : public DistanceToleranceFunction {
+
+public:
+
+	SkeletonGraphToleranceFunction(
+			float distanceThreshold,
+			float backgroundLabel = 0.0,
+			bool sliceWise = false,
+			unsigned int numThreads = 0);
+
+	/**
+	 * Extract cells along the given skeletons and find all alternative labels
+	 * for them.
+	 *
+	 * @param skeletons
+	 *             The ground truth skeletons.
+	 * @param recLabels
+	 *             The reconstruction.
+	 */
+	void extractCells(
+			const Skeletons& skeletons,
+			const ImageStack& recLabels);
+
+	/**
+	 * Not supported, the ground truth has to be given as skeletons.
+	 */
+	void extractCells(
+			unsigned int numCells,
+			const vigra::MultiArray<3, unsigned int>& cellLabels,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels);
+
+private:
+
+	// find the voxel locations along a skeleton and the pairs of adjacent
+	// locations
+	void rasterize(
+			const Skeletons::Skeleton& skeleton,
+			std::vector<cell_t::Location>& locations,
+			std::vector<std::pair<unsigned int, unsigned int> >& adjacencies);
+
+	// split the locations of a skeleton into cells of the same
+	// reconstruction label
+	void addCells(
+			float gtLabel,
+			const std::vector<cell_t::Location>& locations,
+			const std::vector<std::pair<unsigned int, unsigned int> >& adjacencies,
+			const ImageStack& recLabels);
+
+	// add a background cell for each reconstruction label that has
+	// locations away from the skeleton cells
+	void addBackgroundCells(const ImageStack& recLabels);
+
+	// find all labels that have a boundary location in the neighborhood of
+	// each location of the cell
+	std::set<float> getAlternativeLabels(
+			const cell_t& cell,
+			const std::vector<cell_t::Location>& neighborhood,
+			const ImageStack& recLabels);
+};
+
+#endif // TED_EVALUATION_SKELETON_GRAPH_TOLERANCE_FUNCTION_H__
+
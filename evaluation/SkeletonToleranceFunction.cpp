@@ -1,11 +1,71 @@
 #include "SkeletonToleranceFunction.h"
 
 void
-SkeletonToleranceFunction::findRelabelCandidates(const std::vector<float>& maxBoundaryDistances) {
+SkeletonToleranceFunction::extractCells(
+		unsigned int numCells,
+		const vigra::MultiArray<3, unsigned int>& cellLabels,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels) {
 
+	if (_backgroundLocations) {
+
+		DistanceToleranceFunction::extractCells(numCells, cellLabels, recLabels, gtLabels);
+		return;
+	}
+
+	_depth  = gtLabels.size();
+	_width  = gtLabels.width();
+	_height = gtLabels.height();
+
+	computeDistanceThresholds();
+
+	// create a cell for each found connected component in cellLabels, but 
+	// store the locations of the skeleton cells only -- the non-skeleton 
+	// cells are only relabeled to background, and searched for candidate 
+	// labels by their bounding boxes
+	_cells->resize(numCells);
+
+	for (unsigned int z = 0; z < _depth; z++) {
+
+		boost::shared_ptr<const Image> gt  = gtLabels[z];
+		boost::shared_ptr<const Image> rec = recLabels[z];
+
+		for (unsigned int x = 0; x < _width; x++)
+			for (unsigned int y = 0; y < _height; y++) {
+
+				float gtLabel  = (*gt)(x, y);
+				float recLabel = (*rec)(x, y);
+
+				// argh, vigra starts counting at 1!
+				cell_t& cell = (*_cells)[cellLabels(x, y, z) - 1];
+
+				// register the labels with the first location of a cell
+				if (cell.size() == 0) {
+
+					registerPossibleMatch(gtLabel, recLabel);
+					cell.setReconstructionLabel(recLabel);
+					cell.setGroundTruthLabel(gtLabel);
+				}
+
+				if (gtLabel != _backgroundLabel)
+					cell.add(cell_t::Location(x, y, z));
+				else
+					cell.extend(cell_t::Location(x, y, z));
+			}
+	}
+
+	findRelabelCandidates(recLabels);
+
+	createCellAdjacencyGraph(cellLabels);
+
+	enumerateCellLabels(recLabels);
+}
+
+void
+SkeletonToleranceFunction::findRelabelCandidates(const ImageStack& recLabels) {
 
 	_relabelCandidates.clear();
-	for (unsigned int cellIndex = 0; cellIndex < maxBoundaryDistances.size(); cellIndex++) {
+	for (unsigned int cellIndex = 0; cellIndex < _cells->size(); cellIndex++) {
 
 		if (isSkeletonCell(cellIndex)) {
 
@@ -22,6 +82,10 @@ SkeletonToleranceFunction::findRelabelCandidates(const std::vector<float>& maxBo
 			registerPossibleMatch(cell.getGroundTruthLabel(), _backgroundLabel);
 		}
 	}
+
+	// non-skeleton cells don't need any boundary or distance information, 
+	// and skeleton cells only around them
+	createBandBoundaryMap(recLabels);
 }
 
 bool
@@ -12,20 +12,42 @@ class SkeletonToleranceFunction : public DistanceToleranceFunction {
 
 public:
 
+	/**
+	 * @param backgroundLocations
+	 *              Store the locations of the non-skeleton cells. They are 
+	 *              only needed to paint these cells into the output volumes. 
+	 *              Otherwise, these cells only keep their labels, size, and 
+	 *              bounding box.
+	 */
 	SkeletonToleranceFunction(
 			float distanceThreshold,
-			float backgroundLabel = 0.0) :
+			float backgroundLabel = 0.0,
+			bool sliceWise = false,
+			unsigned int numThreads = 0,
+			bool backgroundLocations = true) :
 		DistanceToleranceFunction(
 				distanceThreshold,
 				true, /* have background label */
-				backgroundLabel) {}
+				backgroundLabel,
+				sliceWise,
+				numThreads),
+		_backgroundLocations(backgroundLocations) {}
+
+	void extractCells(
+			unsigned int numCells,
+			const vigra::MultiArray<3, unsigned int>& cellLabels,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels);
 
 private:
 
-	// for the skeleton criterion, each cell is allowed to be relabeled
-	virtual void findRelabelCandidates(const std::vector<float>& maxBoundaryDistances);
+	// for the skeleton criterion, each skeleton cell is allowed to be 
+	// relabeled, and boundaries are only needed in a narrow band around them
+	virtual void findRelabelCandidates(const ImageStack& recLabels);
 
 	bool isSkeletonCell(unsigned int cellIndex);
+
+	bool _backgroundLocations;
 };
 
 #endif // TED_EVALUATION_SKELETON_TOLERANCE_FUNCTION_H__
@@ -0,0 +1,89 @@
+#ifndef TED_EVALUATION_SKELETONS_H__
+#define TED_EVALUATION_SKELETONS_H__
+
+#include <map>
+#include <vector>
+#include <pipeline/Data.h>
+
+/**
+ * A set of ground truth skeletons, each given as a graph of nodes and edges
+ * and identified by a label. Node positions are in volume units, i.e., they
+ * have to be divided by the resolution to get voxel coordinates.
+ */
+class Skeletons : public pipeline::Data {
+
+public:
+
+	/**
+	 * A skeleton node position in volume units.
+	 */
+	struct Node {
+
+		Node(float x_, float y_, float z_) :
+			x(x_), y(y_), z(z_) {}
+
+		float x, y, z;
+	};
+
+	/**
+	 * A skeleton as a list of nodes and edges between them.
+	 */
+	struct Skeleton {
+
+		std::vector<Node> nodes;
+
+		// pairs of node indices
+		std::vector<std::pair<unsigned int, unsigned int> > edges;
+	};
+
+	typedef std::map<float, Skeleton>  skeletons_t;
+	typedef skeletons_t::const_iterator const_iterator;
+
+	/**
+	 * Add a skeleton with the given label. Skeletons with the same label are
+	 * merged.
+	 */
+	void add(float label, const Skeleton& skeleton) {
+
+		Skeleton& merged = _skeletons[label];
+
+		unsigned int offset = merged.nodes.size();
+
+		merged.nodes.insert(merged.nodes.end(), skeleton.nodes.begin(), skeleton.nodes.end());
+
+		for (unsigned int i = 0; i < skeleton.edges.size(); i++)
+			merged.edges.push_back(
+					std::make_pair(
+							skeleton.edges[i].first  + offset,
+							skeleton.edges[i].second + offset));
+	}
+
+	/**
+	 * The number of skeletons.
+	 */
+	size_t size() const { return _skeletons.size(); }
+
+	/**
+	 * The total number of nodes in all skeletons.
+	 */
+	size_t numNodes() const {
+
+		size_t n = 0;
+		for (const_iterator i = begin(); i != end(); i++)
+			n += i->second.nodes.size();
+
+		return n;
+	}
+
+	void clear() { _skeletons.clear(); }
+
+	const_iterator begin() const { return _skeletons.begin(); }
+	const_iterator end() const { return _skeletons.end(); }
+
+private:
+
+	skeletons_t _skeletons;
+};
+
+#endif // TED_EVALUATION_SKELETONS_H__
+
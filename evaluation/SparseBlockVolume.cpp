@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <util/exceptions.h>
+#include <util/Logger.h>
+#include "SparseBlockVolume.h"
+
+logger::LogChannel sparseblockvolumelog("sparseblockvolumelog", "[SparseBlockVolume] ");
+
+SparseBlockVolume::SparseBlockVolume(
+		unsigned int width,
+		unsigned int height,
+		unsigned int depth,
+		float value,
+		unsigned int blockSize) :
+	_width(width),
+	_height(height),
+	_depth(depth),
+	_blockSize(blockSize),
+	_resX(1.0),
+	_resY(1.0),
+	_resZ(1.0) {
+
+	createBlocks(value);
+}
+
+SparseBlockVolume::SparseBlockVolume(
+		const ImageStack& stack,
+		unsigned int blockSize) :
+	_width(stack.width()),
+	_height(stack.height()),
+	_depth(stack.size()),
+	_blockSize(blockSize),
+	_resX(stack.getResolutionX()),
+	_resY(stack.getResolutionY()),
+	_resZ(stack.getResolutionZ()) {
+
+	createBlocks(0);
+
+	for (unsigned int z = 0; z < _depth; z++)
+		setSection(z, *stack[z]);
+
+	LOG_DEBUG(sparseblockvolumelog)
+			<< getNumConstantBlocks() << " of " << _blocks.size()
+			<< " blocks are constant" << std::endl;
+}
+
+void
+SparseBlockVolume::setSection(unsigned int z, const Image& section) {
+
+	if (z >= _depth || section.width() != _width || section.height() != _height)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"section " << z << " of size " << section.width() << "x" << section.height() <<
+				" does not fit into a volume of size " << _width << "x" << _height << "x" << _depth);
+
+	// Each block is expanded while its sections are copied, and compressed
+	// again when its last section was set. Setting the sections in order
+	// therefore needs memory for one slab of dense blocks only.
+
+	unsigned int bz     = z/_blockSize;
+	unsigned int zBegin = bz*_blockSize;
+	unsigned int zEnd   = std::min(_depth, zBegin + _blockSize);
+
+	for (unsigned int by = 0; by < _numBlocksY; by++)
+		for (unsigned int bx = 0; bx < _numBlocksX; bx++) {
+
+			Block& block = _blocks[(static_cast<size_t>(bz)*_numBlocksY + by)*_numBlocksX + bx];
+
+			// the first location of the block sets the constant value
+			if (z == zBegin && block.isConstant())
+				block._value = section(block._x, block._y);
+
+			for (unsigned int y = block._y; y < block._y + block._height; y++)
+				for (unsigned int x = block._x; x < block._x + block._width; x++) {
+
+					float value = section(x, y);
+
+					if (block.isConstant() && value == block._value)
+						continue;
+
+					block.set(x - block._x, y - block._y, z - block._z, value);
+				}
+
+			if (z + 1 == zEnd)
+				block.compress();
+		}
+}
+
+void
+SparseBlockVolume::createBlocks(float value) {
+
+	if (_blockSize == 0)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"block size has to be positive");
+
+	_numBlocksX = (_width  + _blockSize - 1)/_blockSize;
+	_numBlocksY = (_height + _blockSize - 1)/_blockSize;
+	_numBlocksZ = (_depth  + _blockSize - 1)/_blockSize;
+
+	_blocks.clear();
+	_blocks.reserve(static_cast<size_t>(_numBlocksX)*_numBlocksY*_numBlocksZ);
+
+	for (unsigned int bz = 0; bz < _numBlocksZ; bz++)
+		for (unsigned int by = 0; by < _numBlocksY; by++)
+			for (unsigned int bx = 0; bx < _numBlocksX; bx++) {
+
+				unsigned int x = bx*_blockSize;
+				unsigned int y = by*_blockSize;
+				unsigned int z = bz*_blockSize;
+
+				_blocks.push_back(
+						Block(
+								x, y, z,
+								std::min(_blockSize, _width  - x),
+								std::min(_blockSize, _height - y),
+								std::min(_blockSize, _depth  - z),
+								value));
+			}
+}
+
+float
+SparseBlockVolume::operator()(unsigned int x, unsigned int y, unsigned int z) const {
+
+	const Block& block = _blocks[blockIndex(x, y, z)];
+
+	return block(x - block._x, y - block._y, z - block._z);
+}
+
+void
+SparseBlockVolume::set(unsigned int x, unsigned int y, unsigned int z, float value) {
+
+	Block& block = _blocks[blockIndex(x, y, z)];
+
+	block.set(x - block._x, y - block._y, z - block._z, value);
+}
+
+void
+SparseBlockVolume::compress() {
+
+	for (size_t i = 0; i < _blocks.size(); i++)
+		_blocks[i].compress();
+}
+
+size_t
+SparseBlockVolume::getNumConstantBlocks() const {
+
+	size_t numConstant = 0;
+	for (const_iterator i = begin(); i != end(); i++)
+		if (i->isConstant())
+			numConstant++;
+
+	return numConstant;
+}
+
+void
+SparseBlockVolume::toImageStack(ImageStack& stack) const {
+
+	stack.clear();
+
+	for (unsigned int z = 0; z < _depth; z++) {
+
+		boost::shared_ptr<Image> section = boost::make_shared<Image>(_width, _height);
+
+		unsigned int bz = z/_blockSize;
+
+		for (unsigned int by = 0; by < _numBlocksY; by++)
+			for (unsigned int bx = 0; bx < _numBlocksX; bx++) {
+
+				const Block& block = _blocks[(static_cast<size_t>(bz)*_numBlocksY + by)*_numBlocksX + bx];
+
+				for (unsigned int y = 0; y < block._height; y++)
+					for (unsigned int x = 0; x < block._width; x++)
+						(*section)(block._x + x, block._y + y) = block(x, y, z - block._z);
+			}
+
+		stack.add(section);
+	}
+
+	stack.setResolution(_resX, _resY, _resZ);
+}
+
+void
+SparseBlockVolume::Block::set(unsigned int x, unsigned int y, unsigned int z, float value) {
+
+	if (isConstant()) {
+
+		if (value == _value)
+			return;
+
+		_values.assign(size(), _value);
+	}
+
+	_values[(static_cast<size_t>(z)*_height + y)*_width + x] = value;
+}
+
+bool
+SparseBlockVolume::Block::compress() {
+
+	if (isConstant())
+		return true;
+
+	for (size_t i = 1; i < _values.size(); i++)
+		if (_values[i] != _values[0])
+			return false;
+
+	_value = _values[0];
+
+	// release the memory
+	std::vector<float>().swap(_values);
+
+	return true;
+}
@@ -0,0 +1,210 @@
+#ifndef TED_EVALUATION_SPARSE_BLOCK_VOLUME_H__
+#define TED_EVALUATION_SPARSE_BLOCK_VOLUME_H__
+
+#include <vector>
+#include <pipeline/Data.h>
+#include <imageprocessing/ImageStack.h>
+
+/**
+ * A label volume that is split into cubic blocks, where blocks with only one
+ * label are stored as this label only. Volumes that are mostly background
+ * (like skeleton ground truth or partial annotations) need memory and
+ * processing time proportional to the number of non-constant blocks only.
+ *
+ * Consumers iterate over the blocks and handle constant blocks as a whole.
+ */
+class SparseBlockVolume : public pipeline::Data {
+
+public:
+
+	static const unsigned int DefaultBlockSize = 32;
+
+	/**
+	 * A block of the volume, either constant or with a label for each
+	 * location. Blocks at the upper borders of the volume can be smaller than
+	 * the block size.
+	 */
+	class Block {
+
+	public:
+
+		Block(
+				unsigned int x, unsigned int y, unsigned int z,
+				unsigned int width, unsigned int height, unsigned int depth,
+				float value) :
+			_x(x), _y(y), _z(z),
+			_width(width), _height(height), _depth(depth),
+			_value(value) {}
+
+		/**
+		 * The location of the first voxel of this block in the volume.
+		 */
+		unsigned int x() const { return _x; }
+		unsigned int y() const { return _y; }
+		unsigned int z() const { return _z; }
+
+		unsigned int width() const  { return _width; }
+		unsigned int height() const { return _height; }
+		unsigned int depth() const  { return _depth; }
+
+		/**
+		 * The number of locations in this block.
+		 */
+		size_t size() const { return static_cast<size_t>(_width)*_height*_depth; }
+
+		/**
+		 * True, if all locations of this block have the same label.
+		 */
+		bool isConstant() const { return _values.empty(); }
+
+		/**
+		 * The label of a constant block.
+		 */
+		float getValue() const { return _value; }
+
+		/**
+		 * The labels of a non-constant block, x varying fastest.
+		 */
+		const std::vector<float>& getValues() const { return _values; }
+
+		/**
+		 * The label at a location relative to the block.
+		 */
+		float operator()(unsigned int x, unsigned int y, unsigned int z) const {
+
+			if (isConstant())
+				return _value;
+
+			return _values[(static_cast<size_t>(z)*_height + y)*_width + x];
+		}
+
+	private:
+
+		friend class SparseBlockVolume;
+
+		void set(unsigned int x, unsigned int y, unsigned int z, float value);
+
+		// make the block constant, if all its labels are equal
+		bool compress();
+
+		unsigned int _x, _y, _z;
+		unsigned int _width, _height, _depth;
+
+		float _value;
+
+		std::vector<float> _values;
+	};
+
+	typedef std::vector<Block>::const_iterator const_iterator;
+
+	/**
+	 * Create a constant volume.
+	 */
+	SparseBlockVolume(
+			unsigned int width = 0,
+			unsigned int height = 0,
+			unsigned int depth = 0,
+			float value = 0,
+			unsigned int blockSize = DefaultBlockSize);
+
+	/**
+	 * Create a sparse copy of an image stack. The resolution is copied as
+	 * well.
+	 */
+	SparseBlockVolume(
+			const ImageStack& stack,
+			unsigned int blockSize = DefaultBlockSize);
+
+	unsigned int width() const  { return _width; }
+	unsigned int height() const { return _height; }
+	unsigned int depth() const  { return _depth; }
+
+	unsigned int getBlockSize() const { return _blockSize; }
+
+	/**
+	 * True, if the other volume has the same size and block size, i.e., its
+	 * blocks cover the same locations as the blocks of this volume.
+	 */
+	bool hasSameLayout(const SparseBlockVolume& other) const {
+
+		return
+				_width     == other._width &&
+				_height    == other._height &&
+				_depth     == other._depth &&
+				_blockSize == other._blockSize;
+	}
+
+	/**
+	 * The label at the given location.
+	 */
+	float operator()(unsigned int x, unsigned int y, unsigned int z) const;
+
+	/**
+	 * Set the label at the given location. Constant blocks are expanded if
+	 * needed, call compress() to make them constant again.
+	 */
+	void set(unsigned int x, unsigned int y, unsigned int z, float value);
+
+	/**
+	 * Set all labels of section z. Blocks are compressed when their last
+	 * section is set, such that filling a volume section by section in
+	 * increasing z needs memory for the non-constant blocks and one slab of
+	 * dense blocks only.
+	 */
+	void setSection(unsigned int z, const Image& section);
+
+	/**
+	 * Turn all blocks with only one label into constant blocks.
+	 */
+	void compress();
+
+	/**
+	 * Iterate over all blocks.
+	 */
+	const_iterator begin() const { return _blocks.begin(); }
+	const_iterator end() const { return _blocks.end(); }
+
+	size_t getNumBlocks() const { return _blocks.size(); }
+
+	size_t getNumConstantBlocks() const;
+
+	/**
+	 * Create a dense copy of this volume.
+	 */
+	void toImageStack(ImageStack& stack) const;
+
+	void setResolution(float resX, float resY, float resZ) {
+
+		_resX = resX;
+		_resY = resY;
+		_resZ = resZ;
+	}
+
+	float getResolutionX() const { return _resX; }
+	float getResolutionY() const { return _resY; }
+	float getResolutionZ() const { return _resZ; }
+
+private:
+
+	void createBlocks(float value);
+
+	size_t blockIndex(unsigned int x, unsigned int y, unsigned int z) const {
+
+		return
+				(static_cast<size_t>(z/_blockSize)*_numBlocksY + y/_blockSize)*_numBlocksX +
+				x/_blockSize;
+	}
+
+	unsigned int _width, _height, _depth;
+
+	unsigned int _blockSize;
+
+	unsigned int _numBlocksX, _numBlocksY, _numBlocksZ;
+
+	std::vector<Block> _blocks;
+
+	float _resX, _resY, _resZ;
+};
+
+#endif // TED_EVALUATION_SPARSE_BLOCK_VOLUME_H__
+
@@ -0,0 +1,162 @@
+#include <sys/resource.h>
+#include <time.h>
+#include <util/foreach.h>
+#include "StageMetrics.h"
+
+typedef std::map<std::string, size_t>::value_type count_t;
+
+StageMetrics::Timer::Timer(StageMetrics* metrics, const std::string& name) :
+	_metrics(metrics),
+	_stage(0),
+	_cpuTime(0),
+	_peakRss(0) {
+
+	if (!_metrics)
+		return;
+
+	_stage   = _metrics->getStageIndex(name);
+	_cpuTime = getCpuTime();
+	_peakRss = getPeakRss();
+}
+
+void
+StageMetrics::Timer::stop() {
+
+	if (!_metrics)
+		return;
+
+	boost::timer::cpu_times elapsed = _timer.elapsed();
+
+	double cpuTime = getCpuTime();
+	size_t peakRss = getPeakRss();
+
+	Stage& stage = _metrics->_stages[_stage];
+
+	stage.calls++;
+	stage.wallTime     += elapsed.wall*1e-9;
+	stage.cpuTime      += cpuTime - _cpuTime;
+	stage.peakRssDelta += peakRss - _peakRss;
+
+	_metrics = 0;
+}
+
+void
+StageMetrics::add(const StageMetrics& other) {
+
+	foreach (const Stage& stage, other.getStages())
+		add(stage);
+}
+
+void
+StageMetrics::add(const Stage& stage) {
+
+	Stage& mine = _stages[getStageIndex(stage.name)];
+
+	mine.calls        += stage.calls;
+	mine.wallTime     += stage.wallTime;
+	mine.cpuTime      += stage.cpuTime;
+	mine.peakRssDelta += stage.peakRssDelta;
+
+	foreach (const count_t& count, stage.counts)
+		mine.counts[count.first] += count.second;
+}
+
+void
+StageMetrics::writeJson(std::ostream& out) const {
+
+	out << "{\"stages\": [";
+
+	for (unsigned int i = 0; i < _stages.size(); i++) {
+
+		const Stage& stage = _stages[i];
+
+		if (i > 0)
+			out << ",";
+
+		out
+				<< "\n  {\"name\": \"" << stage.name << "\""
+				<< ", \"calls\": " << stage.calls
+				<< ", \"wallTime\": " << stage.wallTime
+				<< ", \"cpuTime\": " << stage.cpuTime
+				<< ", \"peakRssDelta\": " << stage.peakRssDelta
+				<< ", \"counts\": {";
+
+		bool first = true;
+		foreach (const count_t& count, stage.counts) {
+
+			if (!first)
+				out << ", ";
+			first = false;
+
+			out << "\"" << count.first << "\": " << count.second;
+		}
+
+		out << "}}";
+	}
+
+	out << "\n]}" << std::endl;
+}
+
+size_t
+StageMetrics::getPeakRss() {
+
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	// in bytes on OS X
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// in kilobytes on Linux and the BSDs
+	return static_cast<size_t>(usage.ru_maxrss)*1024;
+#endif
+}
+
+double
+StageMetrics::getThreadCpuTime() {
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec time;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+		return 0;
+
+	return time.tv_sec + time.tv_nsec*1e-9;
+#else
+	return 0;
+#endif
+}
+
+double
+StageMetrics::getCpuTime() {
+
+	return getThreadCpuTime() + workerCpuTime();
+}
+
+void
+StageMetrics::addWorkerCpuTime(double seconds) {
+
+	workerCpuTime() += seconds;
+}
+
+double&
+StageMetrics::workerCpuTime() {
+
+	static thread_local double seconds = 0;
+
+	return seconds;
+}
+
+unsigned int
+StageMetrics::getStageIndex(const std::string& name) {
+
+	for (unsigned int i = 0; i < _stages.size(); i++)
+		if (_stages[i].name == name)
+			return i;
+
+	_stages.push_back(Stage());
+	_stages.back().name = name;
+
+	return _stages.size() - 1;
+}
+
@@ -0,0 +1,167 @@
+#ifndef TED_EVALUATION_STAGE_METRICS_H__
+#define TED_EVALUATION_STAGE_METRICS_H__
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/timer/timer.hpp>
+
+#include <pipeline/Data.h>
+
+/**
+ * Performance and memory metrics of the stages of an evaluation. For each
+ * stage, the wall and CPU time, the growth of the peak resident set size,
+ * and counts of the items processed (like cells or ILP variables) are
+ * recorded. Stages that run several times are accumulated. Stages can be
+ * nested, the time of a stage includes the time of the stages it runs.
+ *
+ * The CPU time is the one of the thread that runs the stage and of the
+ * worker threads it starts with parallelFor(), such that evaluations in
+ * other threads do not count. The peak resident set size is
+ * a property of the process, its growth includes the memory of everything
+ * else the process runs at the same time.
+ */
+class StageMetrics : public pipeline::Data {
+
+public:
+
+	struct Stage {
+
+		Stage() :
+			calls(0),
+			wallTime(0),
+			cpuTime(0),
+			peakRssDelta(0) {}
+
+		std::string name;
+
+		// the number of times this stage was run
+		unsigned int calls;
+
+		// the elapsed wall time and the CPU time of the thread that ran the
+		// stage (including the parallelFor() workers it started) in seconds
+		double wallTime;
+		double cpuTime;
+
+		// the growth of the peak resident set size of the whole process in
+		// bytes
+		size_t peakRssDelta;
+
+		// counts of processed items, by name
+		std::map<std::string, size_t> counts;
+	};
+
+	/**
+	 * Measures a stage from its construction to its destruction, or until
+	 * stop() is called. Does nothing, if created without metrics.
+	 */
+	class Timer {
+
+	public:
+
+		Timer(StageMetrics* metrics, const std::string& name);
+
+		~Timer() { stop(); }
+
+		/**
+		 * End the stage before the timer is destructed.
+		 */
+		void stop();
+
+		/**
+		 * Add to a count of the stage.
+		 */
+		void addCount(const std::string& name, size_t count) {
+
+			if (_metrics)
+				_metrics->addCount(_stage, name, count);
+		}
+
+	private:
+
+		Timer(const Timer&);
+		Timer& operator=(const Timer&);
+
+		StageMetrics*           _metrics;
+		unsigned int            _stage;
+		boost::timer::cpu_timer _timer;
+		double                  _cpuTime;
+		size_t                  _peakRss;
+	};
+
+	/**
+	 * Forget all stages.
+	 */
+	void clear() { _stages.clear(); }
+
+	/**
+	 * Add to a count of a stage, which is created if it does not exist.
+	 */
+	void addCount(const std::string& stage, const std::string& name, size_t count) {
+
+		addCount(getStageIndex(stage), name, count);
+	}
+
+	/**
+	 * Add the stages of other metrics to this ones.
+	 */
+	void add(const StageMetrics& other);
+
+	/**
+	 * Add a single stage to the one of the same name.
+	 */
+	void add(const Stage& stage);
+
+	/**
+	 * Get the stages in the order they were first run.
+	 */
+	const std::vector<Stage>& getStages() const { return _stages; }
+
+	/**
+	 * Write the stages as a JSON object.
+	 */
+	void writeJson(std::ostream& out) const;
+
+	/**
+	 * Get the peak resident set size of this process so far in bytes.
+	 */
+	static size_t getPeakRss();
+
+	/**
+	 * Get the CPU time of the calling thread so far in seconds, 0 if not
+	 * supported by the platform.
+	 */
+	static double getThreadCpuTime();
+
+	/**
+	 * Get the CPU time of the calling thread and of all worker threads it
+	 * reported with addWorkerCpuTime() so far in seconds.
+	 */
+	static double getCpuTime();
+
+	/**
+	 * Add the CPU time of a worker thread to the calling thread, such that it
+	 * counts for the stages the calling thread runs. Used by parallelFor().
+	 */
+	static void addWorkerCpuTime(double seconds);
+
+private:
+
+	unsigned int getStageIndex(const std::string& name);
+
+	// the CPU time of the workers of the calling thread so far
+	static double& workerCpuTime();
+
+	void addCount(unsigned int stage, const std::string& name, size_t count) {
+
+		_stages[stage].counts[name] += count;
+	}
+
+	std::vector<Stage> _stages;
+};
+
+#endif // TED_EVALUATION_STAGE_METRICS_H__
+
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <util/Logger.h>
+#include "SwcReader.h"
+
+logger::LogChannel swcreaderlog("swcreaderlog", "[SwcReader] ");
+
+SwcReader::SwcReader(const std::string& path, float backgroundLabel) :
+	_path(path),
+	_backgroundLabel(backgroundLabel),
+	_skeletons(new Skeletons()) {
+
+	registerOutput(_skeletons, "skeletons");
+}
+
+void
+SwcReader::updateOutputs() {
+
+	_skeletons->clear();
+
+	std::vector<std::string> filenames;
+
+	boost::filesystem::path path(_path);
+
+	if (boost::filesystem::is_directory(path)) {
+
+		boost::filesystem::directory_iterator i(path), end;
+		for (; i != end; i++)
+			if (boost::filesystem::is_regular_file(*i) && i->path().extension() == ".swc")
+				filenames.push_back(i->path().string());
+
+		std::sort(filenames.begin(), filenames.end());
+
+	} else if (boost::filesystem::is_regular_file(path)) {
+
+		filenames.push_back(_path);
+
+	} else {
+
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				_path << " is neither an SWC file nor a directory");
+	}
+
+	float nextLabel = 1;
+	foreach (const std::string& filename, filenames)
+		readFile(filename, nextLabel);
+
+	LOG_DEBUG(swcreaderlog)
+			<< "read " << _skeletons->size() << " skeletons with "
+			<< _skeletons->numNodes() << " nodes from "
+			<< filenames.size() << " files" << std::endl;
+}
+
+void
+SwcReader::readFile(const std::string& filename, float& nextLabel) {
+
+	std::ifstream in(filename.c_str());
+
+	if (!in)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << filename);
+
+	struct SwcNode {
+
+		long  id;
+		float x, y, z;
+		long  parent;
+	};
+
+	std::vector<SwcNode>  nodes;
+	std::map<long, unsigned int> nodeIndices;
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(in, line)) {
+
+		lineNumber++;
+
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos || line[start] == '#')
+			continue;
+
+		std::istringstream fields(line);
+
+		SwcNode node;
+		int     type;
+		float   radius;
+
+		if (!(fields >> node.id >> type >> node.x >> node.y >> node.z >> radius >> node.parent))
+			UTIL_THROW_EXCEPTION(
+					SwcFormatError,
+					filename << ":" << lineNumber << ": expected <id> <type> <x> <y> <z> <radius> <parent>");
+
+		if (nodeIndices.count(node.id))
+			UTIL_THROW_EXCEPTION(
+					SwcFormatError,
+					filename << ":" << lineNumber << ": duplicate node id " << node.id);
+
+		nodeIndices[node.id] = nodes.size();
+		nodes.push_back(node);
+	}
+
+	// find the root of each node
+
+	std::vector<int> roots(nodes.size(), -1);
+
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+
+		// follow the parents until a node with known root is found
+		std::vector<unsigned int> path;
+		unsigned int current = i;
+
+		while (roots[current] < 0 && nodes[current].parent != -1) {
+
+			std::map<long, unsigned int>::const_iterator parent = nodeIndices.find(nodes[current].parent);
+
+			if (parent == nodeIndices.end())
+				UTIL_THROW_EXCEPTION(
+						SwcFormatError,
+						filename << ": node " << nodes[current].id << " has unknown parent " << nodes[current].parent);
+
+			path.push_back(current);
+			current = parent->second;
+
+			if (path.size() > nodes.size())
+				UTIL_THROW_EXCEPTION(
+						SwcFormatError,
+						filename << ": node " << nodes[i].id << " is part of a cycle");
+		}
+
+		int root = (roots[current] < 0 ? current : roots[current]);
+
+		roots[current] = root;
+		foreach (unsigned int j, path)
+			roots[j] = root;
+	}
+
+	// create one skeleton for each root, in the order of the roots
+
+	std::map<unsigned int, Skeletons::Skeleton> skeletons;
+
+	// the index of each node in its skeleton
+	std::vector<unsigned int> skeletonIndices(nodes.size());
+
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+
+		Skeletons::Skeleton& skeleton = skeletons[roots[i]];
+
+		skeletonIndices[i] = skeleton.nodes.size();
+		skeleton.nodes.push_back(Skeletons::Node(nodes[i].x, nodes[i].y, nodes[i].z));
+	}
+
+	for (unsigned int i = 0; i < nodes.size(); i++)
+		if (nodes[i].parent != -1)
+			skeletons[roots[i]].edges.push_back(
+					std::make_pair(
+							skeletonIndices[nodeIndices[nodes[i].parent]],
+							skeletonIndices[i]));
+
+	for (std::map<unsigned int, Skeletons::Skeleton>::const_iterator i = skeletons.begin(); i != skeletons.end(); i++) {
+
+		if (nextLabel == _backgroundLabel)
+			nextLabel++;
+
+		_skeletons->add(nextLabel, i->second);
+		nextLabel++;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef TED_EVALUATION_SWC_READER_H__
+#define TED_EVALUATION_SWC_READER_H__
+
+#include <string>
+#include <util/exceptions.h>
+#include <pipeline/SimpleProcessNode.h>
+#include "Skeletons.h"
+
+struct SwcFormatError : virtual Exception {};
+
+/**
+ * Reads skeletons from SWC files. Each line of an SWC file describes one node
+ * as
+ *
+ *   <id> <type> <x> <y> <z> <radius> <parent id>
+ *
+ * with a parent id of -1 for root nodes. Lines starting with '#' are
+ * comments. Each tree (i.e., each root with all its descendants) becomes a
+ * skeleton with its own label. Labels are assigned consecutively, starting
+ * with 1 and skipping the background label, in the order of the files and of
+ * the roots within a file. Node positions are expected in volume units.
+ */
+class SwcReader : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	/**
+	 * @param path
+	 *              An SWC file, or a directory from which to read all files
+	 *              with extension ".swc".
+	 *
+	 * @param backgroundLabel
+	 *              The ground truth background label, which will not be used
+	 *              for any skeleton.
+	 */
+	SwcReader(const std::string& path, float backgroundLabel = 0.0);
+
+private:
+
+	void updateOutputs();
+
+	// read all trees of one file and add them with the next free labels
+	void readFile(const std::string& filename, float& nextLabel);
+
+	std::string _path;
+
+	float _backgroundLabel;
+
+	pipeline::Output<Skeletons> _skeletons;
+};
+
+#endif // TED_EVALUATION_SWC_READER_H__
+
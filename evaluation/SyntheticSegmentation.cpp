@@ -0,0 +1,712 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <boost/cstdint.hpp>
+#include <util/exceptions.h>
+#include <util/Logger.h>
+#include "ParallelFor.h"
+#include "SyntheticSegmentation.h"
+
+logger::LogChannel syntheticsegmentationlog("syntheticsegmentationlog", "[SyntheticSegmentation] ");
+
+namespace {
+
+// the random streams of a region
+enum { JitterXStream, JitterYStream, JitterZStream, ErrorStream, NumStreams };
+
+// splitmix64, to derive independent random numbers from region indices
+boost::uint64_t mix(boost::uint64_t x) {
+
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+double distance(double x1, double y1, double z1, double x2, double y2, double z2) {
+
+	return std::sqrt((x1 - x2)*(x1 - x2) + (y1 - y2)*(y1 - y2) + (z1 - z2)*(z1 - z2));
+}
+
+size_t clampedCell(double v, double size, size_t numCells) {
+
+	double cell = std::floor(v/size);
+
+	if (cell < 0)
+		return 0;
+	if (cell >= numCells)
+		return numCells - 1;
+	return cell;
+}
+
+} // anonymous namespace
+
+SyntheticSegmentation::Parameters::Parameters() :
+	width(512),
+	height(512),
+	depth(512),
+	resolutionX(1),
+	resolutionY(1),
+	resolutionZ(1),
+	regionSize(100),
+	jitter(0.1),
+	maxBoundaryShift(10),
+	innerShift(0),
+	outerShift(0),
+	seed(0) {
+
+	std::fill(rates, rates + NumErrorTypes, 0.0);
+}
+
+SyntheticSegmentation::SyntheticSegmentation(const Parameters& parameters) :
+	_parameters(parameters),
+	_injected(NumErrorTypes, 0),
+	_skipped(NumErrorTypes, 0) {
+
+	const Parameters& p = _parameters;
+
+	if (p.width == 0 || p.height == 0 || p.depth == 0)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the volumes must not be empty");
+
+	if (p.resolutionX <= 0 || p.resolutionY <= 0 || p.resolutionZ <= 0 || p.regionSize <= 0 || p.maxBoundaryShift <= 0)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the resolution, the region size, and maxBoundaryShift have to be positive");
+
+	// with more jitter, the nearest seed of a location is not necessarily in
+	// one of the cubes around it
+	if (p.jitter < 0 || p.jitter > 0.2f)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the jitter has to be between 0 and 0.2, got " << p.jitter);
+
+	double sumRates = 0;
+	for (int type = Split; type < NumErrorTypes; type++) {
+
+		if (p.rates[type] < 0)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"the rate of " << getErrorName(ErrorType(type)) << " errors is negative");
+
+		sumRates += p.rates[type];
+	}
+
+	if (sumRates > 1)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the error rates sum up to " << sumRates << ", which is more than 1");
+
+	_flat = (p.depth == 1);
+
+	_diagonal = std::sqrt(
+			p.resolutionX*p.resolutionX +
+			p.resolutionY*p.resolutionY +
+			(_flat ? 0 : p.resolutionZ*p.resolutionZ));
+
+	_innerShift = (p.innerShift > 0 ? p.innerShift : 0.5*p.maxBoundaryShift);
+	_outerShift = (p.outerShift > 0 ? p.outerShift : p.maxBoundaryShift + 3*_diagonal);
+
+	if (_innerShift >= p.maxBoundaryShift)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the inner shift has to be less than maxBoundaryShift");
+
+	// the discretization can make a shift up to a voxel diagonal shorter,
+	// and the boundary voxels of the TED another one
+	if (_outerShift < p.maxBoundaryShift + 3*_diagonal)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the outer shift has to be at least maxBoundaryShift plus three voxel diagonals ("
+				<< p.maxBoundaryShift + 3*_diagonal << ")");
+
+	_numCellsX = std::max(1.0, std::ceil(p.width*(double)p.resolutionX/p.regionSize));
+	_numCellsY = std::max(1.0, std::ceil(p.height*(double)p.resolutionY/p.regionSize));
+	_numCellsZ = (_flat ? 1 : std::max(1.0, std::ceil(p.depth*(double)p.resolutionZ/p.regionSize)));
+	_numRegions = _numCellsX*_numCellsY*_numCellsZ;
+
+	// the labels of the regions and their split off parts have to be exact
+	// as floats
+	if (2*_numRegions + 1 > (1 << 24))
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the volumes would have " << _numRegions << " regions, which is too many for float labels -- "
+				"increase the region size");
+
+	_haveBackgroundLabel = (p.rates[FalsePositive] > 0 || p.rates[FalseNegative] > 0);
+
+	planErrors();
+}
+
+void
+SyntheticSegmentation::createSection(unsigned int z, Image& groundTruth, Image& reconstruction, unsigned int numThreads) const {
+
+	const Parameters& p = _parameters;
+
+	if (groundTruth.width() != p.width || groundTruth.height() != p.height ||
+	    reconstruction.width() != p.width || reconstruction.height() != p.height)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the sections have to be of size " << p.width << "x" << p.height);
+
+	// inner shifts look for locations within maxBoundaryShift of the section
+	double sectionZ = getLocation(0, 0, z).z;
+	SeedLayers layers = getSeedLayers(sectionZ - p.maxBoundaryShift, sectionZ + p.maxBoundaryShift);
+
+	// most of the seeds around a cube are further away from all of its
+	// locations than another one, and don't have to be checked per voxel
+	std::vector<Candidates> candidates = getCandidates(sectionZ, layers);
+
+	// each row only depends on the seeds
+	parallelFor(0, p.height, [&](size_t y) {
+
+		size_t j = clampedCell(getLocation(0, y, z).y, p.regionSize, _numCellsY);
+
+		for (unsigned int x = 0; x < p.width; x++) {
+
+			Point  location = getLocation(x, y, z);
+			size_t i        = clampedCell(location.x, p.regionSize, _numCellsX);
+			size_t region   = findRegion(location, candidates[i + _numCellsX*j]);
+
+			getLabels(x, y, z, region, layers, groundTruth(x, y), reconstruction(x, y));
+		}
+
+	}, numThreads);
+}
+
+void
+SyntheticSegmentation::writeJson(std::ostream& out) const {
+
+	const Parameters& p = _parameters;
+
+	out
+			<< "{\"splits\": " << getExpectedSplits()
+			<< ", \"merges\": " << getExpectedMerges()
+			<< ", \"falsePositives\": " << getExpectedFalsePositives()
+			<< ", \"falseNegatives\": " << getExpectedFalseNegatives()
+			<< ", \"haveBackgroundLabel\": " << (_haveBackgroundLabel ? "true" : "false")
+			<< ",\n \"regions\": " << _numRegions
+			<< ", \"width\": " << p.width
+			<< ", \"height\": " << p.height
+			<< ", \"depth\": " << p.depth
+			<< ", \"resolution\": [" << p.resolutionX << ", " << p.resolutionY << ", " << p.resolutionZ << "]"
+			<< ",\n \"regionSize\": " << p.regionSize
+			<< ", \"jitter\": " << p.jitter
+			<< ", \"maxBoundaryShift\": " << p.maxBoundaryShift
+			<< ", \"innerShift\": " << _innerShift
+			<< ", \"outerShift\": " << _outerShift
+			<< ", \"seed\": " << p.seed;
+
+	const char* lists[2] = { "injected", "skipped" };
+	const std::vector<unsigned int>* counts[2] = { &_injected, &_skipped };
+
+	for (int l = 0; l < 2; l++) {
+
+		out << ",\n \"" << lists[l] << "\": {";
+
+		for (int type = Split; type < NumErrorTypes; type++)
+			out
+					<< (type > Split ? ", " : "")
+					<< "\"" << getErrorName(ErrorType(type)) << "\": " << (*counts[l])[type];
+
+		out << "}";
+	}
+
+	out << "}" << std::endl;
+}
+
+const char*
+SyntheticSegmentation::getErrorName(ErrorType type) {
+
+	switch (type) {
+
+		case Split:         return "split";
+		case Merge:         return "merge";
+		case InnerShift:    return "innerShift";
+		case OuterShift:    return "outerShift";
+		case FalsePositive: return "falsePositive";
+		case FalseNegative: return "falseNegative";
+		default:            return "none";
+	}
+}
+
+void
+SyntheticSegmentation::planErrors() {
+
+	_errors.assign(_numRegions, NoError);
+
+	// errors are injected into every second region along each axis, their
+	// partners are the regions following them in x
+	for (size_t k = 0; k < _numCellsZ; k += 2)
+		for (size_t j = 0; j < _numCellsY; j += 2)
+			for (size_t i = 0; i + 1 < _numCellsX; i += 2) {
+
+				size_t region = getRegion(i, j, k);
+
+				// the first region is the background
+				if (_haveBackgroundLabel && region == 0)
+					continue;
+
+				ErrorType type = drawErrorType(region);
+
+				if (type == NoError)
+					continue;
+
+				if (!isFeasible(type, i, j, k)) {
+
+					_skipped[type]++;
+					continue;
+				}
+
+				_errors[region] = type;
+				_injected[type]++;
+			}
+
+	LOG_DEBUG(syntheticsegmentationlog)
+			<< "created " << _numCellsX << "x" << _numCellsY << "x" << _numCellsZ << " regions, expecting "
+			<< getExpectedSplits() << " splits, " << getExpectedMerges() << " merges, "
+			<< getExpectedFalsePositives() << " false positives, and "
+			<< getExpectedFalseNegatives() << " false negatives" << std::endl;
+}
+
+SyntheticSegmentation::ErrorType
+SyntheticSegmentation::drawErrorType(size_t region) const {
+
+	double r = random(region, ErrorStream);
+
+	for (int type = Split; type < NumErrorTypes; type++) {
+
+		if (r < _parameters.rates[type])
+			return ErrorType(type);
+
+		r -= _parameters.rates[type];
+	}
+
+	return NoError;
+}
+
+bool
+SyntheticSegmentation::isFeasible(ErrorType type, size_t i, size_t j, size_t k) const {
+
+	// A location deeper than maxBoundaryShift plus two voxel diagonals in a
+	// region is not within maxBoundaryShift of any boundary voxel, even after
+	// discretization. A cell containing it can not be relabeled.
+
+	double margin = _parameters.maxBoundaryShift + 2*_diagonal;
+
+	switch (type) {
+
+		// both parts have a location deeper than margin, half way between the
+		// seed and the largest ball around it
+		case Split:
+			return getInnerRadius(i, j, k) > 2*margin;
+
+		case Merge:
+			return getInnerRadius(i, j, k) > margin && getInnerRadius(i + 1, j, k) > margin;
+
+		// the background region must not be relabeled either, otherwise the
+		// TED could give it the label of a false positive
+		case FalsePositive:
+		case FalseNegative:
+			return getInnerRadius(i, j, k) > margin && getInnerRadius(0, 0, 0) > margin;
+
+		// the regions have to touch, the locations that can not be moved back
+		// are skipped
+		case InnerShift:
+			return getFaceMargin(i, j, k) > 0;
+
+		// the shifted part has a location deeper than margin next to the
+		// center between the seeds, and the rest of the partner is still
+		// deeper than margin
+		case OuterShift:
+			return
+					getInnerRadius(i, j, k) > margin &&
+					getInnerRadius(i + 1, j, k) > _outerShift + margin &&
+					getFaceMargin(i, j, k) >= margin + _diagonal;
+
+		default:
+			return true;
+	}
+}
+
+double
+SyntheticSegmentation::getInnerRadius(size_t i, size_t j, size_t k) const {
+
+	Point seed = getSeed(i, j, k);
+
+	double radius = getBorderDistance(seed);
+
+	// the nearest seeds are in the neighboring cubes
+	for (size_t nk = (k > 0 ? k - 1 : 0); nk <= std::min(k + 1, _numCellsZ - 1); nk++)
+		for (size_t nj = (j > 0 ? j - 1 : 0); nj <= std::min(j + 1, _numCellsY - 1); nj++)
+			for (size_t ni = (i > 0 ? i - 1 : 0); ni <= std::min(i + 1, _numCellsX - 1); ni++) {
+
+				if (ni == i && nj == j && nk == k)
+					continue;
+
+				Point other = getSeed(ni, nj, nk);
+				radius = std::min(radius, 0.5*distance(seed.x, seed.y, seed.z, other.x, other.y, other.z));
+			}
+
+	return radius;
+}
+
+double
+SyntheticSegmentation::getFaceMargin(size_t i, size_t j, size_t k) const {
+
+	Point seed    = getSeed(i, j, k);
+	Point partner = getSeed(i + 1, j, k);
+	Point center(0.5*(seed.x + partner.x), 0.5*(seed.y + partner.y), 0.5*(seed.z + partner.z));
+
+	double margin = getBorderDistance(center);
+
+	// all regions that can be within half a region size of the center
+	for (size_t nk = (k > 1 ? k - 2 : 0); nk <= std::min(k + 2, _numCellsZ - 1); nk++)
+		for (size_t nj = (j > 1 ? j - 2 : 0); nj <= std::min(j + 2, _numCellsY - 1); nj++)
+			for (size_t ni = (i > 1 ? i - 2 : 0); ni <= std::min(i + 3, _numCellsX - 1); ni++) {
+
+				if ((ni == i || ni == i + 1) && nj == j && nk == k)
+					continue;
+
+				Point other = getSeed(ni, nj, nk);
+
+				margin = std::min(margin, bisectorDistance(center, other, seed));
+				margin = std::min(margin, bisectorDistance(center, other, partner));
+			}
+
+	return margin;
+}
+
+double
+SyntheticSegmentation::getBorderDistance(const Point& p) const {
+
+	const Parameters& params = _parameters;
+
+	double d = std::min(
+			std::min(p.x, (params.width  - 1)*params.resolutionX - p.x),
+			std::min(p.y, (params.height - 1)*params.resolutionY - p.y));
+
+	// the first and last section are only a border if there are several
+	if (!_flat)
+		d = std::min(d, std::min(p.z, (params.depth - 1)*params.resolutionZ - p.z));
+
+	return d;
+}
+
+SyntheticSegmentation::SeedLayers
+SyntheticSegmentation::getSeedLayers(double minZ, double maxZ) const {
+
+	SeedLayers layers;
+
+	layers.numX = _numCellsX;
+	layers.numY = _numCellsY;
+
+	// the nearest seeds of locations in [minZ, maxZ] are in the layers of
+	// these locations, or the ones next to them
+	layers.minK = clampedCell(minZ, _parameters.regionSize, _numCellsZ);
+	layers.maxK = clampedCell(maxZ, _parameters.regionSize, _numCellsZ);
+
+	if (layers.minK > 0)
+		layers.minK--;
+	if (layers.maxK + 1 < _numCellsZ)
+		layers.maxK++;
+
+	layers.seeds.resize(_numCellsX*_numCellsY*(layers.maxK - layers.minK + 1));
+
+	for (size_t k = layers.minK; k <= layers.maxK; k++)
+		for (size_t j = 0; j < _numCellsY; j++)
+			for (size_t i = 0; i < _numCellsX; i++)
+				layers.seeds[i + _numCellsX*(j + _numCellsY*(k - layers.minK))] = getSeed(i, j, k);
+
+	return layers;
+}
+
+std::vector<SyntheticSegmentation::Candidates>
+SyntheticSegmentation::getCandidates(double z, const SeedLayers& layers) const {
+
+	double regionSize = _parameters.regionSize;
+
+	size_t k = std::max(layers.minK, std::min(layers.maxK, clampedCell(z, regionSize, _numCellsZ)));
+
+	std::vector<Candidates> candidates(_numCellsX*_numCellsY);
+
+	for (size_t j = 0; j < _numCellsY; j++)
+		for (size_t i = 0; i < _numCellsX; i++) {
+
+			// the part of the plane covered by the cube
+			double minX = i*regionSize;
+			double maxX = minX + regionSize;
+			double minY = j*regionSize;
+			double maxY = minY + regionSize;
+
+			Candidates neighbors;
+			std::vector<double> minDists;
+
+			// every location of the cube is at most this far from its nearest
+			// seed
+			double bound = std::numeric_limits<double>::max();
+
+			// in the order of findRegion(), to break ties the same way
+			for (size_t nk = (k > layers.minK ? k - 1 : k); nk <= std::min(k + 1, layers.maxK); nk++)
+				for (size_t nj = (j > 0 ? j - 1 : 0); nj <= std::min(j + 1, _numCellsY - 1); nj++)
+					for (size_t ni = (i > 0 ? i - 1 : 0); ni <= std::min(i + 1, _numCellsX - 1); ni++) {
+
+						const Point& seed = layers.get(ni, nj, nk);
+
+						double nearX = std::max(0.0, std::max(minX - seed.x, seed.x - maxX));
+						double nearY = std::max(0.0, std::max(minY - seed.y, seed.y - maxY));
+						double farX  = std::max(seed.x - minX, maxX - seed.x);
+						double farY  = std::max(seed.y - minY, maxY - seed.y);
+						double dz2   = (z - seed.z)*(z - seed.z);
+
+						neighbors.push_back(std::make_pair(getRegion(ni, nj, nk), seed));
+						minDists.push_back(nearX*nearX + nearY*nearY + dz2);
+						bound = std::min(bound, farX*farX + farY*farY + dz2);
+					}
+
+			for (size_t n = 0; n < neighbors.size(); n++)
+				if (minDists[n] <= bound)
+					candidates[i + _numCellsX*j].push_back(neighbors[n]);
+		}
+
+	return candidates;
+}
+
+size_t
+SyntheticSegmentation::findRegion(const Point& p, const Candidates& candidates) const {
+
+	size_t nearest     = 0;
+	double nearestDist = std::numeric_limits<double>::max();
+
+	for (size_t n = 0; n < candidates.size(); n++) {
+
+		const Point& seed = candidates[n].second;
+
+		double dist =
+				(p.x - seed.x)*(p.x - seed.x) +
+				(p.y - seed.y)*(p.y - seed.y) +
+				(p.z - seed.z)*(p.z - seed.z);
+
+		if (dist < nearestDist) {
+
+			nearestDist = dist;
+			nearest     = candidates[n].first;
+		}
+	}
+
+	return nearest;
+}
+
+size_t
+SyntheticSegmentation::findRegion(const Point& p, const SeedLayers& layers) const {
+
+	double regionSize = _parameters.regionSize;
+
+	size_t i = clampedCell(p.x, regionSize, _numCellsX);
+	size_t j = clampedCell(p.y, regionSize, _numCellsY);
+	size_t k = std::max(layers.minK, std::min(layers.maxK, clampedCell(p.z, regionSize, _numCellsZ)));
+
+	size_t nearest     = 0;
+	double nearestDist = std::numeric_limits<double>::max();
+
+	for (size_t nk = (k > layers.minK ? k - 1 : k); nk <= std::min(k + 1, layers.maxK); nk++)
+		for (size_t nj = (j > 0 ? j - 1 : 0); nj <= std::min(j + 1, _numCellsY - 1); nj++)
+			for (size_t ni = (i > 0 ? i - 1 : 0); ni <= std::min(i + 1, _numCellsX - 1); ni++) {
+
+				const Point& seed = layers.get(ni, nj, nk);
+
+				double dist =
+						(p.x - seed.x)*(p.x - seed.x) +
+						(p.y - seed.y)*(p.y - seed.y) +
+						(p.z - seed.z)*(p.z - seed.z);
+
+				if (dist < nearestDist) {
+
+					nearestDist = dist;
+					nearest     = getRegion(ni, nj, nk);
+				}
+			}
+
+	return nearest;
+}
+
+void
+SyntheticSegmentation::getLabels(
+		unsigned int x, unsigned int y, unsigned int z,
+		size_t region,
+		const SeedLayers& layers,
+		float& gtLabel,
+		float& recLabel) const {
+
+	Point location = getLocation(x, y, z);
+
+	gtLabel = recLabel = getLabel(region);
+
+	if (_haveBackgroundLabel && region == 0) {
+
+		gtLabel = recLabel = 0;
+		return;
+	}
+
+	size_t i = region%_numCellsX;
+	size_t j = (region/_numCellsX)%_numCellsY;
+	size_t k = region/(_numCellsX*_numCellsY);
+
+	switch (_errors[region]) {
+
+		case Split:
+			if (location.x > layers.get(i, j, k).x)
+				recLabel = getSplitLabel(region);
+			return;
+
+		case FalsePositive:
+			gtLabel = 0;
+			return;
+
+		case FalseNegative:
+			recLabel = 0;
+			return;
+
+		default:
+			break;
+	}
+
+	// is this the partner of a region with an error?
+
+	if (i == 0)
+		return;
+
+	size_t eligible = region - 1;
+
+	switch (_errors[eligible]) {
+
+		case Merge:
+			recLabel = getLabel(eligible);
+			return;
+
+		case InnerShift:
+		case OuterShift: {
+
+			const Point& seed    = layers.get(i - 1, j, k);
+			const Point& partner = layers.get(i, j, k);
+
+			double shift = (_errors[eligible] == InnerShift ? _innerShift : _outerShift);
+
+			if (bisectorDistance(location, seed, partner) >= shift)
+				return;
+
+			if (_errors[eligible] == OuterShift || canShiftBack(x, y, z, seed, partner, region, layers))
+				recLabel = getLabel(eligible);
+
+			return;
+		}
+
+		default:
+			return;
+	}
+}
+
+bool
+SyntheticSegmentation::canShiftBack(
+		unsigned int x, unsigned int y, unsigned int z,
+		const Point& seed,
+		const Point& partnerSeed,
+		size_t partner,
+		const SeedLayers& layers) const {
+
+	// The TED can relabel a cell to the partner label, if each of its
+	// locations has a boundary voxel of the partner label in its neighborhood.
+	// If there is a location of the unchanged partner within the
+	// neighborhood, there is such a boundary voxel on each face-connected path
+	// to it, and the path is inside the neighborhood. We look for the
+	// unchanged partner along the normal of the shifted boundary.
+
+	const Parameters& p = _parameters;
+
+	double threshold  = p.maxBoundaryShift;
+	double threshold2 = threshold*threshold;
+
+	// the neighborhood of the TED is limited to the rounded thresholds per
+	// axis
+	int maxX = round(threshold/p.resolutionX);
+	int maxY = round(threshold/p.resolutionY);
+	int maxZ = (_flat ? 0 : (int)round(threshold/p.resolutionZ));
+
+	Point  location = getLocation(x, y, z);
+	double length   = distance(seed.x, seed.y, seed.z, partnerSeed.x, partnerSeed.y, partnerSeed.z);
+	Point  normal((partnerSeed.x - seed.x)/length, (partnerSeed.y - seed.y)/length, (partnerSeed.z - seed.z)/length);
+
+	double step = 0.5*std::min(p.resolutionX, p.resolutionY);
+	if (!_flat)
+		step = std::min(step, 0.5*p.resolutionZ);
+
+	double start = std::max(0.0, _innerShift - bisectorDistance(location, seed, partnerSeed));
+
+	for (double t = start; t <= threshold; t += step) {
+
+		int ux = round((location.x + t*normal.x)/p.resolutionX);
+		int uy = round((location.y + t*normal.y)/p.resolutionY);
+		int uz = (_flat ? 0 : (int)round((location.z + t*normal.z)/p.resolutionZ));
+
+		if (ux < 0 || ux >= (int)p.width || uy < 0 || uy >= (int)p.height || uz < 0 || uz >= (int)p.depth)
+			continue;
+
+		int dx = ux - (int)x;
+		int dy = uy - (int)y;
+		int dz = uz - (int)z;
+
+		if (std::abs(dx) > maxX || std::abs(dy) > maxY || std::abs(dz) > maxZ)
+			continue;
+
+		if (dx*p.resolutionX*dx*p.resolutionX + dy*p.resolutionY*dy*p.resolutionY + dz*p.resolutionZ*dz*p.resolutionZ > threshold2)
+			continue;
+
+		Point other = getLocation(ux, uy, uz);
+
+		if (findRegion(other, layers) == partner && bisectorDistance(other, seed, partnerSeed) >= _innerShift)
+			return true;
+	}
+
+	return false;
+}
+
+double
+SyntheticSegmentation::bisectorDistance(const Point& p, const Point& a, const Point& b) {
+
+	double da2 = (p.x - a.x)*(p.x - a.x) + (p.y - a.y)*(p.y - a.y) + (p.z - a.z)*(p.z - a.z);
+	double db2 = (p.x - b.x)*(p.x - b.x) + (p.y - b.y)*(p.y - b.y) + (p.z - b.z)*(p.z - b.z);
+
+	return (da2 - db2)/(2*distance(a.x, a.y, a.z, b.x, b.y, b.z));
+}
+
+SyntheticSegmentation::Point
+SyntheticSegmentation::getSeed(size_t i, size_t j, size_t k) const {
+
+	size_t region     = getRegion(i, j, k);
+	double regionSize = _parameters.regionSize;
+	double jitter     = _parameters.jitter;
+
+	return Point(
+			regionSize*(i + 0.5 + jitter*(2*random(region, JitterXStream) - 1)),
+			regionSize*(j + 0.5 + jitter*(2*random(region, JitterYStream) - 1)),
+			(_flat ? 0 : regionSize*(k + 0.5 + jitter*(2*random(region, JitterZStream) - 1))));
+}
+
+SyntheticSegmentation::Point
+SyntheticSegmentation::getLocation(unsigned int x, unsigned int y, unsigned int z) const {
+
+	return Point(
+			x*_parameters.resolutionX,
+			y*_parameters.resolutionY,
+			(_flat ? 0 : z*_parameters.resolutionZ));
+}
+
+double
+SyntheticSegmentation::random(size_t region, unsigned int stream) const {
+
+	boost::uint64_t bits = mix(mix(_parameters.seed) + static_cast<boost::uint64_t>(region)*NumStreams + stream);
+
+	// the upper 53 bits as a double in [0, 1)
+	return (bits >> 11)*(1.0/9007199254740992.0);
+}
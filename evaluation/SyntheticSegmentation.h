@@ -0,0 +1,256 @@
+#ifndef TED_EVALUATION_SYNTHETIC_SEGMENTATION_H__
+#define TED_EVALUATION_SYNTHETIC_SEGMENTATION_H__
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <imageprocessing/Image.h>
+
+/**
+ * A synthetic ground truth of supervoxel-like regions and a reconstruction
+ * with injected errors, for which the result of the TED is known.
+ *
+ * The ground truth is the Voronoi tessellation of seeds that are jittered
+ * around the centers of a grid of cubes with the edge length of the region
+ * size. The labels of a location only depend on the seeds of the cubes
+ * around it, such that the volumes can be created one section at a time and
+ * never have to fit into memory.
+ *
+ * Errors are injected into every second region along each axis (the
+ * eligible regions), and into the region that follows it in x (its
+ * partner). Thus, no two errors touch each other. For each eligible region,
+ * one of the following errors is drawn with the given rates:
+ *
+ *   Split          the part of the region beyond the plane through its seed
+ *                  (perpendicular to x) gets a new label
+ *   Merge          the partner gets the label of the region
+ *   InnerShift     the boundary to the partner is moved into the partner by
+ *                  less than maxBoundaryShift, which the TED tolerates
+ *   OuterShift     the same, but by more than maxBoundaryShift, which is one
+ *                  split and one merge
+ *   FalsePositive  the region is background in the ground truth
+ *   FalseNegative  the region is background in the reconstruction
+ *
+ * An error is only injected if the geometry of the regions guarantees its
+ * count in the TED, e.g., the parts of a split region have to reach further
+ * than maxBoundaryShift from each other and from other regions. Inner
+ * shifts only move locations that the TED can move back. The other errors
+ * are skipped and counted.
+ *
+ * If false positives or false negatives are requested, the first region is
+ * background (label 0) in both volumes, and the TED has to be run with a
+ * background label of 0. The counts assume that the TED is run with the
+ * same resolution and maxBoundaryShift.
+ */
+class SyntheticSegmentation {
+
+public:
+
+	enum ErrorType {
+
+		NoError = 0,
+		Split,
+		Merge,
+		InnerShift,
+		OuterShift,
+		FalsePositive,
+		FalseNegative,
+		NumErrorTypes
+	};
+
+	struct Parameters {
+
+		Parameters();
+
+		// the size of the volumes in voxels
+		unsigned int width;
+		unsigned int height;
+		unsigned int depth;
+
+		// the size of a voxel in world units
+		float resolutionX;
+		float resolutionY;
+		float resolutionZ;
+
+		// the edge length of the cubes the seeds are placed in, in world
+		// units
+		float regionSize;
+
+		// the maximal displacement of a seed from the center of its cube
+		// along each axis, as a fraction of the region size (at most 0.2)
+		float jitter;
+
+		// the tolerance of the TED the errors are made for
+		float maxBoundaryShift;
+
+		// the distances by which boundaries are shifted, 0 for half of
+		// maxBoundaryShift and for the smallest distance that is guaranteed
+		// to be beyond it
+		float innerShift;
+		float outerShift;
+
+		// the probability of each error type for an eligible region
+		double rates[NumErrorTypes];
+
+		unsigned int seed;
+	};
+
+	SyntheticSegmentation(const Parameters& parameters);
+
+	/**
+	 * Create section z of the ground truth and the reconstruction. The images
+	 * have to be of the size of the volumes. Sections can be created in any
+	 * order.
+	 */
+	void createSection(unsigned int z, Image& groundTruth, Image& reconstruction, unsigned int numThreads = 0) const;
+
+	/**
+	 * Whether the volumes contain the background label 0.
+	 */
+	bool haveBackgroundLabel() const { return _haveBackgroundLabel; }
+
+	/**
+	 * The number of ground truth regions.
+	 */
+	size_t getNumRegions() const { return _numRegions; }
+
+	/**
+	 * The number of injected and skipped errors of the given type.
+	 */
+	unsigned int getNumInjected(ErrorType type) const { return _injected[type]; }
+	unsigned int getNumSkipped(ErrorType type) const { return _skipped[type]; }
+
+	/**
+	 * The error counts the TED is expected to report.
+	 */
+	unsigned int getExpectedSplits() const { return _injected[Split] + _injected[OuterShift]; }
+	unsigned int getExpectedMerges() const { return _injected[Merge] + _injected[OuterShift]; }
+	unsigned int getExpectedFalsePositives() const { return _injected[FalsePositive]; }
+	unsigned int getExpectedFalseNegatives() const { return _injected[FalseNegative]; }
+
+	/**
+	 * Write the expected error counts, the injected and skipped errors, and
+	 * the parameters as a JSON object.
+	 */
+	void writeJson(std::ostream& out) const;
+
+	static const char* getErrorName(ErrorType type);
+
+private:
+
+	struct Point {
+
+		Point() : x(0), y(0), z(0) {}
+		Point(double x_, double y_, double z_) : x(x_), y(y_), z(z_) {}
+
+		double x, y, z;
+	};
+
+	/**
+	 * The seeds of all cubes in a range of cube layers in z.
+	 */
+	struct SeedLayers {
+
+		const Point& get(size_t i, size_t j, size_t k) const { return seeds[i + numX*(j + numY*(k - minK))]; }
+
+		size_t numX;
+		size_t numY;
+		size_t minK;
+		size_t maxK;
+
+		std::vector<Point> seeds;
+	};
+
+	// regions and their seeds
+	typedef std::vector<std::pair<size_t, Point> > Candidates;
+
+	void planErrors();
+
+	ErrorType drawErrorType(size_t region) const;
+
+	bool isFeasible(ErrorType type, size_t i, size_t j, size_t k) const;
+
+	// the radius of the largest ball around the seed of a region that is
+	// inside the region and the volume
+	double getInnerRadius(size_t i, size_t j, size_t k) const;
+
+	// the distance of the center between the seeds of an eligible region and
+	// its partner to the boundaries of all other regions and the volume
+	double getFaceMargin(size_t i, size_t j, size_t k) const;
+
+	// the distance of a point to the borders of the volume
+	double getBorderDistance(const Point& p) const;
+
+	SeedLayers getSeedLayers(double minZ, double maxZ) const;
+
+	// for each cube, the seeds that can be the nearest to a location of the
+	// cube in the plane at z
+	std::vector<Candidates> getCandidates(double z, const SeedLayers& layers) const;
+
+	size_t findRegion(const Point& p, const SeedLayers& layers) const;
+
+	size_t findRegion(const Point& p, const Candidates& candidates) const;
+
+	void getLabels(
+			unsigned int x, unsigned int y, unsigned int z,
+			size_t region,
+			const SeedLayers& layers,
+			float& gtLabel,
+			float& recLabel) const;
+
+	// whether an inner shift location can be moved back by the TED, i.e.,
+	// whether there is a location of the partner that stays with the partner
+	// within maxBoundaryShift
+	bool canShiftBack(
+			unsigned int x, unsigned int y, unsigned int z,
+			const Point& seed,
+			const Point& partnerSeed,
+			size_t partner,
+			const SeedLayers& layers) const;
+
+	// the signed distance of p to the bisector of a and b, positive on the
+	// side of b
+	static double bisectorDistance(const Point& p, const Point& a, const Point& b);
+
+	Point getSeed(size_t i, size_t j, size_t k) const;
+
+	Point getLocation(unsigned int x, unsigned int y, unsigned int z) const;
+
+	size_t getRegion(size_t i, size_t j, size_t k) const { return i + _numCellsX*(j + _numCellsY*k); }
+
+	float getLabel(size_t region) const { return region + 1; }
+
+	float getSplitLabel(size_t region) const { return _numRegions + region + 1; }
+
+	// a uniform random number in [0, 1) for each region and stream
+	double random(size_t region, unsigned int stream) const;
+
+	Parameters _parameters;
+
+	// the volumes have a single section, and the seeds are in its plane
+	bool _flat;
+
+	// the length of a voxel diagonal, as a safety margin for discretization
+	double _diagonal;
+
+	double _innerShift;
+	double _outerShift;
+
+	size_t _numCellsX;
+	size_t _numCellsY;
+	size_t _numCellsZ;
+	size_t _numRegions;
+
+	bool _haveBackgroundLabel;
+
+	// the error type of each region
+	std::vector<unsigned char> _errors;
+
+	std::vector<unsigned int> _injected;
+	std::vector<unsigned int> _skipped;
+};
+
+#endif // TED_EVALUATION_SYNTHETIC_SEGMENTATION_H__
+
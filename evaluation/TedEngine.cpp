@@ -0,0 +1,1433 @@
+#include <algorithm>
+#include <cmath>
+
+#include <boost/tuple/tuple.hpp>
+#include <vigra/multi_labeling.hxx>
+
+#include <inference/DefaultFactory.h>
+#include <util/exceptions.h>
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "TedEngine.h"
+#include "DistanceToleranceFunction.h"
+#include "SkeletonToleranceFunction.h"
+#include "SkeletonGraphToleranceFunction.h"
+
+logger::LogChannel tedenginelog("tedenginelog", "[TedEngine] ");
+
+util::ProgramOption optionGroundTruthFromSkeletons(
+		util::_module           = "evaluation",
+		util::_long_name        = "groundTruthFromSkeletons",
+		util::_description_text = "Indicates that the ground-truth consists of skeletons only.");
+
+util::ProgramOption optionToleranceDistanceThreshold(
+		util::_module           = "evaluation",
+		util::_long_name        = "maxBoundaryShift",
+		util::_description_text = "The maximum allowed distance for a boundary shift in image stack units. The default number of units per voxel is 1.0. "
+		                          "This can be changed by placing a file META in the image stack directory, with the keys 'resX=<..>', "
+		                          "'resY=<...>', and 'resZ=<...>', which give the number of units per edge of a voxel.",
+		util::_default_value    = 10);
+
+util::ProgramOption optionHaveBackgroundLabel(
+		util::_module           = "evaluation",
+		util::_long_name        = "haveBackgroundLabel",
+		util::_description_text = "Indicates that there is a background label with a default value of 0.",
+		util::_default_value    = false);
+
+util::ProgramOption optionGroundTruthBackgroundLabel(
+		util::_module           = "evaluation",
+		util::_long_name        = "groundTruthBackgroundLabel",
+		util::_description_text = "The value of the ground-truth background label.",
+		util::_default_value    = 0.0);
+
+util::ProgramOption optionReconstructionBackgroundLabel(
+		util::_module           = "evaluation",
+		util::_long_name        = "reconstructionBackgroundLabel",
+		util::_description_text = "The value of the reconstruction background label.",
+		util::_default_value    = 0.0);
+
+util::ProgramOption optionSliceWise(
+		util::_module           = "evaluation",
+		util::_long_name        = "sliceWise",
+		util::_description_text = "Apply the tolerance criterion within each section only. This is done automatically if maxBoundaryShift is less "
+		                          "than half the z resolution, since then no other section is within reach.");
+
+util::ProgramOption optionNumThreads(
+		util::_module           = "evaluation",
+		util::_long_name        = "numThreads",
+		util::_description_text = "The number of threads to use for finding alternative cell labels. The default (0) uses all available CPUs.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionTieBreakTime(
+		util::_module           = "evaluation",
+		util::_long_name        = "tieBreakTime",
+		util::_description_text = "Stop the ILP solver as soon as the split and merge counts are proven, and continue to minimize the "
+		                          "number of relabeled locations (the tie-break) for at most this many seconds. The counts are the "
+		                          "same, but the reported errors and the corrected reconstruction might differ from those of the "
+		                          "optimal tie-break. With a negative value (the default), the ILP is solved to optimality. Only "
+		                          "supported by the Gurobi backend (also as an arm of the portfolio), other backends always solve "
+		                          "to optimality.",
+		util::_default_value    = -1.0);
+
+util::ProgramOption optionIncrementalUpdates(
+		util::_module           = "evaluation",
+		util::_long_name        = "incrementalUpdates",
+		util::_description_text = "Keep the cell id of each location after an evaluation (4 bytes per location), such that the TED can "
+		                          "be updated after local changes of the reconstruction (TolerantEditDistance::updateReconstruction()).");
+
+// defined in LinearSolver.cpp
+extern util::ProgramOption optionPresolve;
+
+namespace {
+
+// The objective of the TED ILP is twice the number of matches plus the
+// tie-break, which is less than one. Solutions with fewer matches (i.e.,
+// fewer errors) than the incumbent have values below 2*matches - 1. Thus,
+// the counts of the incumbent are final once the bound passes this, which we
+// check with half a unit of slack for the tolerances of the solver.
+bool
+countsProven(double bound, double incumbent) {
+
+	double matches = std::floor(incumbent/2 + 0.25);
+
+	return bound >= 2*matches - 0.5;
+}
+
+} // anonymous namespace
+
+TedEngine::Options::Options() :
+	maxBoundaryShift(10),
+	haveBackgroundLabel(false),
+	gtBackgroundLabel(0),
+	recBackgroundLabel(0),
+	groundTruthFromSkeletons(false),
+	sliceWise(false),
+	numThreads(0),
+	presolve(false),
+	tieBreakTime(-1),
+	incrementalUpdates(false),
+	computeVolumes(true) {}
+
+TedEngine::Options
+TedEngine::Options::fromProgramOptions() {
+
+	Options options;
+
+	options.maxBoundaryShift         = optionToleranceDistanceThreshold.as<float>();
+	options.haveBackgroundLabel      = optionHaveBackgroundLabel;
+	options.gtBackgroundLabel        = optionGroundTruthBackgroundLabel;
+	options.recBackgroundLabel       = optionReconstructionBackgroundLabel;
+	options.groundTruthFromSkeletons = optionGroundTruthFromSkeletons;
+	options.sliceWise                = optionSliceWise;
+	options.numThreads               = optionNumThreads.as<unsigned int>();
+	options.presolve                 = optionPresolve;
+	options.tieBreakTime             = optionTieBreakTime.as<double>();
+	options.incrementalUpdates       = optionIncrementalUpdates;
+
+	return options;
+}
+
+bool
+TedEngine::Options::operator==(const Options& other) const {
+
+	return
+			maxBoundaryShift         == other.maxBoundaryShift &&
+			haveBackgroundLabel      == other.haveBackgroundLabel &&
+			gtBackgroundLabel        == other.gtBackgroundLabel &&
+			recBackgroundLabel       == other.recBackgroundLabel &&
+			groundTruthFromSkeletons == other.groundTruthFromSkeletons &&
+			sliceWise                == other.sliceWise &&
+			numThreads               == other.numThreads &&
+			presolve                 == other.presolve &&
+			tieBreakTime             == other.tieBreakTime &&
+			incrementalUpdates       == other.incrementalUpdates &&
+			computeVolumes           == other.computeVolumes;
+}
+
+TedEngine::Workspace::Workspace() :
+	_skeletonGraphs(false),
+	_toleranceFunction(0),
+	_skeletonGraphToleranceFunction(0),
+	_width(0),
+	_height(0),
+	_depth(0),
+	_numCells(0),
+	_indicatorVarsByRecLabel(_arena),
+	_indicatorVarsByGtToRecLabel(_arena),
+	_labelingByVar(_arena),
+	_matchVars(_arena),
+	_numIndicatorVars(0),
+	_solver(0),
+	_errors(boost::make_shared<TolerantEditDistanceErrors>()),
+	_correctedReconstruction(boost::make_shared<ImageStack>()),
+	_splitLocations(boost::make_shared<ImageStack>()),
+	_mergeLocations(boost::make_shared<ImageStack>()),
+	_fpLocations(boost::make_shared<ImageStack>()),
+	_fnLocations(boost::make_shared<ImageStack>()),
+	_metrics(boost::make_shared<StageMetrics>()),
+	_exact(true) {}
+
+TedEngine::Workspace::~Workspace() {
+
+	delete _toleranceFunction;
+	delete _solver;
+}
+
+TedEngine::TedEngine(const Options& options) :
+	_options(options) {}
+
+void
+TedEngine::evaluate(
+		const ImageStack& groundTruth,
+		const ImageStack& reconstruction,
+		Workspace&        w) const {
+
+	prepare(w, false);
+
+	clear(w);
+
+	w._metrics->clear();
+	StageMetrics::Timer timer(w._metrics.get(), "evaluate");
+
+	w._exact = true;
+
+	extractCells(w, groundTruth, reconstruction);
+
+	findBestCellLabels(w);
+
+	correctReconstruction(w);
+
+	findErrors(w);
+}
+
+void
+TedEngine::evaluate(
+		const Skeletons&  skeletons,
+		const ImageStack& reconstruction,
+		Workspace&        w) const {
+
+	prepare(w, true);
+
+	clear(w);
+
+	w._metrics->clear();
+	StageMetrics::Timer timer(w._metrics.get(), "evaluate");
+
+	w._exact = true;
+
+	extractSkeletonCells(w, skeletons, reconstruction);
+
+	findBestCellLabels(w);
+
+	correctReconstruction(w);
+
+	findErrors(w);
+}
+
+void
+TedEngine::updateReconstruction(
+		const ImageStack&       groundTruth,
+		const ImageStack&       reconstruction,
+		const cell_t::Location& changedMin,
+		const cell_t::Location& changedMax,
+		Workspace&              w) const {
+
+	if (w._skeletonGraphs)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"updates of the reconstruction need the ground truth as an image stack");
+
+	if (!_options.incrementalUpdates)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"updates of the reconstruction need the option incrementalUpdates");
+
+	if (w._cellIds.size() == 0 || w._options != _options)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the reconstruction has to be evaluated with the same options before it can be updated");
+
+	cell_t::Location min(
+			std::max(0, changedMin.x),
+			std::max(0, changedMin.y),
+			std::max(0, changedMin.z));
+	cell_t::Location max(
+			std::min((int)w._width  - 1, changedMax.x),
+			std::min((int)w._height - 1, changedMax.y),
+			std::min((int)w._depth  - 1, changedMax.z));
+
+	w._metrics->clear();
+
+	if (min.x > max.x || min.y > max.y || min.z > max.z)
+		return;
+
+	StageMetrics::Timer timer(w._metrics.get(), "update reconstruction");
+
+	StageMetrics::Timer cellsTimer(w._metrics.get(), "update cells");
+
+	// the background matches of the previous cells, to find out whether
+	// the cells that are not solved again depend on the changed ones
+	std::vector<std::pair<float, float> > previousMatches;
+	if (w._errors->hasBackgroundLabel()) {
+
+		const std::vector<cell_t>& cells = *w._toleranceFunction->getCells();
+
+		for (unsigned int i = 0; i < cells.size(); i++)
+			previousMatches.push_back(std::make_pair(cells[i].getGroundTruthLabel(), w._cellLabels[i]));
+	}
+
+	LocalToleranceFunction::CellUpdate update = w._toleranceFunction->updateCells(
+			w._cellIds,
+			reconstruction,
+			groundTruth,
+			min,
+			max);
+
+	w._numCells = w._toleranceFunction->getCells()->size();
+
+	cellsTimer.addCount("cells", w._numCells);
+	cellsTimer.addCount("added cells", update.addedCells.size());
+	cellsTimer.stop();
+
+	// the kept cells keep their labels
+	std::vector<float> cellLabels(w._numCells);
+	for (unsigned int i = 0; i < update.previousToCurrent.size(); i++)
+		if (update.previousToCurrent[i] >= 0)
+			cellLabels[update.previousToCurrent[i]] = w._cellLabels[i];
+	w._cellLabels.swap(cellLabels);
+
+	// The ILP falls apart into problems for each connected component of the
+	// possible matches, which share the background labels only. Only the
+	// ones that contain labels of the changed cells have to be solved again.
+	std::vector<unsigned int> changedCells = findConnectedCells(w, update);
+
+	LOG_DEBUG(tedenginelog)
+			<< "solving the ILP again for " << changedCells.size() << " of " << w._numCells
+			<< " cells" << std::endl;
+
+	clearIlp(w);
+	findBestCellLabels(w, changedCells);
+
+	w._exact = true;
+
+	if (w._errors->hasBackgroundLabel() && changedCells.size() < w._numCells) {
+
+		const std::vector<cell_t>& cells = *w._toleranceFunction->getCells();
+
+		std::vector<char> solved(w._numCells, false);
+		foreach (unsigned int cellIndex, changedCells)
+			solved[cellIndex] = true;
+
+		// the background matches the kept cells were labeled against, i.e.,
+		// those of the previous cells that were solved again or removed...
+		std::set<std::pair<float, float> > before;
+		for (unsigned int i = 0; i < previousMatches.size(); i++) {
+
+			int current = update.previousToCurrent[i];
+
+			if (current < 0 || solved[current])
+				if (isBackgroundMatch(previousMatches[i]))
+					before.insert(previousMatches[i]);
+		}
+
+		// ...and the ones of the solved cells now
+		std::set<std::pair<float, float> > after;
+		foreach (unsigned int cellIndex, changedCells) {
+
+			std::pair<float, float> match(cells[cellIndex].getGroundTruthLabel(), w._cellLabels[cellIndex]);
+
+			if (isBackgroundMatch(match))
+				after.insert(match);
+		}
+
+		// whether any kept cell can make a background match at all
+		bool keptBackgroundMatches = false;
+		for (unsigned int cellIndex = 0; cellIndex < w._numCells && !keptBackgroundMatches; cellIndex++) {
+
+			if (solved[cellIndex])
+				continue;
+
+			const cell_t& cell = cells[cellIndex];
+
+			keptBackgroundMatches =
+					cell.getGroundTruthLabel() == _options.gtBackgroundLabel ||
+					cell.getReconstructionLabel() == _options.recBackgroundLabel ||
+					cell.getAlternativeLabels().count(_options.recBackgroundLabel);
+		}
+
+		if (keptBackgroundMatches && before != after) {
+
+			LOG_DEBUG(tedenginelog)
+					<< "the background matches of the solved cells changed, solving the ILP for all cells"
+					<< std::endl;
+
+			changedCells.resize(w._numCells);
+			for (unsigned int i = 0; i < w._numCells; i++)
+				changedCells[i] = i;
+
+			clearIlp(w);
+			findBestCellLabels(w, changedCells);
+
+		} else if (keptBackgroundMatches) {
+
+			LOG_DEBUG(tedenginelog)
+					<< "the kept cells can share background matches with the solved ones, the errors "
+					<< "might differ from a complete evaluation" << std::endl;
+
+			w._exact = false;
+		}
+	}
+
+	if (!_options.computeVolumes) {
+
+		fillErrors(w);
+		return;
+	}
+
+	// update the outputs for the changed cells
+
+	std::vector<char> cellMask(w._numCells, false);
+
+	foreach (unsigned int cellIndex, changedCells) {
+
+		cellMask[cellIndex] = true;
+
+		foreach (const cell_t::Location& l, (*w._toleranceFunction->getCells())[cellIndex]) {
+
+			(*(*w._correctedReconstruction)[l.z])(l.x, l.y) = w._cellLabels[cellIndex];
+			(*(*w._splitLocations)[l.z])(l.x, l.y) = 0.33;
+			(*(*w._mergeLocations)[l.z])(l.x, l.y) = 0.33;
+			(*(*w._fpLocations)[l.z])(l.x, l.y)    = 0.33;
+			(*(*w._fnLocations)[l.z])(l.x, l.y)    = 0.33;
+		}
+	}
+
+	fillErrors(w);
+
+	drawErrorLocations(w, cellMask);
+}
+
+void
+TedEngine::prepare(Workspace& w, bool skeletonGraphs) const {
+
+	if (w._toleranceFunction && w._options == _options && w._skeletonGraphs == skeletonGraphs)
+		return;
+
+	delete w._toleranceFunction;
+	w._skeletonGraphToleranceFunction = 0;
+
+	bool haveBackgroundLabel = _options.haveBackgroundLabel || _options.groundTruthFromSkeletons || skeletonGraphs;
+
+	if (haveBackgroundLabel) {
+		LOG_ALL(tedenginelog) << "preparing workspace with background label" << std::endl;
+	} else {
+		LOG_ALL(tedenginelog) << "preparing workspace without background label" << std::endl;
+	}
+
+	if (skeletonGraphs) {
+
+		w._skeletonGraphToleranceFunction = new SkeletonGraphToleranceFunction(
+				_options.maxBoundaryShift,
+				_options.recBackgroundLabel,
+				_options.sliceWise,
+				_options.numThreads);
+		w._toleranceFunction = w._skeletonGraphToleranceFunction;
+
+	} else if (_options.groundTruthFromSkeletons) {
+
+		// the locations of the non-skeleton cells are only needed to paint 
+		// the output volumes
+		w._toleranceFunction = new SkeletonToleranceFunction(
+				_options.maxBoundaryShift,
+				_options.recBackgroundLabel,
+				_options.sliceWise,
+				_options.numThreads,
+				_options.computeVolumes);
+
+	} else {
+
+		w._toleranceFunction = new DistanceToleranceFunction(
+				_options.maxBoundaryShift,
+				haveBackgroundLabel,
+				_options.recBackgroundLabel,
+				_options.sliceWise,
+				_options.numThreads);
+	}
+
+	w._toleranceFunction->setMetrics(w._metrics.get());
+
+	if (haveBackgroundLabel)
+		w._errors = boost::make_shared<TolerantEditDistanceErrors>(_options.gtBackgroundLabel, _options.recBackgroundLabel);
+	else
+		w._errors = boost::make_shared<TolerantEditDistanceErrors>();
+
+	w._options        = _options;
+	w._skeletonGraphs = skeletonGraphs;
+}
+
+void
+TedEngine::clear(Workspace& w) const {
+
+	w._toleranceFunction->clear();
+	clearIlp(w);
+	w._cellLabels.clear();
+	w._errors->clear();
+
+	// the volumes are kept to be overwritten, unless they are not computed
+	// at all
+	if (!_options.computeVolumes) {
+
+		w._correctedReconstruction->clear();
+		w._splitLocations->clear();
+		w._mergeLocations->clear();
+		w._fpLocations->clear();
+		w._fnLocations->clear();
+	}
+}
+
+void
+TedEngine::clearIlp(Workspace& w) const {
+
+	w._indicatorVarsByRecLabel.clear();
+	w._indicatorVarsByGtToRecLabel.clear();
+	w._matchVars.clear();
+	w._labelingByVar.clear();
+	w._alternativeIndicators.clear();
+	w._cellClasses.clear();
+
+	// all of the above is gone, release the memory of the maps at once
+	w._arena.reset();
+}
+
+void
+TedEngine::extractCells(Workspace& w, const ImageStack& groundTruth, const ImageStack& reconstruction) const {
+
+	StageMetrics::Timer timer(w._metrics.get(), "extract cells");
+
+	if (groundTruth.size() != reconstruction.size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("ground truth and reconstruction have different size") << STACK_TRACE);
+
+	if (groundTruth.height() != reconstruction.height() || groundTruth.width() != reconstruction.width())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("ground truth and reconstruction have different size") << STACK_TRACE);
+
+	w._depth  = groundTruth.size();
+	w._width  = groundTruth.width();
+	w._height = groundTruth.height();
+
+	LOG_ALL(tedenginelog) << "extracting cells in " << w._width << "x" << w._height << "x" << w._depth << " volume" << std::endl;
+
+	// (allocates only if the shape changed since the last evaluation)
+	w._gtAndRec.reshape(vigra::Shape3(w._width, w._height, w._depth));
+	w._cellIds.reshape(vigra::Shape3(w._width, w._height, w._depth));
+
+	// prepare gt and rec image
+
+	for (unsigned int z = 0; z < w._depth; z++) {
+
+		const Image& gt  = *groundTruth[z];
+		const Image& rec = *reconstruction[z];
+
+		for (unsigned int x = 0; x < w._width; x++)
+			for (unsigned int y = 0; y < w._height; y++)
+				w._gtAndRec(x, y, z) = std::make_pair(gt(x, y), rec(x, y));
+	}
+
+	// find connected components in gt and rec image
+	StageMetrics::Timer componentsTimer(w._metrics.get(), "connected components");
+	w._cellIds = 0;
+	w._numCells = vigra::labelMultiArray(w._gtAndRec, w._cellIds);
+	componentsTimer.addCount("locations", w._cellIds.size());
+	componentsTimer.addCount("cells", w._numCells);
+	componentsTimer.stop();
+
+	LOG_DEBUG(tedenginelog) << "found " << w._numCells << " cells" << std::endl;
+
+	w._toleranceFunction->setResolution(
+			reconstruction.getResolutionX(),
+			reconstruction.getResolutionY(),
+			reconstruction.getResolutionZ());
+
+	// let tolerance function extract cells from that
+	w._toleranceFunction->extractCells(
+			w._numCells,
+			w._cellIds,
+			reconstruction,
+			groundTruth);
+
+	LOG_ALL(tedenginelog)
+			<< "found "
+			<< w._toleranceFunction->getGroundTruthLabels().size()
+			<< " ground truth labels and "
+			<< w._toleranceFunction->getReconstructionLabels().size()
+			<< " reconstruction labels"
+			<< std::endl;
+
+	// the cell ids are only needed for updates of the reconstruction
+	if (!_options.incrementalUpdates)
+		w._cellIds.reshape(vigra::Shape3(0, 0, 0));
+
+	timer.addCount("cells", w._numCells);
+	timer.addCount("ground truth labels", w._toleranceFunction->getGroundTruthLabels().size());
+	timer.addCount("reconstruction labels", w._toleranceFunction->getReconstructionLabels().size());
+}
+
+void
+TedEngine::extractSkeletonCells(Workspace& w, const Skeletons& skeletons, const ImageStack& reconstruction) const {
+
+	StageMetrics::Timer timer(w._metrics.get(), "extract cells");
+
+	w._depth  = reconstruction.size();
+	w._width  = reconstruction.width();
+	w._height = reconstruction.height();
+
+	// there is no cell id volume for skeleton graphs
+	w._cellIds.reshape(vigra::Shape3(0, 0, 0));
+
+	LOG_ALL(tedenginelog) << "extracting cells along " << skeletons.size() << " skeletons in " << w._width << "x" << w._height << "x" << w._depth << " volume" << std::endl;
+
+	w._toleranceFunction->setResolution(
+			reconstruction.getResolutionX(),
+			reconstruction.getResolutionY(),
+			reconstruction.getResolutionZ());
+
+	w._skeletonGraphToleranceFunction->extractCells(
+			skeletons,
+			reconstruction);
+
+	w._numCells = w._toleranceFunction->getCells()->size();
+
+	LOG_DEBUG(tedenginelog) << "found " << w._numCells << " cells" << std::endl;
+
+	timer.addCount("skeletons", skeletons.size());
+	timer.addCount("cells", w._numCells);
+}
+
+void
+TedEngine::findBestCellLabels(Workspace& w) const {
+
+	std::vector<unsigned int> cellIndices(w._toleranceFunction->getCells()->size());
+	for (unsigned int i = 0; i < cellIndices.size(); i++)
+		cellIndices[i] = i;
+
+	findBestCellLabels(w, cellIndices);
+}
+
+void
+TedEngine::findBestCellLabels(Workspace& w, const std::vector<unsigned int>& cellIndices) const {
+
+	StageMetrics::Timer timer(w._metrics.get(), "find best cell labels");
+
+	// the construction of the ILP, up to the solver
+	StageMetrics::Timer setupTimer(w._metrics.get(), "setup ILP");
+
+	LinearConstraints& constraints = w._constraints;
+	constraints.clear();
+
+	// the default are binary variables
+	LinearSolverParameters parameters(Binary);
+
+	// Presolve: Cells without alternative labels keep their label. They don't
+	// need indicator variables, and they satisfy all constraints that ask for
+	// their label to exist or their match to be made. Furthermore, the number
+	// of splits and merges is an affine function of the match variables,
+	//
+	//   #splits + #merges = 2*sum(matches) - #gt labels - #rec labels,
+	//
+	// so we minimize the sum of matches directly instead of introducing split
+	// and merge variables.
+	//
+	// The remaining cells are grouped into classes of interchangeable cells
+	// (see groupCells()). Instead of one indicator per cell and label, each
+	// class gets one variable per label that counts how many of its cells
+	// take this label.
+
+	std::vector<cell_t>& cells = *w._toleranceFunction->getCells();
+
+	w._cellLabels.resize(cells.size());
+
+	// the labels of the given cells, which no other cell can take
+	std::set<float> gtLabels;
+	std::set<float> recLabels;
+
+	// rec labels kept by at least one forced cell
+	std::set<float> forcedRecLabels;
+
+	// gt label x rec label matches made by forced cells
+	std::map<float, std::set<float> > forcedMatches;
+
+	// statistics about the presolve reductions
+	unsigned int numForcedCells           = 0;
+	unsigned int numSatisfiedRows         = 0;
+	unsigned int numFixedMatches          = 0;
+	unsigned int numIndicatorMatches      = 0;
+	unsigned int numConstraintsBefore     = 0;
+	unsigned int numVariablesBefore       = 0;
+
+	foreach (unsigned int cellIndex, cellIndices) {
+
+		cell_t& cell = cells[cellIndex];
+
+		gtLabels.insert(cell.getGroundTruthLabel());
+		recLabels.insert(cell.getReconstructionLabel());
+		recLabels.insert(cell.getAlternativeLabels().begin(), cell.getAlternativeLabels().end());
+
+		numVariablesBefore += 1 + cell.getAlternativeLabels().size();
+		numConstraintsBefore++;
+
+		if (cell.getAlternativeLabels().empty()) {
+
+			w._cellLabels[cellIndex] = cell.getReconstructionLabel();
+
+			forcedRecLabels.insert(cell.getReconstructionLabel());
+			forcedMatches[cell.getGroundTruthLabel()].insert(cell.getReconstructionLabel());
+
+			numForcedCells++;
+		}
+	}
+
+	// When only some cells are labeled again, the other cells keep their
+	// labels. They can share the background labels with the given cells
+	// only (see findConnectedCells()), their background labels and matches
+	// are therefore constant.
+	if (cellIndices.size() < cells.size() && w._errors->hasBackgroundLabel()) {
+
+		std::vector<char> given(cells.size(), false);
+		foreach (unsigned int cellIndex, cellIndices)
+			given[cellIndex] = true;
+
+		for (unsigned int cellIndex = 0; cellIndex < cells.size(); cellIndex++) {
+
+			if (given[cellIndex])
+				continue;
+
+			float gtLabel  = cells[cellIndex].getGroundTruthLabel();
+			float recLabel = w._cellLabels[cellIndex];
+
+			if (gtLabel != _options.gtBackgroundLabel && recLabel != _options.recBackgroundLabel)
+				continue;
+
+			forcedRecLabels.insert(recLabel);
+			forcedMatches[gtLabel].insert(recLabel);
+		}
+	}
+
+	groupCells(w, cellIndices);
+
+	// introduce a count variable for each cell class and each possible label
+	// of the cells in that class
+	unsigned int var = 0;
+	for (unsigned int classIndex = 0; classIndex < w._cellClasses.size(); classIndex++) {
+
+		CellClass& cellClass = w._cellClasses[classIndex];
+
+		unsigned int numCells = cellClass.cells.size();
+
+		// first count variable for this class
+		unsigned int begin = var;
+		cellClass.firstVar = begin;
+
+		// one variable for the default label
+		assignIndicatorVariable(w, var++, classIndex, cellClass.gtLabel, cellClass.recLabel);
+
+		// one variable for each alternative
+		foreach (float l, cellClass.alternativeLabels) {
+
+			unsigned int ind = var++;
+			if (numCells == 1)
+				w._alternativeIndicators.push_back(std::make_pair(ind, cells[cellClass.cells[0]].size()));
+			assignIndicatorVariable(w, ind, classIndex, cellClass.gtLabel, l);
+		}
+
+		// last +1 count variable for this class
+		unsigned int end = var;
+
+		// every cell needs to have a label
+		LinearConstraint constraint;
+		for (unsigned int i = begin; i < end; i++)
+			constraint.setCoefficient(i, 1.0);
+		constraint.setRelation(Equal);
+		constraint.setValue(numCells);
+		constraints.add(constraint);
+
+		LOG_ALL(tedenginelog) << constraint << std::endl;
+
+		// counts of single cells are indicators
+		if (numCells == 1)
+			continue;
+
+		for (unsigned int i = begin; i < end; i++) {
+
+			parameters.setVariableType(i, Integer);
+
+			LinearConstraint nonNegative;
+			nonNegative.setCoefficient(i, 1.0);
+			nonNegative.setRelation(GreaterEqual);
+			nonNegative.setValue(0);
+			constraints.add(nonNegative);
+		}
+	}
+	w._numIndicatorVars = var;
+
+	LOG_ALL(tedenginelog) << "adding constraints to ensure that rec labels don't disappear" << std::endl;
+
+	// labels can not disappear
+	foreach (float recLabel, recLabels) {
+
+		numConstraintsBefore++;
+
+		if (forcedRecLabels.count(recLabel)) {
+
+			numSatisfiedRows++;
+			continue;
+		}
+
+		LinearConstraint constraint;
+		foreach (unsigned int v, getIndicatorsByRec(w, recLabel))
+			constraint.setCoefficient(v, 1.0);
+		constraint.setRelation(GreaterEqual);
+		constraint.setValue(1);
+		constraints.add(constraint);
+
+		LOG_ALL(tedenginelog) << constraint << std::endl;
+	}
+
+	// introduce indicators for each match of ground truth label to
+	// reconstruction label, and let cell label selection activate them
+
+	std::vector<unsigned int> matchVars;
+
+	foreach (float gtLabel, gtLabels) {
+		foreach (float recLabel, w._toleranceFunction->getPossibleMatchesByGt(gtLabel)) {
+
+			const var_list_t& indicators = getIndicatorsGtToRec(w, gtLabel, recLabel);
+
+			numVariablesBefore++;
+			numConstraintsBefore += indicators.size() + 1;
+
+			// made by a forced cell, constant
+			if (forcedMatches[gtLabel].count(recLabel)) {
+
+				numFixedMatches++;
+				continue;
+			}
+
+			if (indicators.empty())
+				continue;
+
+			// only one cell can make this match, its indicator is the match
+			if (indicators.size() == 1 && getNumCells(w, indicators[0]) == 1) {
+
+				assignMatchVariable(w, indicators[0], gtLabel, recLabel);
+				matchVars.push_back(indicators[0]);
+
+				numIndicatorMatches++;
+				continue;
+			}
+
+			unsigned int matchVar = var++;
+			assignMatchVariable(w, matchVar, gtLabel, recLabel);
+			matchVars.push_back(matchVar);
+
+			// no assignment of gtLabel to recLabel -> match is zero
+			LinearConstraint noMatchConstraint;
+
+			foreach (unsigned int v, indicators) {
+
+				noMatchConstraint.setCoefficient(v, 1);
+
+				// at least one assignment of gtLabel to recLabel -> match is
+				// one
+				LinearConstraint matchConstraint;
+				matchConstraint.setCoefficient(matchVar, getNumCells(w, v));
+				matchConstraint.setCoefficient(v, -1);
+				matchConstraint.setRelation(GreaterEqual);
+				matchConstraint.setValue(0);
+				constraints.add(matchConstraint);
+
+				LOG_ALL(tedenginelog) << matchConstraint << std::endl;
+			}
+
+			noMatchConstraint.setCoefficient(matchVar, -1);
+			noMatchConstraint.setRelation(GreaterEqual);
+			noMatchConstraint.setValue(0);
+			constraints.add(noMatchConstraint);
+
+			LOG_ALL(tedenginelog) << noMatchConstraint << std::endl;
+		}
+	}
+
+	// however, if there are multiple equal solutions, we prefer the ones with
+	// the least changes -- therefore, we add a small value for the size of
+	// each cell that gets an alternative label, such that these values can not
+	// sum up to one and therefor do not change the number of splits and merges
+	//
+	// In a class of several cells, we relabel the smallest cells first. The
+	// cost of relabeling m cells is the sum of the m smallest sizes, a convex
+	// piecewise linear function in m, which we model with one continuous
+	// variable bounded from below by each linear piece.
+
+	std::vector<unsigned int> relabelCostVars;
+
+	for (unsigned int classIndex = 0; classIndex < w._cellClasses.size(); classIndex++) {
+
+		const CellClass& cellClass = w._cellClasses[classIndex];
+
+		unsigned int numCells = cellClass.cells.size();
+
+		if (numCells == 1)
+			continue;
+
+		unsigned int costVar = var++;
+		parameters.setVariableType(costVar, Continuous);
+		relabelCostVars.push_back(costVar);
+
+		// with m = numCells - n(default label), the j-th piece is
+		//
+		//   cost >= sizeSum(j-1) + size(j)*(m - (j-1))
+
+		double sizeSum   = 0;
+		double lastSlope = -1;
+		for (unsigned int j = 1; j <= numCells; j++) {
+
+			double size = cells[cellClass.cells[j-1]].size();
+
+			// pieces of equal slope are the same line
+			if (size != lastSlope) {
+
+				LinearConstraint piece;
+				piece.setCoefficient(costVar, 1.0);
+				piece.setCoefficient(cellClass.firstVar, size);
+				piece.setRelation(GreaterEqual);
+				piece.setValue(sizeSum + size*(numCells - (j - 1)));
+				constraints.add(piece);
+
+				LOG_ALL(tedenginelog) << piece << std::endl;
+
+				lastSlope = size;
+			}
+
+			sizeSum += size;
+		}
+	}
+
+	// the split and merge variables we don't need (one per label, plus the
+	// totals), with their definitions and non-negativity constraints
+	unsigned int numGtLabels  = gtLabels.size();
+	unsigned int numRecLabels = recLabels.size();
+	numVariablesBefore   += numGtLabels + numRecLabels + 2;
+	numConstraintsBefore += 2*numGtLabels + 2*numRecLabels + 2;
+
+	LOG_DEBUG(tedenginelog)
+			<< "presolve reduced the ILP from "
+			<< numVariablesBefore << " variables and " << numConstraintsBefore << " constraints to "
+			<< var << " variables and " << constraints.size() << " constraints" << std::endl;
+	LOG_DEBUG(tedenginelog)
+			<< "presolve: " << numForcedCells << " of " << cellIndices.size() << " cells forced, "
+			<< (cellIndices.size() - numForcedCells) << " free cells in " << w._cellClasses.size() << " classes, "
+			<< numSatisfiedRows << " label constraints satisfied, "
+			<< numFixedMatches << " matches fixed, "
+			<< numIndicatorMatches << " matches replaced by their indicator, "
+			<< (numGtLabels + numRecLabels + 2) << " split and merge variables substituted" << std::endl;
+
+	setupTimer.addCount("cells", cellIndices.size());
+	setupTimer.addCount("forced cells", numForcedCells);
+	setupTimer.addCount("cell classes", w._cellClasses.size());
+	setupTimer.addCount("variables", var);
+	setupTimer.addCount("constraints", constraints.size());
+
+	if (var == 0) {
+
+		LOG_DEBUG(tedenginelog) << "all cells are forced, no need to solve the ILP" << std::endl;
+		return;
+	}
+
+	// create objective
+
+	std::vector<double> coefficients(var, 0.0);
+
+	// we want to minimize the number of split and merges
+	foreach (unsigned int matchVar, matchVars)
+		coefficients[matchVar] += 2;
+	// (computed in double, the product of the extents does not fit into 32 bit
+	// for large volumes)
+	double volumeSize = static_cast<double>(w._width)*w._height*w._depth;
+	unsigned int ind;
+	size_t cellSize;
+	foreach (boost::tie(ind, cellSize), w._alternativeIndicators)
+		coefficients[ind] += static_cast<double>(cellSize)/(volumeSize + 1);
+	foreach (unsigned int costVar, relabelCostVars)
+		coefficients[costVar] += 1.0/(volumeSize + 1);
+
+	LinearObjective objective(var);
+	for (unsigned int i = 0; i < var; i++)
+		objective.setCoefficient(i, coefficients[i]);
+	objective.setSense(Minimize);
+
+	setupTimer.stop();
+
+	solve(w, var, objective, parameters);
+
+	// postsolve: distribute the labels of each class over its cells, the
+	// smallest cells get the alternative labels
+
+	foreach (const CellClass& cellClass, w._cellClasses) {
+
+		unsigned int next = 0;
+		unsigned int v    = cellClass.firstVar + 1;
+
+		foreach (float l, cellClass.alternativeLabels) {
+
+			long count = std::lround(w._solution[v++]);
+
+			for (long i = 0; i < count && next < cellClass.cells.size(); i++)
+				w._cellLabels[cellClass.cells[next++]] = l;
+		}
+
+		while (next < cellClass.cells.size())
+			w._cellLabels[cellClass.cells[next++]] = cellClass.recLabel;
+	}
+}
+
+void
+TedEngine::solve(
+		Workspace&                    w,
+		unsigned int                  numVars,
+		const LinearObjective&        objective,
+		const LinearSolverParameters& parameters) const {
+
+	if (!w._solver)
+		w._solver = DefaultFactory().createLinearSolverBackend();
+
+	std::string message;
+
+	// nothing of the previous evaluation must survive in the solution
+	w._solution.getVector().clear();
+
+	if (_options.presolve) {
+
+		LOG_DEBUG(tedenginelog) << "presolving ILP" << std::endl;
+
+		StageMetrics::Timer presolveTimer(w._metrics.get(), "presolve");
+
+		bool feasible = w._presolve.presolve(
+				numVars,
+				objective,
+				w._constraints,
+				parameters.getDefaultVariableType(),
+				parameters.getSpecialVariableTypes(),
+				std::map<unsigned int, double>());
+
+		presolveTimer.stop();
+
+		if (feasible) {
+
+			Solution reduced;
+
+			if (w._presolve.getNumVariables() == 0) {
+
+				LOG_DEBUG(tedenginelog) << "presolve fixed all variables" << std::endl;
+
+			} else if (!solveWithBackend(
+					w,
+					w._presolve.getNumVariables(),
+					w._presolve.getDefaultVariableType(),
+					w._presolve.getSpecialVariableTypes(),
+					w._presolve.getObjective(),
+					w._presolve.getConstraints(),
+					reduced,
+					message)) {
+
+				UTIL_THROW_EXCEPTION(
+						NoSolutionException,
+						"the TED ILP could not be solved: " << message);
+			}
+
+			w._presolve.postsolve(reduced, w._solution);
+			return;
+		}
+
+		LOG_ERROR(tedenginelog) << "presolve found the ILP to be infeasible, passing it to the solver unchanged" << std::endl;
+	}
+
+	if (!solveWithBackend(
+			w,
+			numVars,
+			parameters.getDefaultVariableType(),
+			parameters.getSpecialVariableTypes(),
+			objective,
+			w._constraints,
+			w._solution,
+			message))
+		UTIL_THROW_EXCEPTION(
+				NoSolutionException,
+				"the TED ILP could not be solved: " << message);
+
+	LOG_DEBUG(tedenginelog) << "optimal solution found" << std::endl;
+}
+
+bool
+TedEngine::solveWithBackend(
+		Workspace&                                  w,
+		unsigned int                                numVars,
+		VariableType                                defaultVariableType,
+		const std::map<unsigned int, VariableType>& specialVariableTypes,
+		const LinearObjective&                      objective,
+		const LinearConstraints&                    constraints,
+		Solution&                                   solution,
+		std::string&                                message) const {
+
+	StageMetrics::Timer uploadTimer(w._metrics.get(), "upload ILP");
+
+	w._solver->initialize(numVars, defaultVariableType, specialVariableTypes);
+	w._solver->setObjective(objective);
+	w._solver->setConstraints(constraints);
+
+	if (_options.tieBreakTime >= 0)
+		w._solver->setTerminationPredicate(&countsProven, _options.tieBreakTime);
+	else
+		w._solver->setTerminationPredicate(LinearSolverBackend::TerminationPredicate());
+
+	size_t numNonZeros = 0;
+	foreach (const LinearConstraint& constraint, constraints)
+		numNonZeros += constraint.getCoefficients().size();
+
+	uploadTimer.addCount("variables", numVars);
+	uploadTimer.addCount("constraints", constraints.size());
+	uploadTimer.addCount("non-zeros", numNonZeros);
+	uploadTimer.stop();
+
+	StageMetrics::Timer solveTimer(w._metrics.get(), "solve ILP");
+
+	double value;
+
+	return w._solver->solve(solution, value, message);
+}
+
+void
+TedEngine::groupCells(Workspace& w, const std::vector<unsigned int>& cellIndices) const {
+
+	std::vector<cell_t>& cells = *w._toleranceFunction->getCells();
+
+	typedef std::pair<std::pair<float, float>, std::set<float> > ClassKey;
+
+	std::map<ClassKey, unsigned int> classIndices;
+
+	foreach (unsigned int cellIndex, cellIndices) {
+
+		const cell_t& cell = cells[cellIndex];
+
+		if (cell.getAlternativeLabels().empty())
+			continue;
+
+		ClassKey key(
+				std::make_pair(cell.getGroundTruthLabel(), cell.getReconstructionLabel()),
+				cell.getAlternativeLabels());
+
+		std::map<ClassKey, unsigned int>::iterator i = classIndices.find(key);
+
+		if (i == classIndices.end()) {
+
+			CellClass cellClass;
+			cellClass.gtLabel           = cell.getGroundTruthLabel();
+			cellClass.recLabel          = cell.getReconstructionLabel();
+			cellClass.alternativeLabels = cell.getAlternativeLabels();
+			cellClass.firstVar          = 0;
+
+			i = classIndices.insert(std::make_pair(key, w._cellClasses.size())).first;
+			w._cellClasses.push_back(cellClass);
+		}
+
+		w._cellClasses[i->second].cells.push_back(cellIndex);
+	}
+
+	// order the cells of each class by size
+	foreach (CellClass& cellClass, w._cellClasses)
+		std::stable_sort(
+				cellClass.cells.begin(),
+				cellClass.cells.end(),
+				[&cells](unsigned int a, unsigned int b) { return cells[a].size() < cells[b].size(); });
+
+	LOG_DEBUG(tedenginelog) << "grouped free cells into " << w._cellClasses.size() << " classes" << std::endl;
+}
+
+std::vector<unsigned int>
+TedEngine::findConnectedCells(Workspace& w, const LocalToleranceFunction::CellUpdate& update) const {
+
+	std::vector<cell_t>& cells = *w._toleranceFunction->getCells();
+
+	bool haveBackgroundLabel = w._errors->hasBackgroundLabel();
+
+	auto isGtBackground = [&](float label) {
+		return haveBackgroundLabel && label == _options.gtBackgroundLabel;
+	};
+	auto isRecBackground = [&](float label) {
+		return haveBackgroundLabel && label == _options.recBackgroundLabel;
+	};
+
+	// union-find of the ground truth and reconstruction labels, linked by
+	// the possible matches of each cell
+	//
+	// The background labels are left out: almost every cell can be relabeled
+	// to the background, which would connect nearly all cells. The parts
+	// share the background labels only, and the cells that are not solved
+	// again keep their matches with them (see findBestCellLabels()).
+
+	std::map<float, unsigned int> gtNodes;
+	std::map<float, unsigned int> recNodes;
+	std::vector<unsigned int>     parents;
+
+	auto node = [&](std::map<float, unsigned int>& nodes, float label) {
+
+		std::map<float, unsigned int>::const_iterator i = nodes.find(label);
+		if (i != nodes.end())
+			return i->second;
+
+		nodes[label] = parents.size();
+		parents.push_back(parents.size());
+
+		return (unsigned int)(parents.size() - 1);
+	};
+
+	auto find = [&](unsigned int i) {
+
+		while (parents[i] != i)
+			i = parents[i] = parents[parents[i]];
+
+		return i;
+	};
+
+	// a node of each cell, -1 for cells with background labels only
+	std::vector<int> cellNodes(cells.size(), -1);
+
+	for (unsigned int cellIndex = 0; cellIndex < cells.size(); cellIndex++) {
+
+		const cell_t& cell = cells[cellIndex];
+
+		int& first = cellNodes[cellIndex];
+
+		auto link = [&](unsigned int n) {
+
+			if (first < 0)
+				first = n;
+			else
+				parents[find(n)] = find(first);
+		};
+
+		if (!isGtBackground(cell.getGroundTruthLabel()))
+			link(node(gtNodes, cell.getGroundTruthLabel()));
+		if (!isRecBackground(cell.getReconstructionLabel()))
+			link(node(recNodes, cell.getReconstructionLabel()));
+		foreach (float recLabel, cell.getAlternativeLabels())
+			if (!isRecBackground(recLabel))
+				link(node(recNodes, recLabel));
+	}
+
+	// the components of the labels of the removed and added cells (labels
+	// that are not used by any cell anymore don't connect anything)
+
+	std::set<unsigned int> roots;
+
+	foreach (float gtLabel, update.gtLabels)
+		if (gtNodes.count(gtLabel))
+			roots.insert(find(gtNodes[gtLabel]));
+	foreach (float recLabel, update.recLabels)
+		if (recNodes.count(recLabel))
+			roots.insert(find(recNodes[recLabel]));
+
+	// the added cells have to be labeled, even if they have background
+	// labels only
+	std::vector<char> connected(cells.size(), false);
+	foreach (unsigned int cellIndex, update.addedCells)
+		connected[cellIndex] = true;
+
+	std::vector<unsigned int> connectedCells;
+	for (unsigned int cellIndex = 0; cellIndex < cells.size(); cellIndex++)
+		if (connected[cellIndex] || (cellNodes[cellIndex] >= 0 && roots.count(find(cellNodes[cellIndex]))))
+			connectedCells.push_back(cellIndex);
+
+	return connectedCells;
+}
+
+void
+TedEngine::findErrors(Workspace& w) const {
+
+	StageMetrics::Timer timer(w._metrics.get(), "find errors");
+
+	fillErrors(w);
+
+	//LOG_USER(tedenginelog) << "error counts from Errors data structure:" << std::endl;
+	//LOG_USER(tedenginelog) << "num splits: " << w._errors->getNumSplits() << std::endl;
+	//LOG_USER(tedenginelog) << "num merges: " << w._errors->getNumMerges() << std::endl;
+	//LOG_USER(tedenginelog) << "num false positives: " << w._errors->getNumFalsePositives() << std::endl;
+	//LOG_USER(tedenginelog) << "num false negatives: " << w._errors->getNumFalseNegatives() << std::endl;
+
+	if (!_options.computeVolumes)
+		return;
+
+	// prepare error location image stacks, initialized with gray (no cell
+	// label)
+
+	resetVolume(*w._splitLocations, w, 0.33);
+	resetVolume(*w._mergeLocations, w, 0.33);
+	resetVolume(*w._fpLocations, w, 0.33);
+	resetVolume(*w._fnLocations, w, 0.33);
+
+	drawErrorLocations(w, std::vector<char>(w._cellLabels.size(), true));
+}
+
+void
+TedEngine::fillErrors(Workspace& w) const {
+
+	// prepare error data structure
+
+	w._errors->setCells(w._toleranceFunction->getCells());
+
+	// fill error data structure
+
+	for (unsigned int cellIndex = 0; cellIndex < w._cellLabels.size(); cellIndex++)
+		w._errors->addMapping(cellIndex, w._cellLabels[cellIndex]);
+}
+
+void
+TedEngine::drawErrorLocations(Workspace& w, const std::vector<char>& cellMask) const {
+
+	const std::vector<cell_t>& allCells = *w._toleranceFunction->getCells();
+
+	// fill error location image stack
+
+	// all cells that changed label within tolerance
+
+	// all cells that split the ground truth
+	float gtLabel;
+	typedef TolerantEditDistanceErrors::cell_map_t::mapped_type::value_type mapping_t;
+	foreach (gtLabel, w._errors->getSplitLabels())
+		foreach (const mapping_t& cells, w._errors->getSplitCells(gtLabel))
+			foreach (unsigned int cellIndex, cells.second) {
+
+				if (!cellMask[cellIndex])
+					continue;
+
+				foreach (const cell_t::Location& l, allCells[cellIndex])
+					(*(*w._splitLocations)[l.z])(l.x, l.y) = cells.first;
+			}
+
+	// all cells that split the reconstruction
+	float recLabel;
+	foreach (recLabel, w._errors->getMergeLabels())
+		foreach (const mapping_t& cells, w._errors->getMergeCells(recLabel))
+			foreach (unsigned int cellIndex, cells.second) {
+
+				if (!cellMask[cellIndex])
+					continue;
+
+				foreach (const cell_t::Location& l, allCells[cellIndex])
+					(*(*w._mergeLocations)[l.z])(l.x, l.y) = cells.first;
+			}
+
+	if (w._errors->hasBackgroundLabel()) {
+
+		// all cells that are false positives
+		foreach (const mapping_t& cells, w._errors->getFalsePositiveCells())
+			if (cells.first != _options.recBackgroundLabel) {
+				foreach (unsigned int cellIndex, cells.second) {
+
+					if (!cellMask[cellIndex])
+						continue;
+
+					foreach (const cell_t::Location& l, allCells[cellIndex])
+						(*(*w._fpLocations)[l.z])(l.x, l.y) = cells.first;
+				}
+			}
+
+		// all cells that are false negatives
+		foreach (const mapping_t& cells, w._errors->getFalseNegativeCells())
+			if (cells.first != _options.gtBackgroundLabel) {
+				foreach (unsigned int cellIndex, cells.second) {
+
+					if (!cellMask[cellIndex])
+						continue;
+
+					foreach (const cell_t::Location& l, allCells[cellIndex])
+						(*(*w._fnLocations)[l.z])(l.x, l.y) = cells.first;
+				}
+			}
+	}
+}
+
+void
+TedEngine::correctReconstruction(Workspace& w) const {
+
+	if (!_options.computeVolumes)
+		return;
+
+	StageMetrics::Timer timer(w._metrics.get(), "correct reconstruction");
+
+	// prepare output image
+
+	resetVolume(*w._correctedReconstruction, w, 0.0);
+
+	// read cell labels
+
+	for (unsigned int cellIndex = 0; cellIndex < w._cellLabels.size(); cellIndex++) {
+
+		const cell_t& cell = (*w._toleranceFunction->getCells())[cellIndex];
+
+		foreach (const cell_t::Location& l, cell)
+			(*(*w._correctedReconstruction)[l.z])(l.x, l.y) = w._cellLabels[cellIndex];
+	}
+}
+
+void
+TedEngine::resetVolume(ImageStack& stack, const Workspace& w, float value) {
+
+	if (stack.size() != w._depth || stack.width() != w._width || stack.height() != w._height) {
+
+		stack.clear();
+		for (unsigned int z = 0; z < w._depth; z++)
+			stack.add(boost::make_shared<Image>(w._width, w._height, value));
+
+		return;
+	}
+
+	foreach (boost::shared_ptr<Image> section, stack)
+		std::fill(section->data(), section->data() + static_cast<size_t>(w._width)*w._height, value);
+}
+
+void
+TedEngine::assignIndicatorVariable(Workspace& w, unsigned int var, unsigned int classIndex, float gtLabel, float recLabel) const {
+
+	LOG_ALL(tedenginelog) << "adding count var " << var << " to assign label " << recLabel << " to cells of class " << classIndex << std::endl;
+
+	w._indicatorVarsByRecLabel[recLabel].push_back(var);
+	w._indicatorVarsByGtToRecLabel[gtLabel][recLabel].push_back(var);
+
+	w._labelingByVar[var] = std::make_pair(classIndex, recLabel);
+}
+
+unsigned int
+TedEngine::getNumCells(Workspace& w, unsigned int var) const {
+
+	return w._cellClasses[w._labelingByVar[var].first].cells.size();
+}
+
+TedEngine::var_list_t&
+TedEngine::getIndicatorsByRec(Workspace& w, float recLabel) const {
+
+	return w._indicatorVarsByRecLabel[recLabel];
+}
+
+TedEngine::var_list_t&
+TedEngine::getIndicatorsGtToRec(Workspace& w, float gtLabel, float recLabel) const {
+
+	return w._indicatorVarsByGtToRecLabel[gtLabel][recLabel];
+}
+
+void
+TedEngine::assignMatchVariable(Workspace& w, unsigned int var, float gtLabel, float recLabel) const {
+
+	LOG_ALL(tedenginelog) << "adding indicator var " << var << " to match gt label " << gtLabel << " to rec label " << recLabel << std::endl;
+
+	w._matchVars[gtLabel][recLabel] = var;
+}
+
@@ -0,0 +1,469 @@
+#ifndef TED_EVALUATION_TED_ENGINE_H__
+#define TED_EVALUATION_TED_ENGINE_H__
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <imageprocessing/ImageStack.h>
+#include <inference/LinearConstraints.h>
+#include <inference/LinearObjective.h>
+#include <inference/LinearPresolve.h>
+#include <inference/LinearSolverBackend.h>
+#include <inference/LinearSolverParameters.h>
+#include <inference/Solution.h>
+#include "Arena.h"
+#include "LocalToleranceFunction.h"
+#include "Skeletons.h"
+#include "StageMetrics.h"
+#include "TolerantEditDistanceErrors.h"
+#include "VolumeView.h"
+
+class SkeletonGraphToleranceFunction;
+
+/**
+ * The tolerant edit distance as a plain C++ API, for applications that embed
+ * the evaluation. TolerantEditDistance is a pipeline wrapper around it.
+ *
+ * The engine itself only holds the options. Everything that is computed for
+ * an evaluation (the cells, the ILP, the errors, and the output volumes) is
+ * kept in a Workspace, which is passed to each call and keeps its buffers
+ * between calls. Evaluating a series of volumes with the same workspace
+ * therefore reuses the label buffers, the tolerance function, and the
+ * solver backend. A workspace must only be used by one
+ * thread at a time, the engine can be shared.
+ */
+class TedEngine {
+
+	// lists of ILP variables, kept in the arena of a workspace
+	typedef ArenaVector<unsigned int> var_list_t;
+
+	/**
+	 * Cells with the same ground truth label, reconstruction label, and
+	 * alternative labels. Those are interchangeable in the ILP.
+	 */
+	struct CellClass {
+
+		float gtLabel;
+		float recLabel;
+
+		std::set<float> alternativeLabels;
+
+		// the indices of the cells in this class, ordered by size
+		std::vector<unsigned int> cells;
+
+		// the count variable of the default label, followed by the ones of the
+		// alternative labels
+		unsigned int firstVar;
+	};
+
+public:
+
+	typedef LocalToleranceFunction::cell_t cell_t;
+
+	struct Options {
+
+		/**
+		 * Create the default options, which are the defaults of the program
+		 * options as well.
+		 */
+		Options();
+
+		/**
+		 * Read the options from the program options of the evaluation and
+		 * inference modules.
+		 */
+		static Options fromProgramOptions();
+
+		bool operator==(const Options& other) const;
+		bool operator!=(const Options& other) const { return !(*this == other); }
+
+		// the maximum allowed distance for a boundary shift in units
+		float maxBoundaryShift;
+
+		// is there a background label?
+		bool haveBackgroundLabel;
+
+		// the optional background labels of the ground truth and
+		// reconstruction
+		float gtBackgroundLabel;
+		float recBackgroundLabel;
+
+		// the ground truth image stack consists of skeletons only (implies a
+		// background label)
+		bool groundTruthFromSkeletons;
+
+		// apply the tolerance criterion within each section only
+		bool sliceWise;
+
+		// the number of threads to find alternative cell labels, 0 for all
+		// CPUs
+		unsigned int numThreads;
+
+		// reduce the ILP with a LinearPresolve before solving it
+		bool presolve;
+
+		// stop the ILP solver as soon as the error counts are proven, and
+		// continue to improve the tie-break for at most this many seconds,
+		// negative to solve to optimality (Gurobi only, other backends
+		// always solve to optimality)
+		double tieBreakTime;
+
+		// keep the cell id volume (4 bytes per location) after an
+		// evaluation, which updateReconstruction() needs
+		bool incrementalUpdates;
+
+		// compute the corrected reconstruction and the error location
+		// volumes, not only the errors
+		bool computeVolumes;
+	};
+
+	/**
+	 * The state and results of evaluations, reused between calls.
+	 */
+	class Workspace {
+
+	public:
+
+		Workspace();
+
+		~Workspace();
+
+		/**
+		 * The errors of the last evaluation.
+		 */
+		boost::shared_ptr<TolerantEditDistanceErrors> getErrors() const { return _errors; }
+
+		/**
+		 * The output volumes of the last evaluation, if the option
+		 * computeVolumes is set.
+		 */
+		boost::shared_ptr<ImageStack> getCorrectedReconstruction() const { return _correctedReconstruction; }
+		boost::shared_ptr<ImageStack> getSplitLocations() const { return _splitLocations; }
+		boost::shared_ptr<ImageStack> getMergeLocations() const { return _mergeLocations; }
+		boost::shared_ptr<ImageStack> getFalsePositiveLocations() const { return _fpLocations; }
+		boost::shared_ptr<ImageStack> getFalseNegativeLocations() const { return _fnLocations; }
+
+		/**
+		 * The time, memory, and item counts of the stages of the last
+		 * evaluation or update.
+		 */
+		boost::shared_ptr<StageMetrics> getMetrics() const { return _metrics; }
+
+		/**
+		 * False, if the errors of the last updateReconstruction() might
+		 * differ from those of a complete evaluation (see there). True after
+		 * a complete evaluation.
+		 */
+		bool isExact() const { return _exact; }
+
+	private:
+
+		friend class TedEngine;
+
+		Workspace(const Workspace&);
+		Workspace& operator=(const Workspace&);
+
+		// the options and kind of ground truth the tolerance function and
+		// errors have been created for
+		Options _options;
+		bool    _skeletonGraphs;
+
+		// the local tolerance function to use
+		LocalToleranceFunction* _toleranceFunction;
+
+		// the same tolerance function, if the ground truth is given as
+		// skeleton graphs, null otherwise
+		SkeletonGraphToleranceFunction* _skeletonGraphToleranceFunction;
+
+		// the extends of the ground truth and reconstruction
+		unsigned int _width, _height, _depth;
+
+		// copies of volume views, as the tolerance functions read image
+		// stacks
+		ImageStack _groundTruth;
+		ImageStack _reconstruction;
+
+		// the ground truth and reconstruction label of each location
+		vigra::MultiArray<3, std::pair<float, float> > _gtAndRec;
+
+		// the number of cells
+		unsigned int _numCells;
+
+		// the cell index (starting at 1) of each location, kept for updates
+		// of the reconstruction with the option incrementalUpdates only
+		vigra::MultiArray<3, unsigned int> _cellIds;
+
+		// the free cells, grouped into classes of interchangeable cells
+		std::vector<CellClass> _cellClasses;
+
+		// the memory of the variable maps below, which are rebuilt for each
+		// ILP and released at once in clearIlp()
+		Arena _arena;
+
+		// reconstruction label indicators by reconstruction label
+		ArenaMap<float, var_list_t> _indicatorVarsByRecLabel;
+
+		// reconstruction label indicators by groundtruth label x
+		// reconstruction label
+		ArenaMap<float, ArenaMap<float, var_list_t> > _indicatorVarsByGtToRecLabel;
+
+		// (cell class index, new label) by indicator variable
+		ArenaMap<unsigned int, std::pair<unsigned int, float> > _labelingByVar;
+
+		// map from ground truth label x reconstruction label to match
+		// variable
+		ArenaMap<float, ArenaMap<float, unsigned int> > _matchVars;
+
+		// the number of indicator (count) variables in the ILP
+		unsigned int _numIndicatorVars;
+
+		// indicators for alternative labels of single cell classes, and the
+		// corresponding cell size
+		std::vector<std::pair<unsigned int, size_t> > _alternativeIndicators;
+
+		// the final reconstruction label of each cell
+		std::vector<float> _cellLabels;
+
+		// the constraints of the ILP and its solution
+		LinearConstraints _constraints;
+		LinearPresolve    _presolve;
+		Solution          _solution;
+
+		// created on first use, the environment of the solver is kept
+		LinearSolverBackend* _solver;
+
+		boost::shared_ptr<TolerantEditDistanceErrors> _errors;
+
+		boost::shared_ptr<ImageStack> _correctedReconstruction;
+		boost::shared_ptr<ImageStack> _splitLocations;
+		boost::shared_ptr<ImageStack> _mergeLocations;
+		boost::shared_ptr<ImageStack> _fpLocations;
+		boost::shared_ptr<ImageStack> _fnLocations;
+
+		boost::shared_ptr<StageMetrics> _metrics;
+
+		// the errors are those of a complete evaluation
+		bool _exact;
+	};
+
+	TedEngine(const Options& options = Options());
+
+	const Options& getOptions() const { return _options; }
+
+	/**
+	 * Evaluate a reconstruction against a ground truth, both given as views
+	 * of the same size. The labels are converted to float (the label type
+	 * used throughout the evaluation) into buffers of the workspace. The
+	 * resolution is taken from the reconstruction.
+	 */
+	template <typename GtType, typename RecType>
+	void evaluate(
+			const VolumeView<GtType>&  groundTruth,
+			const VolumeView<RecType>& reconstruction,
+			Workspace&                 workspace) const {
+
+		copy(groundTruth, workspace._groundTruth, cell_t::Location(0, 0, 0), maxLocation(groundTruth));
+		copy(reconstruction, workspace._reconstruction, cell_t::Location(0, 0, 0), maxLocation(reconstruction));
+
+		evaluate(workspace._groundTruth, workspace._reconstruction, workspace);
+	}
+
+	/**
+	 * Evaluate a reconstruction against a ground truth of the same size.
+	 */
+	void evaluate(
+			const ImageStack& groundTruth,
+			const ImageStack& reconstruction,
+			Workspace&        workspace) const;
+
+	/**
+	 * Evaluate a reconstruction against ground truth skeleton graphs. Only the
+	 * reconstruction around the skeletons is evaluated.
+	 */
+	void evaluate(
+			const Skeletons&  skeletons,
+			const ImageStack& reconstruction,
+			Workspace&        workspace) const;
+
+	/**
+	 * Update the errors and volumes in the workspace after the reconstruction
+	 * was changed in place inside the given bounding box, e.g., by a local
+	 * merge or split. The workspace has to hold the evaluation of the
+	 * previous reconstruction against the same ground truth, computed with
+	 * the option incrementalUpdates. Only the cells within maxBoundaryShift
+	 * of the changes are extracted again, and only the parts of the ILP that
+	 * contain their labels are solved again. All other cells keep their
+	 * previous labels.
+	 *
+	 * The parts share the background labels only. If the solved parts make
+	 * other background matches than before, the other parts might label
+	 * their cells differently now, and the whole ILP is solved again.
+	 * Otherwise, the errors are exact if no cell of the other parts has or
+	 * can take a background label. If one does, a solution that changes
+	 * cells of several parts at once might still be better, and
+	 * Workspace::isExact() is false.
+	 *
+	 * @param min, max
+	 *              The inclusive bounding box of all changed locations.
+	 */
+	void updateReconstruction(
+			const ImageStack&       groundTruth,
+			const ImageStack&       reconstruction,
+			const cell_t::Location& min,
+			const cell_t::Location& max,
+			Workspace&              workspace) const;
+
+	/**
+	 * Same as above, for views that have been evaluated with this workspace
+	 * before. Only the changed part of the reconstruction is read again.
+	 */
+	template <typename GtType, typename RecType>
+	void updateReconstruction(
+			const VolumeView<GtType>&,
+			const VolumeView<RecType>& reconstruction,
+			const cell_t::Location&    min,
+			const cell_t::Location&    max,
+			Workspace&                 workspace) const {
+
+		cell_t::Location last = maxLocation(reconstruction);
+
+		copy(
+				reconstruction,
+				workspace._reconstruction,
+				cell_t::Location(
+						std::max(0, min.x),
+						std::max(0, min.y),
+						std::max(0, min.z)),
+				cell_t::Location(
+						std::min(last.x, max.x),
+						std::min(last.y, max.y),
+						std::min(last.z, max.z)));
+
+		updateReconstruction(workspace._groundTruth, workspace._reconstruction, min, max, workspace);
+	}
+
+private:
+
+	template <typename T>
+	static cell_t::Location maxLocation(const VolumeView<T>& view) {
+
+		return cell_t::Location(
+				static_cast<int>(view.width())  - 1,
+				static_cast<int>(view.height()) - 1,
+				static_cast<int>(view.depth())  - 1);
+	}
+
+	/**
+	 * Copy the part [min,max] of a view into an image stack. The stack is
+	 * (re)allocated only if its size differs from the view.
+	 */
+	template <typename T>
+	static void copy(
+			const VolumeView<T>&    view,
+			ImageStack&             stack,
+			const cell_t::Location& min,
+			const cell_t::Location& max) {
+
+		if (stack.size() != view.depth() || stack.width() != view.width() || stack.height() != view.height()) {
+
+			stack.clear();
+			for (size_t z = 0; z < view.depth(); z++)
+				stack.add(boost::make_shared<Image>(view.width(), view.height()));
+		}
+
+		for (int z = min.z; z <= max.z; z++) {
+
+			Image& section = *stack[z];
+
+			for (int y = min.y; y <= max.y; y++)
+				for (int x = min.x; x <= max.x; x++)
+					section(x, y) = view(x, y, z);
+		}
+
+		stack.setResolution(view.getResolutionX(), view.getResolutionY(), view.getResolutionZ());
+	}
+
+	// create the tolerance function and errors, unless the workspace has them
+	// for the current options already
+	void prepare(Workspace& w, bool skeletonGraphs) const;
+
+	void clear(Workspace& w) const;
+
+	void clearIlp(Workspace& w) const;
+
+	void extractCells(Workspace& w, const ImageStack& groundTruth, const ImageStack& reconstruction) const;
+
+	void extractSkeletonCells(Workspace& w, const Skeletons& skeletons, const ImageStack& reconstruction) const;
+
+	void findBestCellLabels(Workspace& w) const;
+
+	// find the best labels for a subset of the cells, which has to contain
+	// all cells with any of the labels of its cells
+	void findBestCellLabels(Workspace& w, const std::vector<unsigned int>& cellIndices) const;
+
+	// solve the ILP of the constraints in the workspace and the given
+	// objective, throws a NoSolutionException if the solver fails
+	void solve(
+			Workspace&                    w,
+			unsigned int                  numVars,
+			const LinearObjective&        objective,
+			const LinearSolverParameters& parameters) const;
+
+	// pass an ILP to the backend of the workspace and solve it
+	bool solveWithBackend(
+			Workspace&                                  w,
+			unsigned int                                numVars,
+			VariableType                                defaultVariableType,
+			const std::map<unsigned int, VariableType>& specialVariableTypes,
+			const LinearObjective&                      objective,
+			const LinearConstraints&                    constraints,
+			Solution&                                   solution,
+			std::string&                                message) const;
+
+	void groupCells(Workspace& w, const std::vector<unsigned int>& cellIndices) const;
+
+	// find the added cells and all cells that are connected via possible
+	// matches other than background to the labels of an update
+	std::vector<unsigned int> findConnectedCells(Workspace& w, const LocalToleranceFunction::CellUpdate& update) const;
+
+	// a (gt label, rec label) match that involves a background label
+	bool isBackgroundMatch(const std::pair<float, float>& match) const {
+
+		return match.first == _options.gtBackgroundLabel || match.second == _options.recBackgroundLabel;
+	}
+
+	void findErrors(Workspace& w) const;
+
+	// register the current cell labels with the errors data structure
+	void fillErrors(Workspace& w) const;
+
+	// draw the error locations of the cells marked in cellMask
+	void drawErrorLocations(Workspace& w, const std::vector<char>& cellMask) const;
+
+	void correctReconstruction(Workspace& w) const;
+
+	// give a stack the size of the evaluated volume, with all locations set
+	// to value (the images are reused if they have the right size already)
+	static void resetVolume(ImageStack& stack, const Workspace& w, float value);
+
+	void assignIndicatorVariable(Workspace& w, unsigned int var, unsigned int classIndex, float gtLabel, float recLabel) const;
+
+	// the number of cells in the class of the given count variable
+	unsigned int getNumCells(Workspace& w, unsigned int var) const;
+
+	var_list_t& getIndicatorsByRec(Workspace& w, float recLabel) const;
+
+	var_list_t& getIndicatorsGtToRec(Workspace& w, float gtLabel, float recLabel) const;
+
+	void assignMatchVariable(Workspace& w, unsigned int var, float gtLabel, float recLabel) const;
+
+	Options _options;
+};
+
+#endif // TED_EVALUATION_TED_ENGINE_H__
+
@@ -4,60 +4,69 @@
 #include <imageprocessing/ImageStack.h>
 #include <pipeline/SimpleProcessNode.h>
 #include <pipeline/Value.h>
-#include <inference/Solution.h>
-#include "LocalToleranceFunction.h"
+#include "Skeletons.h"
+#include "TedEngine.h"
 #include "TolerantEditDistanceErrors.h"
-#include "Cell.h"
 
+/**
+ * Pipeline process node for the TED, a wrapper around TedEngine with the
+ * options taken from the program options, unless given explicitly.
+ */
 class TolerantEditDistance : public pipeline::SimpleProcessNode<> {
 
 public:
 
+	typedef TedEngine::cell_t cell_t;
+
 	/**
 	 * Create a new evaluator.
 	 *
 	 * @param headerOnly
 	 *              If set to true, no error will be computed, only the header 
 	 *              information in Errors::errorHeader() will be set.
+	 *
+	 * @param skeletonGraphs
+	 *              If set to true, the ground truth is taken from the input 
+	 *              "skeletons" as skeleton graphs, instead of from the image 
+	 *              stack "ground truth". Only the reconstruction around the 
+	 *              skeletons is evaluated.
 	 */
-	TolerantEditDistance(bool headerOnly);
+	TolerantEditDistance(bool headerOnly, bool skeletonGraphs = false);
 
-	~TolerantEditDistance();
+	/**
+	 * Create a new evaluator with the given options instead of the ones from 
+	 * the program options, e.g., to limit the number of threads of 
+	 * evaluations that run in parallel.
+	 */
+	TolerantEditDistance(const TedEngine::Options& options, bool headerOnly, bool skeletonGraphs = false);
 
-private:
+	/**
+	 * Update the errors and outputs after the reconstruction was changed in 
+	 * place inside the given bounding box, e.g., by a local merge or split. 
+	 * The outputs have to be computed for the previous reconstruction 
+	 * already, with the program option evaluation.incrementalUpdates. The 
+	 * outputs are marked dirty, without evaluating the whole reconstruction 
+	 * again. See TedEngine::updateReconstruction().
+	 *
+	 * @param min, max
+	 *              The inclusive bounding box of all changed locations.
+	 *
+	 * @return False, if the errors might differ from those of a complete 
+	 *         evaluation of the changed reconstruction.
+	 */
+	bool updateReconstruction(const cell_t::Location& min, const cell_t::Location& max);
 
-	typedef LocalToleranceFunction::cell_t cell_t;
+private:
 
 	void updateOutputs();
 
-	void clear();
-
-	void extractCells();
-
-	void findBestCellLabels();
-
-	void findErrors();
-
-	void correctReconstruction();
-
-	void assignIndicatorVariable(unsigned int var, unsigned int cellIndex, float gtLabel, float recLabel);
-
-	std::vector<unsigned int>& getIndicatorsByRec(float recLabel);
+	// point the outputs to the results in the workspace
+	void setOutputs();
 
-	std::vector<unsigned int>& getIndicatorsGtToRec(float gtLabel, float recLabel);
-
-	void assignMatchVariable(unsigned int var, float gtLabel, float recLabel);
-
-	unsigned int getMatchVariable(float gtLabel, float recLabel);
-
-	// is there a background label?
-	bool _haveBackgroundLabel;
-
-	// the optional background labels of the ground truth and reconstruction
-	float _gtBackgroundLabel;
-	float _recBackgroundLabel;
+	void onInputModified(const pipeline::Modified& signal);
 
 	pipeline::Input<ImageStack> _groundTruth;
+	pipeline::Input<Skeletons>  _skeletons;
 	pipeline::Input<ImageStack> _reconstruction;
 
 	pipeline::Output<ImageStack> _correctedReconstruction;
@@ -66,44 +75,17 @@ private:
 	pipeline::Output<ImageStack> _fpLocations;
 	pipeline::Output<ImageStack> _fnLocations;
 	pipeline::Output<TolerantEditDistanceErrors> _errors;
+	pipeline::Output<StageMetrics>               _metrics;
 
-	// the local tolerance function to use
-	LocalToleranceFunction* _toleranceFunction;
-
-	// the extends of the ground truth and reconstruction
-	unsigned int _width, _height, _depth;
-
-	// the number of cells
-	unsigned int _numCells;
-
-	// reconstruction label indicators by reconstruction label
-	std::map<float, std::vector<unsigned int> > _indicatorVarsByRecLabel;
-
-	// reconstruction label indicators by groundtruth label x reconstruction 
-	// label
-	std::map<float, std::map<float, std::vector<unsigned int> > > _indicatorVarsByGtToRecLabel;
+	TedEngine            _engine;
+	TedEngine::Workspace _workspace;
 
-	// (cell index, new label) by indicator variable
-	std::map<unsigned int, std::pair<unsigned int, float> > _labelingByVar;
-
-	// map from ground truth label x reconstruction label to match variable
-	std::map<float, std::map<float, unsigned int> > _matchVars;
-
-	// the number of indicator variables in the ILP
-	unsigned int _numIndicatorVars;
-
-	// indicators for alternative cell labels, and the corresponding cell size
-	std::vector<std::pair<unsigned int, size_t> > _alternativeIndicators;
-
-	// the ILP variables for the number of splits and merges
-	unsigned int _splits;
-	unsigned int _merges;
+	bool _headerOnly;
 
-	// the solution of the ILP
-	pipeline::Value<Solution> _solution;
+	bool _skeletonGraphs;
 
-	bool _headerOnly;
+	// the inputs changed since the last evaluation
+	bool _inputsModified;
 };
 
 #endif // TED_EVALUATION_TOLERANT_EDIT_DISTANCE_H__
-
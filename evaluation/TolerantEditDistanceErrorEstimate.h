@@ -0,0 +1,120 @@
+#ifndef TED_EVALUATION_TOLERANT_EDIT_DISTANCE_ERROR_ESTIMATE_H__
+#define TED_EVALUATION_TOLERANT_EDIT_DISTANCE_ERROR_ESTIMATE_H__
+
+#include <sstream>
+#include <iomanip>
+#include "Errors.h"
+
+/**
+ * Estimates of the TED error counts, extrapolated from a sample of ground
+ * truth and reconstruction labels, together with the margins of their 95%
+ * confidence intervals.
+ */
+class TolerantEditDistanceErrorEstimate : public Errors {
+
+public:
+
+	TolerantEditDistanceErrorEstimate() :
+		_numSplits(0),
+		_numMerges(0),
+		_numFalsePositives(0),
+		_numFalseNegatives(0),
+		_splitMargin(0),
+		_mergeMargin(0),
+		_falsePositiveMargin(0),
+		_falseNegativeMargin(0),
+		_margin(0),
+		_numSampledGtLabels(0),
+		_numGtLabels(0),
+		_numSampledRecLabels(0),
+		_numRecLabels(0) {}
+
+	void setNumSplits(double numSplits, double margin) { _numSplits = numSplits; _splitMargin = margin; }
+
+	void setNumMerges(double numMerges, double margin) { _numMerges = numMerges; _mergeMargin = margin; }
+
+	void setNumFalsePositives(double numFalsePositives, double margin) { _numFalsePositives = numFalsePositives; _falsePositiveMargin = margin; }
+
+	void setNumFalseNegatives(double numFalseNegatives, double margin) { _numFalseNegatives = numFalseNegatives; _falseNegativeMargin = margin; }
+
+	/**
+	 * Set the margin of the estimate of the sum of all errors.
+	 */
+	void setNumErrorsMargin(double margin) { _margin = margin; }
+
+	/**
+	 * Set how many of the ground truth and reconstruction labels have been
+	 * evaluated.
+	 */
+	void setSampleSizes(size_t numSampledGtLabels, size_t numGtLabels, size_t numSampledRecLabels, size_t numRecLabels) {
+
+		_numSampledGtLabels  = numSampledGtLabels;
+		_numGtLabels         = numGtLabels;
+		_numSampledRecLabels = numSampledRecLabels;
+		_numRecLabels        = numRecLabels;
+	}
+
+	double getNumSplits() { return _numSplits; }
+	double getNumMerges() { return _numMerges; }
+	double getNumFalsePositives() { return _numFalsePositives; }
+	double getNumFalseNegatives() { return _numFalseNegatives; }
+	double getNumErrors() { return _numSplits + _numMerges + _numFalsePositives + _numFalseNegatives; }
+
+	double getNumSplitsMargin() { return _splitMargin; }
+	double getNumMergesMargin() { return _mergeMargin; }
+	double getNumFalsePositivesMargin() { return _falsePositiveMargin; }
+	double getNumFalseNegativesMargin() { return _falseNegativeMargin; }
+	double getNumErrorsMargin() { return _margin; }
+
+	std::string errorHeader() { return "TED_FP\tTED_FN\tTED_FS\tTED_FM\tTED_SUM"; }
+
+	std::string errorString() {
+
+		std::stringstream ss;
+		ss << std::scientific << std::setprecision(5);
+		ss
+				<< getNumFalsePositives() << "\t"
+				<< getNumFalseNegatives() << "\t"
+				<< getNumSplits() << "\t"
+				<< getNumMerges() << "\t"
+				<< getNumErrors();
+
+		return ss.str();
+	}
+
+	std::string humanReadableErrorString() {
+
+		std::stringstream ss;
+		ss
+				<<   "TED FP: "    << getNumFalsePositives() << " +- " << getNumFalsePositivesMargin()
+				<< ", TED FN: "    << getNumFalseNegatives() << " +- " << getNumFalseNegativesMargin()
+				<< ", TED FS: "    << getNumSplits()         << " +- " << getNumSplitsMargin()
+				<< ", TED FM: "    << getNumMerges()         << " +- " << getNumMergesMargin()
+				<< ", TED Total: " << getNumErrors()         << " +- " << getNumErrorsMargin()
+				<< " (estimated from " << _numSampledGtLabels << "/" << _numGtLabels << " ground truth and "
+				<< _numSampledRecLabels << "/" << _numRecLabels << " reconstruction labels)";
+
+		return ss.str();
+	}
+
+private:
+
+	double _numSplits;
+	double _numMerges;
+	double _numFalsePositives;
+	double _numFalseNegatives;
+
+	double _splitMargin;
+	double _mergeMargin;
+	double _falsePositiveMargin;
+	double _falseNegativeMargin;
+	double _margin;
+
+	size_t _numSampledGtLabels;
+	size_t _numGtLabels;
+	size_t _numSampledRecLabels;
+	size_t _numRecLabels;
+};
+
+#endif // TED_EVALUATION_TOLERANT_EDIT_DISTANCE_ERROR_ESTIMATE_H__
+
@@ -79,7 +79,7 @@ TolerantEditDistanceErrors::getGroundTruthLabels(float recLabel) {
 	return gtLabels;
 }
 
-unsigned int
+size_t
 TolerantEditDistanceErrors::getOverlap(float gtLabel, float recLabel) {
 
 	if (!_cells)
@@ -88,7 +88,7 @@ TolerantEditDistanceErrors::getOverlap(float gtLabel, float recLabel) {
 	if (_cellsByGtToRecLabel.count(gtLabel) == 0 || _cellsByGtToRecLabel[gtLabel].count(recLabel) == 0)
 		return 0;
 
-	unsigned int overlap = 0;
+	size_t overlap = 0;
 	foreach (unsigned int cellIndex, _cellsByGtToRecLabel[gtLabel][recLabel])
 		overlap += (*_cells)[cellIndex].size();
 
@@ -78,7 +78,7 @@ public:
 	 * Get the number of locations shared by the given ground truth and 
 	 * reconstruction label.
 	 */
-	unsigned int getOverlap(float gtLabel, float recLabel);
+	size_t getOverlap(float gtLabel, float recLabel);
 
 	unsigned int getNumSplits();
 	unsigned int getNumMerges();
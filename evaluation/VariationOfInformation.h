@@ -3,13 +3,12 @@
 
 #include <pipeline/all.h>
 #include <imageprocessing/ImageStack.h>
+#include "SparseBlockVolume.h"
 #include "VariationOfInformationErrors.h"
+#include "ContingencySampler.h"
 
 class VariationOfInformation : public pipeline::SimpleProcessNode<> {
 
-	typedef std::map<float, double>                   LabelProb;
-	typedef std::map<std::pair<float, float>, double> JointLabelProb;
-
 public:
 
 	/**
@@ -18,8 +17,22 @@ public:
 	 * @param headerOnly
 	 *              If set to true, no error will be computed, only the header 
 	 *              information in Errors::errorHeader() will be set.
+	 *
+	 * @param ignoreBackground
+	 *              Do not count locations with ground truth label 0.
+	 *
+	 * @param sampling
+	 *              If enabled, estimate the errors from a sample of locations.
+	 *
+	 * Instead of the image stacks "reconstruction" and "ground truth", the 
+	 * inputs "sparse reconstruction" and "sparse ground truth" can be set. In 
+	 * this case, the work is proportional to the number of non-constant 
+	 * blocks. Sampling is not supported for sparse inputs.
 	 */
-	VariationOfInformation(bool headerOnly = false, bool ignoreBackground = false);
+	VariationOfInformation(
+			bool headerOnly = false,
+			bool ignoreBackground = false,
+			const ContingencySampler::Parameters& sampling = ContingencySampler::Parameters());
 
 private:
 
@@ -29,16 +42,17 @@ private:
 	pipeline::Input<ImageStack> _reconstruction;
 	pipeline::Input<ImageStack> _groundTruth;
 
-	pipeline::Output<VariationOfInformationErrors> _errors;
+	// alternative sparse inputs, used instead of the image stacks if set
+	pipeline::Input<SparseBlockVolume> _sparseReconstruction;
+	pipeline::Input<SparseBlockVolume> _sparseGroundTruth;
 
-	// label probabilities
-	LabelProb      _p1;
-	LabelProb      _p2;
-	JointLabelProb _p12;
+	pipeline::Output<VariationOfInformationErrors> _errors;
 
 	// do not count statistics for pixels that belong to the background
 	bool _ignoreBackground;
 
+	ContingencySampler::Parameters _sampling;
+
 	bool _headerOnly;
 };
 
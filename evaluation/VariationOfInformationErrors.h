@@ -10,7 +10,11 @@ public:
 
 	VariationOfInformationErrors() :
 			_splitEntropy(0),
-			_mergeEntropy(0) {}
+			_mergeEntropy(0),
+			_splitMargin(0),
+			_mergeMargin(0),
+			_margin(0),
+			_numSamples(0) {}
 
 	/**
 	 * Set the conditional entropy H(A|B), where A is the reconstruction label 
@@ -41,6 +45,33 @@ public:
 	 */
 	double getEntropy() { return _splitEntropy + _mergeEntropy; }
 
+	/**
+	 * For estimated errors, set the margins of the 95% confidence intervals of
+	 * the split, merge, and total entropy.
+	 */
+	void setMargins(double splitMargin, double mergeMargin, double margin) {
+
+		_splitMargin = splitMargin;
+		_mergeMargin = mergeMargin;
+		_margin      = margin;
+	}
+
+	double getSplitEntropyMargin() { return _splitMargin; }
+
+	double getMergeEntropyMargin() { return _mergeMargin; }
+
+	double getEntropyMargin() { return _margin; }
+
+	/**
+	 * For estimated errors, set the number of locations that were sampled.
+	 */
+	void setNumSamples(size_t numSamples) { _numSamples = numSamples; }
+
+	/**
+	 * The number of sampled locations, or 0 if the errors are exact.
+	 */
+	size_t getNumSamples() { return _numSamples; }
+
 	std::string errorHeader() { return "VOI_SPLIT\tVOI_MERGE\tVOI"; }
 
 	std::string errorString() {
@@ -55,10 +86,22 @@ public:
 	std::string humanReadableErrorString() {
 
 		std::stringstream ss;
-		ss
-				<< "VOI split: "   << getSplitEntropy()
-				<< ", VOI merge: " << getMergeEntropy()
-				<< ", VOI total: " << getEntropy();
+
+		if (_numSamples == 0) {
+
+			ss
+					<< "VOI split: "   << getSplitEntropy()
+					<< ", VOI merge: " << getMergeEntropy()
+					<< ", VOI total: " << getEntropy();
+
+		} else {
+
+			ss
+					<< "VOI split: "   << getSplitEntropy() << " +- " << getSplitEntropyMargin()
+					<< ", VOI merge: " << getMergeEntropy() << " +- " << getMergeEntropyMargin()
+					<< ", VOI total: " << getEntropy()      << " +- " << getEntropyMargin()
+					<< " (estimated from " << _numSamples << " samples)";
+		}
 
 		return ss.str();
 	}
@@ -67,6 +110,12 @@ private:
 
 	double _splitEntropy;
 	double _mergeEntropy;
+
+	double _splitMargin;
+	double _mergeMargin;
+	double _margin;
+
+	size_t _numSamples;
 };
 
 #endif // TED_EVALUATION_VARIATION_OF_INFORMATION_ERRORS_H__
@@ -0,0 +1,105 @@
+#ifndef TED_EVALUATION_VOLUME_VIEW_H__
+#define TED_EVALUATION_VOLUME_VIEW_H__
+
+#include <cstddef>
+
+/**
+ * A read-only view on a label volume in memory that is owned by someone else,
+ * e.g., a numpy array or a buffer of an embedding application. The locations
+ * are addressed by arbitrary strides (in elements) per axis, such that
+ * transposed or cropped volumes can be viewed without copying.
+ */
+template <typename T>
+class VolumeView {
+
+public:
+
+	/**
+	 * View a C contiguous volume of the given size, i.e., x varying fastest
+	 * and z slowest.
+	 */
+	VolumeView(
+			const T* data,
+			size_t width,
+			size_t height,
+			size_t depth) :
+		_data(data),
+		_width(width),
+		_height(height),
+		_depth(depth),
+		_strideX(1),
+		_strideY(width),
+		_strideZ(width*height),
+		_resX(1.0),
+		_resY(1.0),
+		_resZ(1.0) {}
+
+	/**
+	 * View a volume of the given size with the given strides in elements.
+	 */
+	VolumeView(
+			const T* data,
+			size_t width,
+			size_t height,
+			size_t depth,
+			std::ptrdiff_t strideX,
+			std::ptrdiff_t strideY,
+			std::ptrdiff_t strideZ) :
+		_data(data),
+		_width(width),
+		_height(height),
+		_depth(depth),
+		_strideX(strideX),
+		_strideY(strideY),
+		_strideZ(strideZ),
+		_resX(1.0),
+		_resY(1.0),
+		_resZ(1.0) {}
+
+	size_t width() const  { return _width; }
+	size_t height() const { return _height; }
+	size_t depth() const  { return _depth; }
+
+	/**
+	 * The number of locations in the volume.
+	 */
+	size_t size() const { return _width*_height*_depth; }
+
+	/**
+	 * The label at the given location.
+	 */
+	const T& operator()(size_t x, size_t y, size_t z) const {
+
+		return _data[
+				static_cast<std::ptrdiff_t>(x)*_strideX +
+				static_cast<std::ptrdiff_t>(y)*_strideY +
+				static_cast<std::ptrdiff_t>(z)*_strideZ];
+	}
+
+	/**
+	 * Set the number of units for each edge of a voxel.
+	 */
+	void setResolution(float resX, float resY, float resZ) {
+
+		_resX = resX;
+		_resY = resY;
+		_resZ = resZ;
+	}
+
+	float getResolutionX() const { return _resX; }
+	float getResolutionY() const { return _resY; }
+	float getResolutionZ() const { return _resZ; }
+
+private:
+
+	const T* _data;
+
+	size_t _width, _height, _depth;
+
+	std::ptrdiff_t _strideX, _strideY, _strideZ;
+
+	float _resX, _resY, _resZ;
+};
+
+#endif // TED_EVALUATION_VOLUME_VIEW_H__
+
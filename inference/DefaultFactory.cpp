@@ -1,6 +1,12 @@
 #include "DefaultFactory.h"
 
 #include <config.h>
+#include <sstream>
+#include <utility>
+#include <util/ProgramOptions.h>
+#include <util/foreach.h>
+#include "DumpingBackend.h"
+#include "PortfolioBackend.h"
 
 #ifdef HAVE_GUROBI
 #include "GurobiBackend.h"
@@ -10,26 +16,151 @@
 #include "CplexBackend.h"
 #endif
 
+util::ProgramOption optionDumpLinearPrograms(
+		util::_module           = "inference",
+		util::_long_name        = "dumpLinearPrograms",
+		util::_description_text = "Write every linear program passed to a solver backend into this directory, in the free MPS format, "
+		                          "to replay them with ted_bench_ilp.");
+
+util::ProgramOption optionLinearSolver(
+		util::_module           = "inference",
+		util::_long_name        = "linearSolver",
+		util::_description_text = "The linear solver backend configuration <backend>[:<parameter>=<value>,...], where <backend> is "
+		                          "'default', 'gurobi', 'cplex' (if compiled in), or 'portfolio'.",
+		util::_default_value    = "default");
+
+util::ProgramOption optionPortfolio(
+		util::_module           = "inference",
+		util::_long_name        = "portfolio",
+		util::_description_text = "Semicolon separated list of the backend configurations the portfolio backend races against each "
+		                          "other, e.g., 'gurobi:MIPFocus=1,Threads=2;gurobi:MIPFocus=3,Threads=2'.",
+		util::_default_value    = "gurobi:MIPFocus=1,Threads=2;gurobi:MIPFocus=2,Threads=2;gurobi:MIPFocus=3,Threads=2");
+
 LinearSolverBackend*
 DefaultFactory::createLinearSolverBackend() const {
 
-// by default, create a gurobi backend
-#ifdef HAVE_GUROBI
+	return createLinearSolverBackend(optionLinearSolver.as<std::string>());
+}
 
-	return new GurobiBackend();
+LinearSolverBackend*
+DefaultFactory::createLinearSolverBackend(const std::string& configuration) const {
+
+	LinearSolverBackend* backend = createBackend(configuration);
+
+	if (optionDumpLinearPrograms)
+		backend = new DumpingBackend(backend, optionDumpLinearPrograms.as<std::string>());
+
+	return backend;
+}
+
+LinearSolverBackend*
+DefaultFactory::createBackend(const std::string& configuration) const {
+
+	size_t sepPos = configuration.find_first_of(":");
+
+	std::string name = configuration.substr(0, sepPos);
+
+	if (name == "default" || name.empty()) {
 
+		std::vector<std::string> names = getLinearSolverBackendNames();
+
+		if (names.empty())
+			BOOST_THROW_EXCEPTION(NoSolverException() << error_message("No linear solver available."));
+
+		name = names[0];
+	}
+
+	// the parameters, comma separated
+	std::vector<std::pair<std::string, std::string> > parameters;
+
+	if (sepPos != std::string::npos) {
+
+		std::istringstream stream(configuration.substr(sepPos + 1));
+		std::string        parameter;
+
+		while (std::getline(stream, parameter, ',')) {
+
+			size_t assignPos = parameter.find_first_of("=");
+
+			if (assignPos == std::string::npos)
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"invalid solver parameter '" << parameter << "' in '" << configuration << "', expected <name>=<value>");
+
+			parameters.push_back(std::make_pair(parameter.substr(0, assignPos), parameter.substr(assignPos + 1)));
+		}
+	}
+
+	LinearSolverBackend* backend = 0;
+
+	if (name == "portfolio")
+		backend = createPortfolio();
+
+#ifdef HAVE_GUROBI
+	if (name == "gurobi")
+		backend = new GurobiBackend();
 #endif
 
-// if this is not available, create a CPLEX backend
 #ifdef HAVE_CPLEX
+	if (name == "cplex")
+		backend = new CplexBackend();
+#endif
 
-	return new CplexBackend();
+	if (!backend)
+		BOOST_THROW_EXCEPTION(NoSolverException() << error_message("Linear solver " + name + " is not available."));
 
-#endif
+	try {
 
-// if this is not available as well, throw an exception
+		for (unsigned int i = 0; i < parameters.size(); i++)
+			backend->setParameter(parameters[i].first, parameters[i].second);
 
-	BOOST_THROW_EXCEPTION(NoSolverException() << error_message("No linear solver available."));
+	} catch (...) {
+
+		delete backend;
+		throw;
+	}
+
+	return backend;
+}
+
+LinearSolverBackend*
+DefaultFactory::createPortfolio() const {
+
+	std::vector<std::string> names;
+	std::istringstream       stream(optionPortfolio.as<std::string>());
+	std::string              configuration;
+
+	while (std::getline(stream, configuration, ';'))
+		if (!configuration.empty())
+			names.push_back(configuration);
+
+	if (names.empty())
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the portfolio needs at least one backend configuration");
+
+	std::vector<LinearSolverBackend*> arms;
+
+	try {
+
+		foreach (const std::string& name, names) {
+
+			if (name.substr(0, name.find_first_of(":")) == "portfolio")
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"portfolios can not be nested");
+
+			arms.push_back(createBackend(name));
+		}
+
+	} catch (...) {
+
+		foreach (LinearSolverBackend* arm, arms)
+			delete arm;
+		throw;
+	}
+
+	return new PortfolioBackend(arms, names);
 }
 
 QuadraticSolverBackend*
@@ -53,3 +184,21 @@ DefaultFactory::createQuadraticSolverBackend() const {
 
 	BOOST_THROW_EXCEPTION(NoSolverException() << error_message("No linear solver available."));
 }
+
+std::vector<std::string>
+DefaultFactory::getLinearSolverBackendNames() {
+
+	std::vector<std::string> names;
+
+// by default, gurobi
+#ifdef HAVE_GUROBI
+	names.push_back("gurobi");
+#endif
+
+// if this is not available, CPLEX
+#ifdef HAVE_CPLEX
+	names.push_back("cplex");
+#endif
+
+	return names;
+}
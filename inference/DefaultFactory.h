@@ -1,6 +1,9 @@
 #ifndef INFERENCE_DEFAULT_FACTORY_H__
 #define INFERENCE_DEFAULT_FACTORY_H__
 
+#include <string>
+#include <vector>
+
 #include <util/exceptions.h>
 #include "LinearSolverBackendFactory.h"
 #include "QuadraticSolverBackendFactory.h"
@@ -13,9 +16,39 @@ class DefaultFactory :
 
 public:
 
+	/**
+	 * Create the linear solver backend given by the program option
+	 * inference.linearSolver.
+	 */
 	LinearSolverBackend* createLinearSolverBackend() const;
 
+	/**
+	 * Create a linear solver backend from a configuration
+	 *
+	 *   <backend>[:<parameter>=<value>[,<parameter>=<value>...]]
+	 *
+	 * e.g., "gurobi:MIPFocus=1,Threads=4". The backend is one of
+	 * getLinearSolverBackendNames(), "default" for the default backend, or
+	 * "portfolio" for a PortfolioBackend of the configurations in the program
+	 * option inference.portfolio. The parameters are passed to
+	 * LinearSolverBackend::setParameter().
+	 */
+	LinearSolverBackend* createLinearSolverBackend(const std::string& configuration) const;
+
 	QuadraticSolverBackend* createQuadraticSolverBackend() const;
+
+	/**
+	 * The names of the linear solver backends compiled in, the default
+	 * first.
+	 */
+	static std::vector<std::string> getLinearSolverBackendNames();
+
+private:
+
+	// create a backend without dumping
+	LinearSolverBackend* createBackend(const std::string& configuration) const;
+
+	LinearSolverBackend* createPortfolio() const;
 };
 
 #endif // INFERENCE_DEFAULT_FACTORY_H__
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <sstream>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <util/Logger.h>
+#include "DumpingBackend.h"
+
+static logger::LogChannel dumpingbackendlog("dumpingbackendlog", "[DumpingBackend] ");
+
+// the number of linear programs dumped by this process
+static std::atomic<unsigned int> numDumped(0);
+
+DumpingBackend::DumpingBackend(LinearSolverBackend* backend, const std::string& directory) :
+	_backend(backend),
+	_directory(directory) {
+
+	boost::filesystem::create_directories(_directory);
+}
+
+DumpingBackend::~DumpingBackend() {
+
+	delete _backend;
+}
+
+void
+DumpingBackend::initialize(
+		unsigned int numVariables,
+		VariableType variableType) {
+
+	initialize(numVariables, variableType, std::map<unsigned int, VariableType>());
+}
+
+void
+DumpingBackend::initialize(
+		unsigned int                                numVariables,
+		VariableType                                defaultVariableType,
+		const std::map<unsigned int, VariableType>& specialVariableTypes) {
+
+	_program.numVariables         = numVariables;
+	_program.defaultVariableType  = defaultVariableType;
+	_program.specialVariableTypes = specialVariableTypes;
+	_program.pinned.clear();
+
+	_backend->initialize(numVariables, defaultVariableType, specialVariableTypes);
+}
+
+void
+DumpingBackend::setObjective(const LinearObjective& objective) {
+
+	_program.objective = objective;
+
+	_backend->setObjective(objective);
+}
+
+void
+DumpingBackend::setConstraints(const LinearConstraints& constraints) {
+
+	_program.constraints = constraints;
+
+	_backend->setConstraints(constraints);
+}
+
+void
+DumpingBackend::pinVariable(unsigned int varNum, double value) {
+
+	_program.pinned[varNum] = value;
+
+	_backend->pinVariable(varNum, value);
+}
+
+bool
+DumpingBackend::unpinVariable(unsigned int varNum) {
+
+	_program.pinned.erase(varNum);
+
+	return _backend->unpinVariable(varNum);
+}
+
+bool
+DumpingBackend::solve(Solution& solution, double& value, std::string& message) {
+
+	std::stringstream name;
+	name << "lp_" << getpid() << "_" << numDumped++;
+
+	std::string filename = (boost::filesystem::path(_directory)/(name.str() + ".mps")).string();
+
+	_program.write(filename, name.str());
+
+	LOG_DEBUG(dumpingbackendlog) << "linear program dumped to " << filename << std::endl;
+
+	return _backend->solve(solution, value, message);
+}
+
+void
+DumpingBackend::setParameter(const std::string& name, const std::string& value) {
+
+	_backend->setParameter(name, value);
+}
+
+void
+DumpingBackend::setTerminationPredicate(const TerminationPredicate& predicate, double polishTime) {
+
+	_backend->setTerminationPredicate(predicate, polishTime);
+}
+
+void
+DumpingBackend::interrupt() {
+
+	_backend->interrupt();
+}
+
+SolverStatistics
+DumpingBackend::getStatistics() const {
+
+	return _backend->getStatistics();
+}
@@ -0,0 +1,64 @@
+#ifndef INFERENCE_DUMPING_BACKEND_H__
+#define INFERENCE_DUMPING_BACKEND_H__
+
+#include <string>
+
+#include "LinearProgram.h"
+#include "LinearSolverBackend.h"
+
+/**
+ * A solver backend that writes every linear program it solves into a
+ * directory, in the free MPS format, and passes it on to another backend.
+ * The files are named lp_<process id>_<number>.mps, such that concurrent
+ * solves and processes don't overwrite each other.
+ */
+class DumpingBackend : public LinearSolverBackend {
+
+public:
+
+	/**
+	 * Create a dumping backend that takes ownership of the given backend.
+	 */
+	DumpingBackend(LinearSolverBackend* backend, const std::string& directory);
+
+	virtual ~DumpingBackend();
+
+	void initialize(
+			unsigned int numVariables,
+			VariableType variableType);
+
+	void initialize(
+			unsigned int                                numVariables,
+			VariableType                                defaultVariableType,
+			const std::map<unsigned int, VariableType>& specialVariableTypes);
+
+	void setObjective(const LinearObjective& objective);
+
+	void setConstraints(const LinearConstraints& constraints);
+
+	void pinVariable(unsigned int varNum, double value);
+
+	bool unpinVariable(unsigned int varNum);
+
+	bool solve(Solution& solution, double& value, std::string& message);
+
+	void setParameter(const std::string& name, const std::string& value);
+
+	void setTerminationPredicate(const TerminationPredicate& predicate, double polishTime = 0);
+
+	void interrupt();
+
+	SolverStatistics getStatistics() const;
+
+private:
+
+	LinearSolverBackend* _backend;
+
+	std::string _directory;
+
+	// the linear program as passed to the backend
+	LinearProgram _program;
+};
+
+#endif // INFERENCE_DUMPING_BACKEND_H__
+
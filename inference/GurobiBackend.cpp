@@ -2,6 +2,7 @@
 
 #ifdef HAVE_GUROBI
 
+#include <cmath>
 #include <sstream>
 
 #include <util/Logger.h>
@@ -48,7 +49,10 @@ GurobiBackend::GurobiBackend() :
 	_numVariables(0),
 	_numConstraints(0),
 	_env(0),
-	_model(0) {
+	_model(0),
+	_polishTime(0),
+	_predicateTime(-1),
+	_interrupted(false) {
 
 	GRB_CHECK(GRBloadenv(&_env, NULL));
 }
@@ -103,6 +107,11 @@ GurobiBackend::initialize(
 
 	setNumThreads(optionGurobiNumThreads);
 
+	// parameters set explicitly override the program options
+	GRBenv* modelenv = GRBgetenv(_model);
+	for (unsigned int i = 0; i < _parameters.size(); i++)
+		GRB_CHECK(GRBsetparam(modelenv, _parameters[i].first.c_str(), _parameters[i].second.c_str()));
+
 	// add new variables to the model
 
 	_numVariables = numVariables;
@@ -287,20 +296,29 @@ GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 
 	GRB_CHECK(GRBupdatemodel(_model));
 
+	_predicateTime = -1;
+	_interrupted   = false;
+
+	// always installed, GRBterminate() calls before the optimization starts
+	// are lost and have to be repeated from the callback
+	GRB_CHECK(GRBsetcallbackfunc(_model, &GurobiBackend::terminationCallback, this));
+
 	GRB_CHECK(GRBoptimize(_model));
 
 	int status;
 	GRB_CHECK(GRBgetintattr(_model, GRB_INT_ATTR_STATUS, &status));
 
+	updateStatistics(status);
+
 	if (status != GRB_OPTIMAL) {
 
 		msg = "Optimal solution *NOT* found";
 
 		// see if a feasible solution exists
 
-		if (status == GRB_TIME_LIMIT) {
+		if (status == GRB_TIME_LIMIT || status == GRB_INTERRUPTED) {
 
-			msg += " (timeout";
+			msg += (status == GRB_TIME_LIMIT ? " (timeout" : (_predicateTime >= 0 ? " (termination predicate holds" : " (interrupted"));
 
 			int numSolutions;
 			GRB_CHECK(GRBgetintattr(_model, GRB_INT_ATTR_SOLCOUNT, &numSolutions));
@@ -343,6 +361,141 @@ GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 	return true;
 }
 
+void
+GurobiBackend::setParameter(const std::string& name, const std::string& value) {
+
+	_parameters.push_back(std::make_pair(name, value));
+
+	// apply to the current model as well
+	if (_model)
+		GRB_CHECK(GRBsetparam(GRBgetenv(_model), name.c_str(), value.c_str()));
+}
+
+void
+GurobiBackend::setTerminationPredicate(const TerminationPredicate& predicate, double polishTime) {
+
+	_terminationPredicate = predicate;
+	_polishTime           = polishTime;
+}
+
+int __stdcall
+GurobiBackend::terminationCallback(GRBmodel* model, void* cbdata, int where, void* usrdata) {
+
+	GurobiBackend* backend = static_cast<GurobiBackend*>(usrdata);
+
+	if (backend->_interrupted) {
+
+		GRBterminate(model);
+		return 0;
+	}
+
+	if (!backend->_terminationPredicate)
+		return 0;
+
+	double bound;
+	double incumbent;
+	double runtime;
+
+	if (where == GRB_CB_MIP) {
+
+		if (GRBcbget(cbdata, where, GRB_CB_MIP_OBJBND, &bound) ||
+		    GRBcbget(cbdata, where, GRB_CB_MIP_OBJBST, &incumbent))
+			return 0;
+
+	} else if (where == GRB_CB_MIPSOL) {
+
+		if (GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJBND, &bound) ||
+		    GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJBST, &incumbent))
+			return 0;
+
+	} else {
+
+		return 0;
+	}
+
+	if (GRBcbget(cbdata, where, GRB_CB_RUNTIME, &runtime))
+		return 0;
+
+	// no incumbent yet
+	if (std::abs(incumbent) >= GRB_INFINITY)
+		return 0;
+
+	if (backend->_predicateTime < 0) {
+
+		bool holds;
+
+		// exceptions must not pass through Gurobi
+		try {
+
+			holds = backend->_terminationPredicate(bound, incumbent);
+
+		} catch (...) {
+
+			LOG_ERROR(gurobilog) << "termination predicate failed, stopping the optimization" << std::endl;
+			GRBterminate(model);
+			return 0;
+		}
+
+		if (!holds)
+			return 0;
+
+		LOG_DEBUG(gurobilog)
+				<< "termination predicate holds after " << runtime << "s (bound " << bound
+				<< ", incumbent " << incumbent << ")" << std::endl;
+
+		backend->_predicateTime = runtime;
+	}
+
+	if (runtime >= backend->_predicateTime + backend->_polishTime)
+		GRBterminate(model);
+
+	return 0;
+}
+
+void
+GurobiBackend::interrupt() {
+
+	_interrupted = true;
+
+	// thread safe, the model stops at the next opportunity
+	if (_model)
+		GRBterminate(_model);
+}
+
+void
+GurobiBackend::updateStatistics(int status) {
+
+	_statistics = SolverStatistics();
+
+	_statistics.available  = true;
+	_statistics.optimal    = (status == GRB_OPTIMAL);
+	_statistics.terminated = (_predicateTime >= 0);
+
+	GRB_CHECK(GRBgetdblattr(_model, GRB_DBL_ATTR_RUNTIME, &_statistics.solveTime));
+
+	int numSolutions;
+	GRB_CHECK(GRBgetintattr(_model, GRB_INT_ATTR_SOLCOUNT, &numSolutions));
+
+	if (numSolutions == 0)
+		return;
+
+	GRB_CHECK(GRBgetdblattr(_model, GRB_DBL_ATTR_OBJVAL, &_statistics.objective));
+
+	int isMip;
+	GRB_CHECK(GRBgetintattr(_model, GRB_INT_ATTR_IS_MIP, &isMip));
+
+	// continuous programs are solved to optimality without branching
+	if (!isMip) {
+
+		_statistics.bound = _statistics.objective;
+		return;
+	}
+
+	GRB_CHECK(GRBgetdblattr(_model, GRB_DBL_ATTR_NODECOUNT, &_statistics.nodes));
+	GRB_CHECK(GRBgetdblattr(_model, GRB_DBL_ATTR_OBJBOUND, &_statistics.bound));
+	GRB_CHECK(GRBgetdblattr(_model, GRB_DBL_ATTR_MIPGAP, &_statistics.gap));
+}
+
 void
 GurobiBackend::setMIPGap(double gap) {
 
@@ -3,7 +3,10 @@
 
 #ifdef HAVE_GUROBI
 
+#include <atomic>
 #include <string>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include <gurobi_c.h>
@@ -84,6 +87,27 @@ public:
 
 	bool solve(Solution& solution, double& value, std::string& message);
 
+	/**
+	 * Set any Gurobi parameter by its name, e.g., "MIPFocus" or "Threads".
+	 */
+	void setParameter(const std::string& name, const std::string& value);
+
+	/**
+	 * Stop the optimization as soon as the predicate holds, checked in the
+	 * MIP callbacks of Gurobi.
+	 */
+	void setTerminationPredicate(const TerminationPredicate& predicate, double polishTime = 0);
+
+	/**
+	 * Stop a running solve() from another thread. Gurobi forgets a
+	 * termination request when the optimization starts, the request is
+	 * therefore also checked in the callbacks of Gurobi. A call to solve()
+	 * forgets interrupts that arrived before it.
+	 */
+	void interrupt();
+
+	SolverStatistics getStatistics() const { return _statistics; }
+
 private:
 
 	//////////////
@@ -108,6 +132,13 @@ private:
 	// enable solver output
 	void setVerbose(bool verbose);
 
+	// called by Gurobi during the optimization, stops it if interrupt() was
+	// called or once the termination predicate held for the polish time
+	static int __stdcall terminationCallback(GRBmodel* model, void* cbdata, int where, void* usrdata);
+
+	// read the statistics of the last optimization
+	void updateStatistics(int status);
+
 	// check error status and throw exception, used by our macro GRB_CHECK
 	void grbCheck(const char* call, const char* file, int line, int error);
 
@@ -122,6 +153,22 @@ private:
 
 	// the GRB model containing the objective and constraints
 	GRBmodel* _model;
+
+	// parameters set with setParameter(), in the order they were set
+	std::vector<std::pair<std::string, std::string> > _parameters;
+
+	SolverStatistics _statistics;
+
+	TerminationPredicate _terminationPredicate;
+
+	double _polishTime;
+
+	// the runtime at which the termination predicate held first, negative
+	// if it did not (yet)
+	double _predicateTime;
+
+	// interrupt() was called during the current solve()
+	std::atomic<bool> _interrupted;
 };
 
 #endif // HAVE_GUROBI
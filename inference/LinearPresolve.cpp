@@ -0,0 +1,576 @@
+#include <cmath>
+#include <limits>
+#include <util/Logger.h>
+#include <util/foreach.h>
+#include "LinearPresolve.h"
+
+static logger::LogChannel presolvelog("presolvelog", "[LinearPresolve] ");
+
+// absolute tolerance for comparisons of activities and bounds
+static const double Eps = 1e-9;
+
+// maximal number of passes over all constraints
+static const unsigned int MaxPasses = 100;
+
+static const double Infinity = std::numeric_limits<double>::infinity();
+
+LinearPresolve::LinearPresolve() :
+	_numVariables(0),
+	_infeasible(false),
+	_defaultVariableType(Continuous),
+	_numFixedVariables(0),
+	_numEmptyRows(0),
+	_numSingletonRows(0),
+	_numRedundantRows(0),
+	_numForcingRows(0),
+	_numParallelRows(0),
+	_numTightenedBounds(0) {}
+
+bool
+LinearPresolve::presolve(
+		unsigned int                                numVariables,
+		const LinearObjective&                      objective,
+		const LinearConstraints&                    constraints,
+		VariableType                                defaultVariableType,
+		const std::map<unsigned int, VariableType>& specialVariableTypes,
+		const std::map<unsigned int, double>&       pinned) {
+
+	_numVariables        = numVariables;
+	_defaultVariableType = defaultVariableType;
+	_infeasible          = false;
+
+	_numFixedVariables  = 0;
+	_numEmptyRows       = 0;
+	_numSingletonRows   = 0;
+	_numRedundantRows   = 0;
+	_numForcingRows     = 0;
+	_numParallelRows    = 0;
+	_numTightenedBounds = 0;
+
+	// natural bounds of the variables
+
+	_types.assign(_numVariables, defaultVariableType);
+	_lb.assign(_numVariables, -Infinity);
+	_ub.assign(_numVariables,  Infinity);
+
+	unsigned int var;
+	VariableType type;
+	foreach (boost::tie(var, type), specialVariableTypes)
+		if (var < _numVariables)
+			_types[var] = type;
+
+	for (unsigned int i = 0; i < _numVariables; i++)
+		if (_types[i] == Binary) {
+
+			_lb[i] = 0;
+			_ub[i] = 1;
+		}
+
+	// pinned variables are fixed
+
+	double value;
+	foreach (boost::tie(var, value), pinned) {
+
+		if (var >= _numVariables)
+			continue;
+
+		if (value < _lb[var] - Eps || value > _ub[var] + Eps) {
+
+			LOG_DEBUG(presolvelog) << "variable " << var << " is pinned outside of its bounds" << std::endl;
+			return false;
+		}
+
+		_lb[var] = _ub[var] = value;
+	}
+
+	// constraints in range form
+
+	_rows.clear();
+	_rows.reserve(constraints.size());
+	foreach (const LinearConstraint& constraint, constraints) {
+
+		Row row;
+		row.coefs  = constraint.getCoefficients();
+		row.lo     = (constraint.getRelation() == LessEqual    ? -Infinity : constraint.getValue());
+		row.hi     = (constraint.getRelation() == GreaterEqual ?  Infinity : constraint.getValue());
+		row.active = true;
+
+		_rows.push_back(row);
+	}
+
+	// reduce until nothing changes anymore
+
+	for (unsigned int pass = 0; pass < MaxPasses; pass++) {
+
+		bool changed = false;
+
+		foreach (Row& row, _rows) {
+
+			if (!row.active)
+				continue;
+
+			if (reduceRow(row))
+				changed = true;
+
+			if (_infeasible)
+				break;
+		}
+
+		if (!_infeasible && mergeParallelRows())
+			changed = true;
+
+		if (_infeasible) {
+
+			LOG_DEBUG(presolvelog) << "problem is infeasible" << std::endl;
+			return false;
+		}
+
+		if (!changed)
+			break;
+	}
+
+	std::vector<double> coefficients = objective.getCoefficients();
+	coefficients.resize(_numVariables, 0.0);
+
+	fixEmptyColumns(coefficients, objective.getSense());
+
+	buildReducedProblem(coefficients, objective);
+
+	LOG_DEBUG(presolvelog)
+			<< "reduced problem from " << _numVariables << " variables and " << constraints.size()
+			<< " constraints to " << getNumVariables() << " variables and " << _constraints.size()
+			<< " constraints" << std::endl;
+	LOG_DEBUG(presolvelog)
+			<< _numFixedVariables << " variables fixed, "
+			<< _numTightenedBounds << " bounds tightened, "
+			<< _numEmptyRows << " empty, "
+			<< _numSingletonRows << " singleton, "
+			<< _numRedundantRows << " redundant, "
+			<< _numForcingRows << " forcing, and "
+			<< _numParallelRows << " parallel constraints removed" << std::endl;
+
+	return true;
+}
+
+void
+LinearPresolve::postsolve(const Solution& reduced, Solution& solution) const {
+
+	solution.resize(_numVariables);
+
+	for (unsigned int i = 0; i < _numVariables; i++)
+		if (isFixed(i))
+			solution[i] = _lb[i];
+
+	for (unsigned int r = 0; r < _reducedToOriginal.size() && r < reduced.size(); r++)
+		solution[_reducedToOriginal[r]] = reduced[r];
+}
+
+bool
+LinearPresolve::reduceRow(Row& row) {
+
+	bool changed = false;
+
+	// substitute fixed variables
+
+	for (std::map<unsigned int, double>::iterator i = row.coefs.begin(); i != row.coefs.end();) {
+
+		if (isFixed(i->first)) {
+
+			double shift = i->second*_lb[i->first];
+			row.lo -= shift;
+			row.hi -= shift;
+			row.coefs.erase(i++);
+			changed = true;
+
+		} else {
+
+			i++;
+		}
+	}
+
+	// empty row
+
+	if (row.coefs.empty()) {
+
+		if (row.lo > Eps || row.hi < -Eps)
+			_infeasible = true;
+
+		row.active = false;
+		_numEmptyRows++;
+		return true;
+	}
+
+	// singleton row, turn into bounds
+
+	if (row.coefs.size() == 1) {
+
+		unsigned int var = row.coefs.begin()->first;
+		double       a   = row.coefs.begin()->second;
+
+		if (a > 0) {
+
+			setLowerBound(var, row.lo/a);
+			setUpperBound(var, row.hi/a);
+
+		} else {
+
+			setLowerBound(var, row.hi/a);
+			setUpperBound(var, row.lo/a);
+		}
+
+		row.active = false;
+		_numSingletonRows++;
+		return true;
+	}
+
+	// activity bounds
+
+	double minActivity = 0;
+	double maxActivity = 0;
+
+	unsigned int var;
+	double       a;
+	foreach (boost::tie(var, a), row.coefs) {
+
+		if (a > 0) {
+
+			minActivity += a*_lb[var];
+			maxActivity += a*_ub[var];
+
+		} else {
+
+			minActivity += a*_ub[var];
+			maxActivity += a*_lb[var];
+		}
+	}
+
+	if (minActivity > row.hi + Eps || maxActivity < row.lo - Eps) {
+
+		_infeasible = true;
+		return true;
+	}
+
+	// always satisfied
+
+	if (minActivity >= row.lo - Eps && maxActivity <= row.hi + Eps) {
+
+		row.active = false;
+		_numRedundantRows++;
+		return true;
+	}
+
+	// forcing, all variables have to be at the bound of minimal (maximal)
+	// activity
+
+	bool forceMin = (minActivity > -Infinity && minActivity >= row.hi - Eps);
+	bool forceMax = (maxActivity <  Infinity && maxActivity <= row.lo + Eps);
+
+	if (forceMin || forceMax) {
+
+		foreach (boost::tie(var, a), row.coefs) {
+
+			double value = ((a > 0) == forceMin ? _lb[var] : _ub[var]);
+
+			_lb[var] = _ub[var] = value;
+		}
+
+		row.active = false;
+		_numForcingRows++;
+		return true;
+	}
+
+	// remove redundant sides
+
+	if (row.lo > -Infinity && minActivity >= row.lo - Eps)
+		row.lo = -Infinity;
+	if (row.hi <  Infinity && maxActivity <= row.hi + Eps)
+		row.hi =  Infinity;
+
+	// tighten bounds of integer variables
+
+	if (row.hi < Infinity && minActivity > -Infinity) {
+
+		double slack = row.hi - minActivity;
+
+		foreach (boost::tie(var, a), row.coefs) {
+
+			if (!isInteger(var))
+				continue;
+
+			if (a > 0)
+				changed |= setUpperBound(var, _lb[var] + slack/a);
+			else
+				changed |= setLowerBound(var, _ub[var] + slack/a);
+		}
+	}
+
+	if (row.lo > -Infinity && maxActivity < Infinity) {
+
+		double slack = maxActivity - row.lo;
+
+		foreach (boost::tie(var, a), row.coefs) {
+
+			if (!isInteger(var))
+				continue;
+
+			if (a > 0)
+				changed |= setLowerBound(var, _ub[var] - slack/a);
+			else
+				changed |= setUpperBound(var, _lb[var] - slack/a);
+		}
+	}
+
+	return changed;
+}
+
+bool
+LinearPresolve::mergeParallelRows() {
+
+	// rows are parallel, if their coefficients are equal after dividing by the
+	// first coefficient, up to rounding errors: the normalized coefficients
+	// are rounded to multiples of Eps, such that they can be used as keys
+	typedef std::vector<std::pair<unsigned int, double> > Key;
+
+	std::map<Key, unsigned int> representatives;
+
+	bool changed = false;
+
+	for (unsigned int i = 0; i < _rows.size(); i++) {
+
+		Row& row = _rows[i];
+
+		if (!row.active)
+			continue;
+
+		double a = row.coefs.begin()->second;
+
+		Key key;
+		unsigned int var;
+		double       coef;
+		foreach (boost::tie(var, coef), row.coefs)
+			key.push_back(std::make_pair(var, std::round(coef/a/Eps)));
+
+		if (representatives.count(key) == 0) {
+
+			representatives[key] = i;
+			continue;
+		}
+
+		Row&   representative = _rows[representatives[key]];
+		double b              = representative.coefs.begin()->second;
+
+		// intersect the normalized ranges
+		double lo = std::max(
+				(a > 0 ? row.lo/a : row.hi/a),
+				(b > 0 ? representative.lo/b : representative.hi/b));
+		double hi = std::min(
+				(a > 0 ? row.hi/a : row.lo/a),
+				(b > 0 ? representative.hi/b : representative.lo/b));
+
+		if (lo > hi + Eps) {
+
+			_infeasible = true;
+			return true;
+		}
+
+		representative.lo = (b > 0 ? lo*b : hi*b);
+		representative.hi = (b > 0 ? hi*b : lo*b);
+
+		row.active = false;
+		_numParallelRows++;
+		changed = true;
+	}
+
+	return changed;
+}
+
+void
+LinearPresolve::fixEmptyColumns(const std::vector<double>& objective, Sense sense) {
+
+	std::vector<bool> used(_numVariables, false);
+
+	foreach (const Row& row, _rows)
+		if (row.active)
+			for (std::map<unsigned int, double>::const_iterator i = row.coefs.begin(); i != row.coefs.end(); i++)
+				used[i->first] = true;
+
+	for (unsigned int i = 0; i < _numVariables; i++) {
+
+		if (used[i] || isFixed(i))
+			continue;
+
+		double c = (sense == Minimize ? objective[i] : -objective[i]);
+
+		double value;
+		if (c > 0)
+			value = _lb[i];
+		else if (c < 0)
+			value = _ub[i];
+		else
+			value = std::min(std::max(0.0, _lb[i]), _ub[i]);
+
+		// unbounded, leave it to the solver to report
+		if (std::isinf(value))
+			continue;
+
+		_lb[i] = _ub[i] = value;
+	}
+}
+
+bool
+LinearPresolve::setLowerBound(unsigned int var, double lb) {
+
+	if (isInteger(var))
+		lb = std::ceil(lb - Eps);
+
+	if (lb <= _lb[var] + Eps)
+		return false;
+
+	if (lb > _ub[var] + Eps) {
+
+		_infeasible = true;
+		return true;
+	}
+
+	_lb[var] = std::min(lb, _ub[var]);
+	if (_ub[var] - _lb[var] <= Eps)
+		_lb[var] = _ub[var];
+
+	_numTightenedBounds++;
+	return true;
+}
+
+bool
+LinearPresolve::setUpperBound(unsigned int var, double ub) {
+
+	if (isInteger(var))
+		ub = std::floor(ub + Eps);
+
+	if (ub >= _ub[var] - Eps)
+		return false;
+
+	if (ub < _lb[var] - Eps) {
+
+		_infeasible = true;
+		return true;
+	}
+
+	_ub[var] = std::max(ub, _lb[var]);
+	if (_ub[var] - _lb[var] <= Eps)
+		_ub[var] = _lb[var];
+
+	_numTightenedBounds++;
+	return true;
+}
+
+bool
+LinearPresolve::isFixed(unsigned int var) const {
+
+	return _lb[var] == _ub[var];
+}
+
+void
+LinearPresolve::buildReducedProblem(
+		const std::vector<double>& objective,
+		const LinearObjective&     original) {
+
+	// variables
+
+	_reducedToOriginal.clear();
+	std::vector<int> originalToReduced(_numVariables, -1);
+
+	double constant = original.getConstant();
+
+	for (unsigned int i = 0; i < _numVariables; i++) {
+
+		if (isFixed(i)) {
+
+			constant += objective[i]*_lb[i];
+			_numFixedVariables++;
+			continue;
+		}
+
+		originalToReduced[i] = _reducedToOriginal.size();
+		_reducedToOriginal.push_back(i);
+	}
+
+	_specialVariableTypes.clear();
+	for (unsigned int r = 0; r < _reducedToOriginal.size(); r++)
+		if (_types[_reducedToOriginal[r]] != _defaultVariableType)
+			_specialVariableTypes[r] = _types[_reducedToOriginal[r]];
+
+	// objective
+
+	_objective.resize(0);
+	_objective.resize(_reducedToOriginal.size());
+	_objective.setSense(original.getSense());
+	_objective.setConstant(constant);
+	for (unsigned int r = 0; r < _reducedToOriginal.size(); r++)
+		_objective.setCoefficient(r, objective[_reducedToOriginal[r]]);
+
+	// constraints
+
+	_constraints.clear();
+
+	foreach (const Row& row, _rows) {
+
+		if (!row.active)
+			continue;
+
+		LinearConstraint constraint;
+		unsigned int var;
+		double       a;
+		foreach (boost::tie(var, a), row.coefs)
+			constraint.setCoefficient(originalToReduced[var], a);
+
+		if (row.hi - row.lo <= Eps) {
+
+			constraint.setRelation(Equal);
+			constraint.setValue(row.lo);
+			_constraints.add(constraint);
+			continue;
+		}
+
+		if (row.lo > -Infinity) {
+
+			constraint.setRelation(GreaterEqual);
+			constraint.setValue(row.lo);
+			_constraints.add(constraint);
+		}
+
+		if (row.hi < Infinity) {
+
+			constraint.setRelation(LessEqual);
+			constraint.setValue(row.hi);
+			_constraints.add(constraint);
+		}
+	}
+
+	// bounds that the backends don't know about
+
+	for (unsigned int r = 0; r < _reducedToOriginal.size(); r++) {
+
+		unsigned int i = _reducedToOriginal[r];
+
+		if (_types[i] == Binary)
+			continue;
+
+		if (_lb[i] > -Infinity) {
+
+			LinearConstraint constraint;
+			constraint.setCoefficient(r, 1.0);
+			constraint.setRelation(GreaterEqual);
+			constraint.setValue(_lb[i]);
+			_constraints.add(constraint);
+		}
+
+		if (_ub[i] < Infinity) {
+
+			LinearConstraint constraint;
+			constraint.setCoefficient(r, 1.0);
+			constraint.setRelation(LessEqual);
+			constraint.setValue(_ub[i]);
+			_constraints.add(constraint);
+		}
+	}
+}
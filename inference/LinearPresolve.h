@@ -0,0 +1,135 @@
+#ifndef INFERENCE_LINEAR_PRESOLVE_H__
+#define INFERENCE_LINEAR_PRESOLVE_H__
+
+#include <map>
+#include <vector>
+
+#include "LinearConstraints.h"
+#include "LinearObjective.h"
+#include "Solution.h"
+#include "VariableType.h"
+
+/**
+ * Solver independent presolve for linear programs. Reduces a problem before it
+ * is handed to a solver backend, and maps the solution of the reduced problem
+ * back to the original variables.
+ *
+ * The following reductions are applied until no more changes occur:
+ *
+ *   - fixed (and pinned) variables are substituted into the constraints and
+ *     the objective,
+ *   - empty constraints are checked and dropped,
+ *   - singleton constraints are turned into variable bounds,
+ *   - constraints that are always satisfied given the variable bounds are
+ *     dropped,
+ *   - constraints that can only be satisfied with all variables at one of
+ *     their bounds (forcing constraints) fix these variables,
+ *   - bounds of integer and binary variables are tightened from the
+ *     activities of the constraints they appear in.
+ *
+ * Afterwards, parallel constraints are merged into one (which removes
+ * duplicate and dominated constraints), and variables that do not appear in
+ * any constraint are set to the bound preferred by the objective.
+ *
+ * Bounds of non-binary variables that are tighter than their natural bounds
+ * are added to the reduced problem as singleton constraints, since the solver
+ * backends do not support bounds other than pins.
+ */
+class LinearPresolve {
+
+public:
+
+	LinearPresolve();
+
+	/**
+	 * Reduce the given problem.
+	 *
+	 * @return false, if the problem was found to be infeasible. In this case,
+	 *         the reduced problem is not valid.
+	 */
+	bool presolve(
+			unsigned int                                numVariables,
+			const LinearObjective&                      objective,
+			const LinearConstraints&                    constraints,
+			VariableType                                defaultVariableType,
+			const std::map<unsigned int, VariableType>& specialVariableTypes,
+			const std::map<unsigned int, double>&       pinned);
+
+	/**
+	 * The number of variables of the reduced problem.
+	 */
+	unsigned int getNumVariables() const { return _reducedToOriginal.size(); }
+
+	const LinearObjective& getObjective() const { return _objective; }
+
+	const LinearConstraints& getConstraints() const { return _constraints; }
+
+	VariableType getDefaultVariableType() const { return _defaultVariableType; }
+
+	const std::map<unsigned int, VariableType>& getSpecialVariableTypes() const { return _specialVariableTypes; }
+
+	/**
+	 * Map a solution of the reduced problem to a solution of the original
+	 * problem.
+	 */
+	void postsolve(const Solution& reduced, Solution& solution) const;
+
+private:
+
+	// a constraint lo <= <coefs,x> <= hi
+	struct Row {
+
+		std::map<unsigned int, double> coefs;
+		double lo;
+		double hi;
+		bool   active;
+	};
+
+	// reduce a single row, returns true if anything changed
+	bool reduceRow(Row& row);
+
+	bool mergeParallelRows();
+
+	void fixEmptyColumns(const std::vector<double>& objective, Sense sense);
+
+	bool setLowerBound(unsigned int var, double lb);
+
+	bool setUpperBound(unsigned int var, double ub);
+
+	bool isFixed(unsigned int var) const;
+
+	bool isInteger(unsigned int var) const { return _types[var] != Continuous; }
+
+	void buildReducedProblem(
+			const std::vector<double>& objective,
+			const LinearObjective&     original);
+
+	unsigned int _numVariables;
+
+	std::vector<VariableType> _types;
+	std::vector<double>       _lb;
+	std::vector<double>       _ub;
+
+	std::vector<Row> _rows;
+
+	bool _infeasible;
+
+	// the reduced problem
+	LinearObjective                      _objective;
+	LinearConstraints                    _constraints;
+	VariableType                         _defaultVariableType;
+	std::map<unsigned int, VariableType> _specialVariableTypes;
+	std::vector<unsigned int>            _reducedToOriginal;
+
+	// statistics
+	unsigned int _numFixedVariables;
+	unsigned int _numEmptyRows;
+	unsigned int _numSingletonRows;
+	unsigned int _numRedundantRows;
+	unsigned int _numForcingRows;
+	unsigned int _numParallelRows;
+	unsigned int _numTightenedBounds;
+};
+
+#endif // INFERENCE_LINEAR_PRESOLVE_H__
+
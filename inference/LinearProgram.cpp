@@ -0,0 +1,562 @@
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <util/exceptions.h>
+#include <util/foreach.h>
+#include "LinearProgram.h"
+
+namespace {
+
+// bounds beyond this are infinite, as in most solvers
+const double MpsInfinity = 1e30;
+
+// the name of the objective row
+const char* ObjectiveRow = "obj";
+
+std::vector<std::string>
+tokenize(const std::string& line) {
+
+	std::vector<std::string> tokens;
+	std::istringstream stream(line);
+	std::string token;
+
+	while (stream >> token)
+		tokens.push_back(token);
+
+	return tokens;
+}
+
+double
+parseValue(const std::string& token, unsigned int lineNumber) {
+
+	std::istringstream stream(token);
+	double value;
+
+	if (!(stream >> value))
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"MPS line " << lineNumber << ": '" << token << "' is not a number");
+
+	return value;
+}
+
+} // anonymous namespace
+
+LinearProgram::LinearProgram() :
+	numVariables(0),
+	defaultVariableType(Continuous) {}
+
+void
+LinearProgram::setup(LinearSolverBackend& backend) const {
+
+	backend.initialize(numVariables, defaultVariableType, specialVariableTypes);
+	backend.setObjective(objective);
+	backend.setConstraints(constraints);
+
+	unsigned int varNum;
+	double       value;
+	foreach (boost::tie(varNum, value), pinned)
+		backend.pinVariable(varNum, value);
+}
+
+LinearSolverParameters
+LinearProgram::getParameters() const {
+
+	LinearSolverParameters parameters(defaultVariableType);
+
+	unsigned int varNum;
+	VariableType type;
+	foreach (boost::tie(varNum, type), specialVariableTypes)
+		parameters.setVariableType(varNum, type);
+
+	return parameters;
+}
+
+size_t
+LinearProgram::getNumNonZeros() const {
+
+	size_t numNonZeros = 0;
+	foreach (const LinearConstraint& constraint, constraints)
+		numNonZeros += constraint.getCoefficients().size();
+
+	return numNonZeros;
+}
+
+void
+LinearProgram::writeMps(std::ostream& out, const std::string& name) const {
+
+	// the constraint matrix by columns
+	std::vector<std::vector<std::pair<unsigned int, double> > > columns(numVariables);
+
+	for (unsigned int row = 0; row < constraints.size(); row++) {
+
+		unsigned int varNum;
+		double       coef;
+		foreach (boost::tie(varNum, coef), constraints[row].getCoefficients()) {
+
+			if (varNum >= numVariables)
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"constraint " << row << " uses variable " << varNum << " of only " << numVariables);
+
+			columns[varNum].push_back(std::make_pair(row, coef));
+		}
+	}
+
+	const std::vector<double>& coefs = objective.getCoefficients();
+
+	// doubles have to survive the round trip
+	std::streamsize precision = out.precision(std::numeric_limits<double>::digits10 + 2);
+
+	out << "NAME " << name << "\n";
+
+	if (objective.getSense() == Maximize)
+		out << "OBJSENSE\n    MAX\n";
+
+	out << "ROWS\n N  " << ObjectiveRow << "\n";
+	for (unsigned int row = 0; row < constraints.size(); row++) {
+
+		Relation relation = constraints[row].getRelation();
+		out << " " << (relation == LessEqual ? "L" : (relation == GreaterEqual ? "G" : "E")) << "  c" << row << "\n";
+	}
+
+	out << "COLUMNS\n";
+
+	bool integer = false;
+
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++) {
+
+		// integer and binary variables are enclosed in markers
+		bool isInteger = (getVariableType(varNum) != Continuous);
+
+		if (isInteger != integer) {
+
+			out << "    MARKER 'MARKER' " << (isInteger ? "'INTORG'" : "'INTEND'") << "\n";
+			integer = isInteger;
+		}
+
+		double coef = (varNum < coefs.size() ? coefs[varNum] : 0.0);
+
+		// every column appears at least once
+		if (coef != 0 || columns[varNum].empty())
+			out << "    x" << varNum << " " << ObjectiveRow << " " << coef << "\n";
+
+		unsigned int row;
+		foreach (boost::tie(row, coef), columns[varNum])
+			out << "    x" << varNum << " c" << row << " " << coef << "\n";
+	}
+
+	if (integer)
+		out << "    MARKER 'MARKER' 'INTEND'\n";
+
+	out << "RHS\n";
+
+	// the objective constant is the negated right hand side of the objective
+	if (objective.getConstant() != 0)
+		out << "    RHS " << ObjectiveRow << " " << -objective.getConstant() << "\n";
+
+	for (unsigned int row = 0; row < constraints.size(); row++)
+		if (constraints[row].getValue() != 0)
+			out << "    RHS c" << row << " " << constraints[row].getValue() << "\n";
+
+	out << "BOUNDS\n";
+
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++) {
+
+		if (getVariableType(varNum) == Binary)
+			out << " BV BND x" << varNum << "\n";
+		else if (!pinned.count(varNum))
+			out << " FR BND x" << varNum << "\n";
+
+		if (pinned.count(varNum))
+			out << " FX BND x" << varNum << " " << pinned.at(varNum) << "\n";
+	}
+
+	out << "ENDATA" << std::endl;
+
+	out.precision(precision);
+}
+
+void
+LinearProgram::readMps(std::istream& in) {
+
+	enum Section { None, Name, ObjSense, Rows, Columns, Rhs, Bounds, End };
+
+	Section section = None;
+
+	Sense sense = Minimize;
+	std::string objectiveRow;
+
+	// the rows and columns by name
+	std::map<std::string, unsigned int> rows;
+	std::map<std::string, unsigned int> columnIndices;
+
+	// free rows other than the objective are ignored
+	std::set<std::string> freeRows;
+
+	std::vector<LinearConstraint> rowConstraints;
+	std::vector<double>           coefs;
+	std::vector<bool>             integers;
+	std::vector<bool>             binaries;
+	std::vector<double>           lowerBounds;
+	std::vector<double>           upperBounds;
+	double                        constant = 0;
+
+	bool integer = false;
+
+	std::string  line;
+	unsigned int lineNumber = 0;
+
+	while (section != End && std::getline(in, line)) {
+
+		lineNumber++;
+
+		std::vector<std::string> tokens = tokenize(line);
+
+		if (tokens.empty() || tokens[0][0] == '*')
+			continue;
+
+		// section headers start in the first column
+		if (!std::isspace(line[0])) {
+
+			const std::string& header = tokens[0];
+
+			if (header == "NAME")
+				section = Name;
+			else if (header == "OBJSENSE")
+				section = ObjSense;
+			else if (header == "ROWS")
+				section = Rows;
+			else if (header == "COLUMNS")
+				section = Columns;
+			else if (header == "RHS")
+				section = Rhs;
+			else if (header == "BOUNDS")
+				section = Bounds;
+			else if (header == "ENDATA")
+				section = End;
+			else
+				UTIL_THROW_EXCEPTION(
+						IOError,
+						"MPS line " << lineNumber << ": section " << header << " is not supported");
+
+			// the sense can follow on the same line
+			if (section == ObjSense && tokens.size() > 1)
+				sense = (tokens[1].substr(0, 3) == "MAX" ? Maximize : Minimize);
+
+			continue;
+		}
+
+		switch (section) {
+
+			case ObjSense:
+
+				sense = (tokens[0].substr(0, 3) == "MAX" ? Maximize : Minimize);
+				break;
+
+			case Rows: {
+
+				if (tokens.size() != 2)
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": expected a row type and name");
+
+				const std::string& type = tokens[0];
+
+				if (type == "N") {
+
+					if (objectiveRow.empty())
+						objectiveRow = tokens[1];
+					else
+						freeRows.insert(tokens[1]);
+
+					break;
+				}
+
+				LinearConstraint constraint;
+
+				if (type == "L")
+					constraint.setRelation(LessEqual);
+				else if (type == "G")
+					constraint.setRelation(GreaterEqual);
+				else if (type == "E")
+					constraint.setRelation(Equal);
+				else
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": unknown row type " << type);
+
+				constraint.setValue(0);
+
+				rows[tokens[1]] = rowConstraints.size();
+				rowConstraints.push_back(constraint);
+
+				break;
+			}
+
+			case Columns: {
+
+				// markers may be quoted or not
+				if (tokens.size() == 3 && (tokens[1] == "'MARKER'" || tokens[1] == "MARKER")) {
+
+					integer = (tokens[2] == "'INTORG'" || tokens[2] == "INTORG");
+					break;
+				}
+
+				if (tokens.size() != 3 && tokens.size() != 5)
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": expected a column name and one or two entries");
+
+				unsigned int varNum;
+
+				if (columnIndices.count(tokens[0])) {
+
+					varNum = columnIndices[tokens[0]];
+
+				} else {
+
+					varNum = coefs.size();
+					columnIndices[tokens[0]] = varNum;
+
+					coefs.push_back(0);
+					integers.push_back(integer);
+					binaries.push_back(false);
+
+					// the default bounds of the MPS format
+					lowerBounds.push_back(0);
+					upperBounds.push_back(std::numeric_limits<double>::infinity());
+				}
+
+				for (unsigned int i = 1; i + 1 < tokens.size(); i += 2) {
+
+					double value = parseValue(tokens[i + 1], lineNumber);
+
+					if (tokens[i] == objectiveRow)
+						coefs[varNum] = value;
+					else if (rows.count(tokens[i]))
+						rowConstraints[rows[tokens[i]]].setCoefficient(varNum, value);
+					else if (!freeRows.count(tokens[i]))
+						UTIL_THROW_EXCEPTION(
+								IOError,
+								"MPS line " << lineNumber << ": unknown row " << tokens[i]);
+				}
+
+				break;
+			}
+
+			case Rhs: {
+
+				// the name of the right hand side vector is optional
+				unsigned int first = tokens.size()%2;
+
+				for (unsigned int i = first; i + 1 < tokens.size(); i += 2) {
+
+					double value = parseValue(tokens[i + 1], lineNumber);
+
+					if (tokens[i] == objectiveRow)
+						constant = -value;
+					else if (rows.count(tokens[i]))
+						rowConstraints[rows[tokens[i]]].setValue(value);
+					else if (!freeRows.count(tokens[i]))
+						UTIL_THROW_EXCEPTION(
+								IOError,
+								"MPS line " << lineNumber << ": unknown row " << tokens[i]);
+				}
+
+				break;
+			}
+
+			case Bounds: {
+
+				const std::string& type = tokens[0];
+
+				bool hasValue = (type == "UP" || type == "LO" || type == "FX" || type == "LI" || type == "UI");
+
+				if (tokens.size() < (hasValue ? 3u : 2u))
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": incomplete bound");
+
+				// the name of the bound vector is optional
+				const std::string& column = tokens[tokens.size() - (hasValue ? 2 : 1)];
+
+				if (!columnIndices.count(column))
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": unknown column " << column);
+
+				unsigned int varNum = columnIndices[column];
+				double       value  = (hasValue ? parseValue(tokens.back(), lineNumber) : 0);
+
+				if (std::abs(value) >= MpsInfinity)
+					value = (value > 0 ? 1 : -1)*std::numeric_limits<double>::infinity();
+
+				if (type == "UP" || type == "UI") {
+
+					// a negative upper bound makes the variable unbounded
+					// below
+					if (value < 0 && lowerBounds[varNum] == 0)
+						lowerBounds[varNum] = -std::numeric_limits<double>::infinity();
+					upperBounds[varNum] = value;
+
+				} else if (type == "LO" || type == "LI") {
+
+					lowerBounds[varNum] = value;
+
+				} else if (type == "FX") {
+
+					lowerBounds[varNum] = upperBounds[varNum] = value;
+
+				} else if (type == "FR") {
+
+					lowerBounds[varNum] = -std::numeric_limits<double>::infinity();
+					upperBounds[varNum] =  std::numeric_limits<double>::infinity();
+
+				} else if (type == "MI") {
+
+					lowerBounds[varNum] = -std::numeric_limits<double>::infinity();
+
+				} else if (type == "PL") {
+
+					upperBounds[varNum] = std::numeric_limits<double>::infinity();
+
+				} else if (type == "BV") {
+
+					binaries[varNum] = true;
+					lowerBounds[varNum] = 0;
+					upperBounds[varNum] = 1;
+
+				} else {
+
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"MPS line " << lineNumber << ": unknown bound type " << type);
+				}
+
+				if (type == "LI" || type == "UI")
+					integers[varNum] = true;
+
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	if (section != End)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"MPS file ends before ENDATA");
+
+	numVariables = coefs.size();
+
+	objective = LinearObjective(numVariables);
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++)
+		objective.setCoefficient(varNum, coefs[varNum]);
+	objective.setConstant(constant);
+	objective.setSense(sense);
+
+	constraints.clear();
+	foreach (const LinearConstraint& constraint, rowConstraints)
+		constraints.add(constraint);
+
+	// the most frequent variable type is the default
+
+	std::vector<VariableType> types(numVariables);
+	unsigned int numTypes[3] = { 0, 0, 0 };
+
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++) {
+
+		types[varNum] = (binaries[varNum] ? Binary : (integers[varNum] ? Integer : Continuous));
+		numTypes[types[varNum]]++;
+	}
+
+	defaultVariableType = Continuous;
+	if (numTypes[Integer] > numTypes[defaultVariableType])
+		defaultVariableType = Integer;
+	if (numTypes[Binary] > numTypes[defaultVariableType])
+		defaultVariableType = Binary;
+
+	specialVariableTypes.clear();
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++)
+		if (types[varNum] != defaultVariableType)
+			specialVariableTypes[varNum] = types[varNum];
+
+	// the backends only know pins, other finite bounds become constraints
+
+	pinned.clear();
+
+	for (unsigned int varNum = 0; varNum < numVariables; varNum++) {
+
+		if (lowerBounds[varNum] == upperBounds[varNum]) {
+
+			pinned[varNum] = lowerBounds[varNum];
+			continue;
+		}
+
+		if (binaries[varNum])
+			continue;
+
+		if (!std::isinf(lowerBounds[varNum])) {
+
+			LinearConstraint bound;
+			bound.setCoefficient(varNum, 1.0);
+			bound.setRelation(GreaterEqual);
+			bound.setValue(lowerBounds[varNum]);
+			constraints.add(bound);
+		}
+
+		if (!std::isinf(upperBounds[varNum])) {
+
+			LinearConstraint bound;
+			bound.setCoefficient(varNum, 1.0);
+			bound.setRelation(LessEqual);
+			bound.setValue(upperBounds[varNum]);
+			constraints.add(bound);
+		}
+	}
+}
+
+void
+LinearProgram::write(const std::string& filename, const std::string& name) const {
+
+	std::ofstream out(filename.c_str());
+
+	if (!out)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << filename << " for writing");
+
+	writeMps(out, name);
+}
+
+void
+LinearProgram::read(const std::string& filename) {
+
+	std::ifstream in(filename.c_str());
+
+	if (!in)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << filename);
+
+	readMps(in);
+}
+
+VariableType
+LinearProgram::getVariableType(unsigned int var) const {
+
+	std::map<unsigned int, VariableType>::const_iterator i = specialVariableTypes.find(var);
+
+	if (i == specialVariableTypes.end())
+		return defaultVariableType;
+
+	return i->second;
+}
@@ -0,0 +1,87 @@
+#ifndef INFERENCE_LINEAR_PROGRAM_H__
+#define INFERENCE_LINEAR_PROGRAM_H__
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "LinearConstraints.h"
+#include "LinearObjective.h"
+#include "LinearSolverBackend.h"
+#include "LinearSolverParameters.h"
+#include "VariableType.h"
+
+/**
+ * A linear program as it is passed to a LinearSolverBackend: the number and
+ * types of the variables, the objective, the constraints, and the pinned
+ * variables.
+ *
+ * Linear programs can be written to and read from the free MPS format,
+ * independent of the solver backends. Variables are named x0, x1, ...,
+ * constraints c0, c1, .... Since the backends create free variables, every
+ * variable gets an explicit bound: FR for continuous and integer variables,
+ * BV for binary variables, and FX for pinned variables.
+ *
+ * Files written by other tools can be read as well. Finite variable bounds
+ * other than pins are added as singleton constraints, since the backends do
+ * not support them. RANGES are not supported.
+ */
+struct LinearProgram {
+
+	LinearProgram();
+
+	/**
+	 * Set up a backend with this linear program.
+	 */
+	void setup(LinearSolverBackend& backend) const;
+
+	/**
+	 * The variable types as parameters for a LinearSolver.
+	 */
+	LinearSolverParameters getParameters() const;
+
+	/**
+	 * The number of non-zero coefficients in the constraints.
+	 */
+	size_t getNumNonZeros() const;
+
+	/**
+	 * Write this linear program in the free MPS format.
+	 */
+	void writeMps(std::ostream& out, const std::string& name = "LP") const;
+
+	/**
+	 * Replace this linear program with one in the free MPS format.
+	 */
+	void readMps(std::istream& in);
+
+	/**
+	 * Write this linear program to an MPS file.
+	 */
+	void write(const std::string& filename, const std::string& name = "LP") const;
+
+	/**
+	 * Read this linear program from an MPS file.
+	 */
+	void read(const std::string& filename);
+
+	unsigned int numVariables;
+
+	VariableType defaultVariableType;
+
+	std::map<unsigned int, VariableType> specialVariableTypes;
+
+	LinearObjective objective;
+
+	LinearConstraints constraints;
+
+	std::map<unsigned int, double> pinned;
+
+private:
+
+	VariableType getVariableType(unsigned int var) const;
+};
+
+#endif // INFERENCE_LINEAR_PROGRAM_H__
+
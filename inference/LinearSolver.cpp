@@ -2,16 +2,25 @@
 #include <util/Logger.h>
 #include <util/foreach.h>
 #include <util/helpers.hpp>
+#include <util/ProgramOptions.h>
 #include "LinearSolver.h"
 
 static logger::LogChannel linearsolverlog("linearsolverlog", "[LinearSolver] ");
 
+util::ProgramOption optionPresolve(
+		util::_module           = "inference",
+		util::_long_name        = "presolve",
+		util::_description_text = "Reduce linear programs (fixed variables, singleton, redundant, and parallel constraints, bounds) "
+		                          "before passing them to the solver backend.");
+
 LinearSolver::LinearSolver(const LinearSolverBackendFactory& backendFactory) :
 	_solution(new Solution()),
 	_objectiveDirty(true),
 	_linearConstraintsDirty(true),
 	_parametersDirty(true),
-	_pinnedChanged(false) {
+	_pinnedChanged(false),
+	_usePresolve(optionPresolve),
+	_presolved(false) {
 
 	registerInput(_objective, "objective");
 	registerInput(_linearConstraints, "linear constraints");
@@ -60,6 +69,13 @@ LinearSolver::unpinVariable(unsigned int varNum) {
 	return false;
 }
 
+void
+LinearSolver::setTerminationPredicate(const LinearSolverBackend::TerminationPredicate& predicate, double polishTime) {
+
+	_solver->setTerminationPredicate(predicate, polishTime);
+	setDirty(_solution);
+}
+
 void
 LinearSolver::onObjectiveModified(const pipeline::Modified&) {
 
@@ -89,6 +105,18 @@ LinearSolver::updateOutputs() {
 void
 LinearSolver::updateLinearProgram() {
 
+	if (_usePresolve && (_parametersDirty || _objectiveDirty || _linearConstraintsDirty || _pinnedChanged)) {
+
+		if (updatePresolvedLinearProgram())
+			return;
+
+		LOG_ERROR(linearsolverlog) << "presolve found the linear program to be infeasible, passing it to the solver unchanged" << std::endl;
+
+		// the backend has to be set up with the original linear program
+		_parametersDirty = _objectiveDirty = _linearConstraintsDirty = _pinnedChanged = true;
+		_presolved = false;
+	}
+
 	if (_parametersDirty) {
 
 		LOG_DEBUG(linearsolverlog) << "initializing solver" << std::endl;
@@ -141,6 +169,53 @@ LinearSolver::updateLinearProgram() {
 	}
 }
 
+bool
+LinearSolver::updatePresolvedLinearProgram() {
+
+	LOG_DEBUG(linearsolverlog) << "presolving linear program" << std::endl;
+
+	bool feasible;
+
+	if (_parameters.isSet())
+		feasible = _presolve.presolve(
+				getNumVariables(),
+				*_objective,
+				*_linearConstraints,
+				_parameters->getDefaultVariableType(),
+				_parameters->getSpecialVariableTypes(),
+				_pinned);
+	else
+		feasible = _presolve.presolve(
+				getNumVariables(),
+				*_objective,
+				*_linearConstraints,
+				Continuous,
+				std::map<unsigned int, VariableType>(),
+				_pinned);
+
+	if (!feasible)
+		return false;
+
+	// the reduced program changes with every modification, set it up from 
+	// scratch (pinned variables have been substituted already)
+	if (_presolve.getNumVariables() > 0) {
+
+		_solver->initialize(
+				_presolve.getNumVariables(),
+				_presolve.getDefaultVariableType(),
+				_presolve.getSpecialVariableTypes());
+		_solver->setObjective(_presolve.getObjective());
+		_solver->setConstraints(_presolve.getConstraints());
+	}
+
+	_parametersDirty = _objectiveDirty = _linearConstraintsDirty = _pinnedChanged = false;
+	_unpinned.clear();
+
+	_presolved = true;
+
+	return true;
+}
+
 void
 LinearSolver::solve() {
 
@@ -148,15 +223,42 @@ LinearSolver::solve() {
 
 	std::string message;
 
-	if (_solver->solve(*_solution, value, message)) {
+	bool solved;
+
+	if (_presolved) {
+
+		Solution reduced;
+
+		if (_presolve.getNumVariables() == 0) {
+
+			LOG_DEBUG(linearsolverlog) << "presolve fixed all variables" << std::endl;
+			solved = true;
 
-		LOG_DEBUG(linearsolverlog) << "optimal solution found" << std::endl;
+		} else {
+
+			solved = _solver->solve(reduced, value, message);
+		}
+
+		// only a solution of the reduced program can be postsolved
+		if (solved)
+			_presolve.postsolve(reduced, *_solution);
 
 	} else {
 
+		solved = _solver->solve(*_solution, value, message);
+	}
+
+	if (!solved) {
+
 		LOG_ERROR(linearsolverlog) << "error: " << message << std::endl;
+
+		UTIL_THROW_EXCEPTION(
+				NoSolutionException,
+				"the solver backend did not find a solution: " << message);
 	}
 
+	LOG_DEBUG(linearsolverlog) << "optimal solution found" << std::endl;
+
 	LOG_ALL(linearsolverlog) << "solution: " << _solution->getVector() << std::endl;
 }
 
@@ -9,6 +9,7 @@
 #include "DefaultFactory.h"
 #include "LinearConstraints.h"
 #include "LinearObjective.h"
+#include "LinearPresolve.h"
 #include "LinearSolverBackend.h"
 #include "LinearSolverBackendFactory.h"
 #include "LinearSolverParameters.h"
@@ -36,6 +37,13 @@
  * and provide the output
  *
  *   solution    : Solution.
+ *
+ * If the program option inference.presolve is set, the linear program is
+ * reduced by a LinearPresolve before it is handed to the backend, and the
+ * solution of the reduced program is mapped back to the original variables.
+ *
+ * If the backend does not find any solution, a NoSolutionException is thrown
+ * when the solution is requested.
  */
 class LinearSolver : public pipeline::SimpleProcessNode<> {
 
@@ -67,6 +75,12 @@ public:
 	 */
 	bool unpinVariable(unsigned int varNum);
 
+	/**
+	 * Stop solving as soon as the predicate holds for the bound and the
+	 * incumbent. See LinearSolverBackend::setTerminationPredicate().
+	 */
+	void setTerminationPredicate(const LinearSolverBackend::TerminationPredicate& predicate, double polishTime = 0);
+
 private:
 
 	void onObjectiveModified(const pipeline::Modified& signal);
@@ -93,6 +107,8 @@ private:
 
 	void updateLinearProgram();
 
+	bool updatePresolvedLinearProgram();
+
 	void solve();
 
 	unsigned int getNumVariables();
@@ -112,6 +128,14 @@ private:
 	std::set<unsigned int> _unpinned;
 
 	bool _pinnedChanged;
+
+	// presolve the linear program before passing it to the backend
+	bool _usePresolve;
+
+	// the backend currently holds the presolved linear program
+	bool _presolved;
+
+	LinearPresolve _presolve;
 };
 
 #endif // INFERENCE_LINEAR_SOLVER_H__
@@ -0,0 +1,19 @@
+#include <atomic>
+#include <util/Logger.h>
+#include "LinearSolverBackend.h"
+
+static logger::LogChannel linearsolverbackendlog("linearsolverbackendlog", "[LinearSolverBackend] ");
+
+// warn only once per process, backends are created for each evaluation
+static std::atomic<bool> warnedTerminationPredicate(false);
+
+void
+LinearSolverBackend::setTerminationPredicate(const TerminationPredicate& predicate, double /*polishTime*/) {
+
+	if (predicate.empty() || warnedTerminationPredicate.exchange(true))
+		return;
+
+	LOG_USER(linearsolverbackendlog)
+			<< "warning: this solver backend does not support termination predicates, "
+			<< "the linear programs are solved to optimality" << std::endl;
+}
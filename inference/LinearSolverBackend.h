@@ -1,15 +1,31 @@
 #ifndef INFERENCE_LINEAR_SOLVER_BACKEND_H__
 #define INFERENCE_LINEAR_SOLVER_BACKEND_H__
 
+#include <string>
+
+#include <boost/function.hpp>
+#include <util/exceptions.h>
 #include "LinearObjective.h"
 #include "LinearConstraints.h"
 #include "Solution.h"
+#include "SolverStatistics.h"
 #include "VariableType.h"
 
+/**
+ * Thrown by users of a backend, if it did not find any solution.
+ */
+struct NoSolutionException : virtual Exception {};
+
 class LinearSolverBackend {
 
 public:
 
+	/**
+	 * A predicate on the best bound on the objective and the objective value
+	 * of the best solution found so far (the incumbent).
+	 */
+	typedef boost::function<bool(double bound, double incumbent)> TerminationPredicate;
+
 	virtual ~LinearSolverBackend() {}
 
 	/**
@@ -87,6 +103,49 @@ public:
 	 * @return true, if the optimal value was found.
 	 */
 	virtual bool solve(Solution& solution, double& value, std::string& message) = 0;
+
+	/**
+	 * Set a backend specific parameter, e.g., "MIPFocus" for Gurobi. Takes
+	 * precedence over the program options of the backend, and applies to all
+	 * following calls to initialize().
+	 *
+	 * @param name The name of the parameter, as used by the solver.
+	 * @param value The value of the parameter.
+	 */
+	virtual void setParameter(const std::string& name, const std::string& value) {
+
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"this solver backend does not support parameter " << name);
+	}
+
+	/**
+	 * Stop the following calls to solve() as soon as the predicate holds,
+	 * and report the incumbent as the solution. Backends that don't report
+	 * their progress ignore the predicate (with a warning) and solve to
+	 * optimality.
+	 *
+	 * @param predicate
+	 *              The termination predicate, an empty one to remove it.
+	 *
+	 * @param polishTime
+	 *              The number of seconds to continue improving the incumbent
+	 *              after the predicate holds.
+	 */
+	virtual void setTerminationPredicate(const TerminationPredicate& predicate, double polishTime = 0);
+
+	/**
+	 * Ask a running solve() to stop as soon as possible, which then reports
+	 * the best solution found so far (if any). Can be called from another
+	 * thread. Backends that can not be interrupted ignore this.
+	 */
+	virtual void interrupt() {}
+
+	/**
+	 * Get statistics of the last call to solve(). Backends that don't report
+	 * statistics return statistics that are not available.
+	 */
+	virtual SolverStatistics getStatistics() const { return SolverStatistics(); }
 };
 
 #endif // INFERENCE_LINEAR_SOLVER_BACKEND_H__
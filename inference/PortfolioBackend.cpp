@@ -0,0 +1,273 @@
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <boost/timer/timer.hpp>
+#include <util/Logger.h>
+#include "PortfolioBackend.h"
+
+static logger::LogChannel portfoliolog("portfoliolog", "[PortfolioBackend] ");
+
+PortfolioBackend::PortfolioBackend(
+		const std::vector<LinearSolverBackend*>& arms,
+		const std::vector<std::string>&          names) :
+	_arms(arms),
+	_names(names),
+	_wins(arms.size(), 0),
+	_winner(-1),
+	_sense(Minimize) {
+
+	if (_names.size() != _arms.size()) {
+
+		// the destructor does not run, but the arms are ours already
+		for (unsigned int i = 0; i < _arms.size(); i++)
+			delete _arms[i];
+
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"got " << _arms.size() << " portfolio arms, but " << _names.size() << " names");
+	}
+}
+
+PortfolioBackend::~PortfolioBackend() {
+
+	unsigned int numSolves = 0;
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		numSolves += _wins[i];
+
+	if (numSolves > 0) {
+
+		std::stringstream wins;
+		for (unsigned int i = 0; i < _arms.size(); i++)
+			wins << (i > 0 ? ", " : "") << _names[i] << ": " << _wins[i];
+
+		LOG_USER(portfoliolog) << "solves won by each arm: " << wins.str() << std::endl;
+	}
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		delete _arms[i];
+}
+
+void
+PortfolioBackend::initialize(
+		unsigned int numVariables,
+		VariableType variableType) {
+
+	initialize(numVariables, variableType, std::map<unsigned int, VariableType>());
+}
+
+void
+PortfolioBackend::initialize(
+		unsigned int                                numVariables,
+		VariableType                                defaultVariableType,
+		const std::map<unsigned int, VariableType>& specialVariableTypes) {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->initialize(numVariables, defaultVariableType, specialVariableTypes);
+}
+
+void
+PortfolioBackend::setObjective(const LinearObjective& objective) {
+
+	_sense = objective.getSense();
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->setObjective(objective);
+}
+
+void
+PortfolioBackend::setConstraints(const LinearConstraints& constraints) {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->setConstraints(constraints);
+}
+
+void
+PortfolioBackend::pinVariable(unsigned int varNum, double value) {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->pinVariable(varNum, value);
+}
+
+bool
+PortfolioBackend::unpinVariable(unsigned int varNum) {
+
+	bool pinned = false;
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		pinned = _arms[i]->unpinVariable(varNum) || pinned;
+
+	return pinned;
+}
+
+bool
+PortfolioBackend::solve(Solution& solution, double& value, std::string& message) {
+
+	unsigned int numArms = _arms.size();
+
+	std::vector<Solution>    solutions(numArms);
+	std::vector<double>      values(numArms, 0);
+	std::vector<std::string> messages(numArms);
+	std::vector<char>        solved(numArms, false);
+	std::vector<char>        done(numArms, false);
+
+	// set for the losing arms, which must not start solving anymore
+	std::vector<char>        cancelled(numArms, false);
+
+	std::mutex              mutex;
+	std::condition_variable finished;
+	std::exception_ptr      error;
+	unsigned int            numFinished = 0;
+	int                     winner      = -1;
+
+	boost::timer::cpu_timer timer;
+
+	auto run = [&](unsigned int i) {
+
+		bool success  = false;
+		bool accepted = false;
+		bool skip;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			skip = cancelled[i];
+		}
+
+		try {
+
+			if (skip) {
+
+				messages[i] = "cancelled before it started";
+
+			} else {
+
+				success = _arms[i]->solve(solutions[i], values[i], messages[i]);
+
+				// a backend without statistics can not tell whether its
+				// solution is optimal, its successful solve is final
+				SolverStatistics statistics = _arms[i]->getStatistics();
+				accepted = success && (!statistics.available || statistics.optimal || statistics.terminated);
+			}
+
+		} catch (...) {
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!error)
+				error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		solved[i] = success;
+		done[i]   = true;
+		numFinished++;
+
+		if (accepted && winner < 0)
+			winner = i;
+
+		finished.notify_one();
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < numArms; i++)
+		threads.push_back(std::thread(run, i));
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [&]() { return winner >= 0 || numFinished == numArms; });
+
+		// the first proven optimum (or a solution the termination predicate
+		// accepted) is final, stop the others
+		if (winner >= 0) {
+
+			for (unsigned int i = 0; i < numArms; i++)
+				if ((int)i != winner)
+					cancelled[i] = true;
+
+			// An arm might have checked its flag already, but not started
+			// its solve yet. Backends can forget interrupts that arrive
+			// before their solve starts, so repeat them until all arms are
+			// done.
+			while (numFinished < numArms) {
+
+				for (unsigned int i = 0; i < numArms; i++)
+					if ((int)i != winner && !done[i])
+						_arms[i]->interrupt();
+
+				finished.wait_for(lock, std::chrono::milliseconds(100), [&]() { return numFinished == numArms; });
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < numArms; i++)
+		threads[i].join();
+
+	// no optimum, take the best solution found
+	if (winner < 0)
+		for (unsigned int i = 0; i < numArms; i++)
+			if (solved[i] && (winner < 0 ||
+					(_sense == Minimize ? values[i] < values[winner] : values[i] > values[winner])))
+				winner = i;
+
+	_winner = winner;
+
+	if (winner < 0) {
+
+		_statistics = SolverStatistics();
+
+		if (error)
+			std::rethrow_exception(error);
+
+		message = "no arm of the portfolio found a solution:";
+		for (unsigned int i = 0; i < numArms; i++)
+			message += " " + _names[i] + ": " + messages[i] + ";";
+
+		return false;
+	}
+
+	_wins[winner]++;
+	_statistics = _arms[winner]->getStatistics();
+
+	LOG_DEBUG(portfoliolog)
+			<< _names[winner] << " won after " << timer.elapsed().wall*1e-9 << "s: "
+			<< messages[winner] << std::endl;
+
+	solution = solutions[winner];
+	value    = values[winner];
+	message  = messages[winner] + " (by " + _names[winner] + ")";
+
+	return true;
+}
+
+void
+PortfolioBackend::setParameter(const std::string& name, const std::string& value) {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->setParameter(name, value);
+}
+
+void
+PortfolioBackend::setTerminationPredicate(const TerminationPredicate& predicate, double polishTime) {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->setTerminationPredicate(predicate, polishTime);
+}
+
+void
+PortfolioBackend::interrupt() {
+
+	for (unsigned int i = 0; i < _arms.size(); i++)
+		_arms[i]->interrupt();
+}
+
+std::string
+PortfolioBackend::getWinner() const {
+
+	if (_winner < 0)
+		return "";
+
+	return _names[_winner];
+}
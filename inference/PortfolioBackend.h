@@ -0,0 +1,104 @@
+#ifndef INFERENCE_PORTFOLIO_BACKEND_H__
+#define INFERENCE_PORTFOLIO_BACKEND_H__
+
+#include <string>
+#include <vector>
+
+#include "LinearSolverBackend.h"
+
+/**
+ * A solver backend that races several backends (the arms of the portfolio)
+ * on the same linear program. The arms can be different solvers, or the
+ * same solver with different parameters, e.g., MIP focus settings.
+ *
+ * solve() runs all arms concurrently, returns the solution of the first arm
+ * that proves optimality (or stops because of the termination predicate),
+ * and interrupts the others. Arms that did not start solving yet are
+ * skipped. A successful solve of an arm without statistics (see
+ * SolverStatistics::available) counts as a proof of optimality. If no arm
+ * proves optimality, the best solution of the arms that found one is
+ * returned. Arms that can not be interrupted are waited for.
+ *
+ * The arms share the CPUs, so their number of threads should be limited,
+ * e.g., with the Gurobi parameter Threads.
+ */
+class PortfolioBackend : public LinearSolverBackend {
+
+public:
+
+	/**
+	 * Create a portfolio of the given backends, which it takes ownership
+	 * of, also if the constructor throws. The names identify the arms in the
+	 * reports.
+	 */
+	PortfolioBackend(
+			const std::vector<LinearSolverBackend*>& arms,
+			const std::vector<std::string>&          names);
+
+	/**
+	 * Reports how often each arm won.
+	 */
+	virtual ~PortfolioBackend();
+
+	void initialize(
+			unsigned int numVariables,
+			VariableType variableType);
+
+	void initialize(
+			unsigned int                                numVariables,
+			VariableType                                defaultVariableType,
+			const std::map<unsigned int, VariableType>& specialVariableTypes);
+
+	void setObjective(const LinearObjective& objective);
+
+	void setConstraints(const LinearConstraints& constraints);
+
+	void pinVariable(unsigned int varNum, double value);
+
+	bool unpinVariable(unsigned int varNum);
+
+	bool solve(Solution& solution, double& value, std::string& message);
+
+	/**
+	 * Set a parameter of all arms.
+	 */
+	void setParameter(const std::string& name, const std::string& value);
+
+	/**
+	 * Set the termination predicate of all arms. An arm that stops because
+	 * of it wins like one that proves optimality.
+	 */
+	void setTerminationPredicate(const TerminationPredicate& predicate, double polishTime = 0);
+
+	void interrupt();
+
+	/**
+	 * The statistics of the arm that won the last solve.
+	 */
+	SolverStatistics getStatistics() const { return _statistics; }
+
+	/**
+	 * The name of the arm that won the last solve, or an empty string if no
+	 * arm found a solution.
+	 */
+	std::string getWinner() const;
+
+private:
+
+	std::vector<LinearSolverBackend*> _arms;
+
+	std::vector<std::string> _names;
+
+	// the number of solves won by each arm
+	std::vector<unsigned int> _wins;
+
+	// the arm that won the last solve, -1 if none
+	int _winner;
+
+	Sense _sense;
+
+	SolverStatistics _statistics;
+};
+
+#endif // INFERENCE_PORTFOLIO_BACKEND_H__
+
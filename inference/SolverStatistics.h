@@ -0,0 +1,47 @@
+#ifndef INFERENCE_SOLVER_STATISTICS_H__
+#define INFERENCE_SOLVER_STATISTICS_H__
+
+/**
+ * Statistics of the last solve of a solver backend.
+ */
+struct SolverStatistics {
+
+	SolverStatistics() :
+		available(false),
+		optimal(false),
+		terminated(false),
+		solveTime(0),
+		nodes(0),
+		objective(0),
+		bound(0),
+		gap(0) {}
+
+	// the backend reported statistics, all other fields are meaningless if
+	// not set (PortfolioBackend then takes a successful solve as final)
+	bool available;
+
+	// an optimal solution was found
+	bool optimal;
+
+	// the termination predicate held, the solution is final for the caller
+	// although it might not be optimal
+	bool terminated;
+
+	// the time spent in the solver in seconds
+	double solveTime;
+
+	// the number of explored branch-and-bound nodes
+	double nodes;
+
+	// the value of the best solution found
+	double objective;
+
+	// the best bound on the objective
+	double bound;
+
+	// the relative gap between objective and bound
+	double gap;
+};
+
+#endif // INFERENCE_SOLVER_STATISTICS_H__
+
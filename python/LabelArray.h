@@ -0,0 +1,124 @@
+#ifndef PYTED_LABEL_ARRAY_H__
+#define PYTED_LABEL_ARRAY_H__
+
+#include <cstddef>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <util/exceptions.h>
+
+/**
+ * Get a C contiguous integer array for a Python object holding labels. Numpy
+ * arrays that are C contiguous and aligned already are used as they are,
+ * without copying. Returns a new reference.
+ */
+inline PyArrayObject* toLabelArray(PyObject* a, int minDims, int maxDims) {
+
+	PyArrayObject* array = (PyArrayObject*)(PyArray_FromAny(a, NULL, minDims, maxDims, NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_ALIGNED, NULL));
+
+	if (array == NULL)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"conversion to array did not work");
+
+	if (!PyArray_ISINTEGER(array)) {
+
+		Py_DECREF(array);
+
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"label arrays need an integer dtype");
+	}
+
+	return array;
+}
+
+/**
+ * Call visitor(labels, size) with a pointer of the array's type to the labels.
+ */
+template <typename Visitor>
+void visitLabels(PyArrayObject* array, Visitor& visitor) {
+
+	void*  data = PyArray_DATA(array);
+	size_t size = PyArray_SIZE(array);
+
+	switch (PyArray_TYPE(array)) {
+
+		case NPY_BYTE:      visitor(static_cast<const signed char*>(data), size);        break;
+		case NPY_UBYTE:     visitor(static_cast<const unsigned char*>(data), size);      break;
+		case NPY_SHORT:     visitor(static_cast<const short*>(data), size);              break;
+		case NPY_USHORT:    visitor(static_cast<const unsigned short*>(data), size);     break;
+		case NPY_INT:       visitor(static_cast<const int*>(data), size);                break;
+		case NPY_UINT:      visitor(static_cast<const unsigned int*>(data), size);       break;
+		case NPY_LONG:      visitor(static_cast<const long*>(data), size);               break;
+		case NPY_ULONG:     visitor(static_cast<const unsigned long*>(data), size);      break;
+		case NPY_LONGLONG:  visitor(static_cast<const long long*>(data), size);          break;
+		case NPY_ULONGLONG: visitor(static_cast<const unsigned long long*>(data), size); break;
+
+		default:
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"label arrays need an integer dtype");
+	}
+}
+
+namespace detail {
+
+template <typename Visitor, typename FirstType>
+struct SecondLabelsVisitor {
+
+	Visitor&         visitor;
+	const FirstType* first;
+
+	template <typename SecondType>
+	void operator()(const SecondType* second, size_t size) { visitor(first, second, size); }
+};
+
+template <typename Visitor>
+struct FirstLabelsVisitor {
+
+	Visitor&       visitor;
+	PyArrayObject* second;
+
+	template <typename FirstType>
+	void operator()(const FirstType* first, size_t) {
+
+		SecondLabelsVisitor<Visitor, FirstType> secondVisitor = { visitor, first };
+		visitLabels(second, secondVisitor);
+	}
+};
+
+} // namespace detail
+
+/**
+ * Call visitor(first, second, size) with pointers of the arrays' types to the
+ * labels of two arrays of the same size.
+ */
+template <typename Visitor>
+void visitLabels(PyArrayObject* first, PyArrayObject* second, Visitor& visitor) {
+
+	if (PyArray_SIZE(first) != PyArray_SIZE(second))
+		UTIL_THROW_EXCEPTION(
+				SizeMismatchError,
+				"label arrays have different size");
+
+	detail::FirstLabelsVisitor<Visitor> firstVisitor = { visitor, second };
+	visitLabels(first, firstVisitor);
+}
+
+/**
+ * Check that all labels can be represented exactly as float, which is what we
+ * (unfortunately still) use for labels.
+ */
+template <typename T>
+void checkLabels(const T* labels, size_t size) {
+
+	for (size_t i = 0; i < size; i++)
+		if (static_cast<double>(labels[i]) > 16777216.0 || static_cast<double>(labels[i]) < -16777216.0)
+			UTIL_THROW_EXCEPTION(
+					Exception,
+					"array contains value " << labels[i] << " which can not be represented exactly in float (which we unfortunately still use...)");
+}
+
+#endif // PYTED_LABEL_ARRAY_H__
+
@@ -0,0 +1,125 @@
+#include <boost/python/dict.hpp>
+#include "LabelArray.h"
+#include "ScopedGilRelease.h"
+
+#include <util/Logger.h>
+#include <evaluation/ContingencyTable.h>
+
+/**
+ * Python wrapper of the contingency table, to accumulate VOI and RAND
+ * statistics over chunks of a volume and across processes.
+ */
+class PyContingencyTable {
+
+public:
+
+	PyContingencyTable(bool ignoreBackground = false) :
+		_table(ignoreBackground) {
+
+		initialize();
+	}
+
+	/**
+	 * Count the locations of a chunk of ground truth and reconstruction
+	 * labels. Both arrays need to have the same size, and can be of any
+	 * integer dtype. C contiguous arrays are read without copying, and the
+	 * GIL is released while counting.
+	 */
+	void add(PyObject* gt, PyObject* rec) {
+
+		boost::python::handle<> gtArray((PyObject*)toLabelArray(gt, 1, 3));
+		boost::python::handle<> recArray((PyObject*)toLabelArray(rec, 1, 3));
+
+		TableFiller filler = { _table };
+
+		ScopedGilRelease noGil;
+
+		visitLabels((PyArrayObject*)gtArray.get(), (PyArrayObject*)recArray.get(), filler);
+	}
+
+	/**
+	 * Add the counts of another table.
+	 */
+	void merge(const PyContingencyTable& other) {
+
+		_table.merge(other._table);
+	}
+
+	/**
+	 * Get the table as a compact binary string.
+	 */
+	PyObject* serialize() const {
+
+		std::string blob = _table.serialize();
+
+		return PyBytes_FromStringAndSize(blob.data(), blob.size());
+	}
+
+	/**
+	 * Replace the content of this table with a string created by serialize().
+	 */
+	void deserialize(PyObject* blob) {
+
+		char*      data;
+		Py_ssize_t size;
+
+		if (PyBytes_AsStringAndSize(blob, &data, &size) != 0)
+			boost::python::throw_error_already_set();
+
+		_table.deserialize(std::string(data, size));
+	}
+
+	/**
+	 * Get the number of counted locations.
+	 */
+	uint64_t numLocations() const { return _table.getNumLocations(); }
+
+	boost::python::dict getVariationOfInformation() const {
+
+		VariationOfInformationErrors errors;
+		_table.computeVariationOfInformation(errors);
+
+		boost::python::dict result;
+		result["voi_split"] = errors.getSplitEntropy();
+		result["voi_merge"] = errors.getMergeEntropy();
+		return result;
+	}
+
+	boost::python::dict getRandIndex() const {
+
+		RandIndexErrors errors;
+		_table.computeRandIndex(errors);
+
+		boost::python::dict result;
+		result["rand_index"] = errors.getRandIndex();
+		result["rand_precision"] = errors.getPrecision();
+		result["rand_recall"] = errors.getRecall();
+		result["adapted_rand_error"] = errors.getAdaptedRandError();
+		return result;
+	}
+
+private:
+
+	struct TableFiller {
+
+		ContingencyTable& table;
+
+		template <typename GtType, typename RecType>
+		void operator()(const GtType* gt, const RecType* rec, size_t size) {
+
+			checkLabels(gt, size);
+			checkLabels(rec, size);
+
+			table.add(rec, rec + size, gt);
+		}
+	};
+
+	void initialize() {
+
+		// see PyTed::initialize()
+		auto a = []{ import_array(); };
+		a();
+	}
+
+	ContingencyTable _table;
+};
@@ -1,10 +1,19 @@
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <boost/python/numeric.hpp>
 #include <boost/python/dict.hpp>
-#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
-#include <numpy/arrayobject.h>
+#include <boost/python/list.hpp>
+#include "LabelArray.h"
+#include "ScopedGilRelease.h"
 
 #include <util/Logger.h>
-#include <evaluation/ErrorReport.h>
+#include <evaluation/ContingencyTable.h>
+#include <evaluation/ParallelFor.h>
+#include <evaluation/StageMetrics.h>
+#include <evaluation/TolerantEditDistance.h>
 #include <git_sha1.h>
 
 logger::LogChannel pytedlog("pytedlog", "[Ted] ");
@@ -16,7 +25,8 @@ public:
 	PyTed() :
 		_reportTed(true),
 		_reportRand(true),
-		_reportVoi(true) {
+		_reportVoi(true),
+		_reportVolumes(false) {
 
 		LOG_DEBUG(pytedlog) << "[Ted] constructed" << std::endl;
 		initialize();
@@ -26,102 +36,537 @@ public:
 	void reportRand(bool reportRand) { _reportRand = reportRand; }
 	void reportVoi(bool reportVoi)   { _reportVoi  = reportVoi; }
 
+	/**
+	 * Add the TED corrected reconstruction and error location volumes to the
+	 * report.
+	 */
+	void reportVolumes(bool reportVolumes) { _reportVolumes = reportVolumes; }
+
+	/**
+	 * Evaluate a reconstruction against a ground truth. Both are C contiguous
+	 * 2D or 3D arrays of any integer dtype, which are read without copying.
+	 * The GIL is released during the evaluation.
+	 */
 	boost::python::dict createReport(PyObject* gt, PyObject* rec) {
 
-		boost::python::dict summary;
+		boost::python::handle<> gtArray((PyObject*)toLabelArray(gt, 2, 3));
+		boost::python::handle<> recArray((PyObject*)toLabelArray(rec, 2, 3));
 
-		pipeline::Value<ImageStack> groundTruth = imageStackFromArray(gt);
-		pipeline::Value<ImageStack> reconstruction = imageStackFromArray(rec);
+		PyArrayObject* gtLabels  = (PyArrayObject*)gtArray.get();
+		PyArrayObject* recLabels = (PyArrayObject*)recArray.get();
 
-		ErrorReport::Parameters parameters;
-		parameters.reportTed = false;
-		parameters.reportRand = true;
-		parameters.reportVoi = true;
-		parameters.ignoreBackground = true;
+		checkShapes(gtLabels, recLabels);
 
-		pipeline::Process<ErrorReport> report(parameters);
-		report->setInput("reconstruction", reconstruction);
-		report->setInput("ground truth", groundTruth);
+		Evaluation evaluation = createEvaluation(gtLabels);
 
-		pipeline::Value<RandIndexErrors> randErrors = report->getOutput("rand errors");
-		pipeline::Value<VariationOfInformationErrors> voiErrors = report->getOutput("voi errors");
+		{
+			ScopedGilRelease noGil;
 
-		summary["voi_split"] = voiErrors->getSplitEntropy();
-		summary["voi_merge"] = voiErrors->getMergeEntropy();
-		summary["rand_index"] = randErrors->getRandIndex();
-		summary["rand_precision"] = randErrors->getPrecision();
-		summary["rand_recall"] = randErrors->getRecall();
-		summary["adapted_rand_error"] = randErrors->getAdaptedRandError();
-		summary["ted_version"] = std::string(__git_sha1);
-		return summary;
+			visitLabels(gtLabels, recLabels, evaluation);
+			evaluation.evaluate();
+		}
+
+		return toSummary(evaluation, PyArray_NDIM(gtLabels));
+	}
+
+	/**
+	 * Evaluate a sequence of (ground truth, reconstruction) pairs on numThreads
+	 * threads (all CPUs for 0), with the GIL released. The threads are shared
+	 * between the pairs, each TED uses its part of them to find alternative
+	 * cell labels. Each ground truth object is checked and converted only
+	 * once, also if it appears in several pairs. The converted labels of a
+	 * pair are released as soon as it is evaluated, those of a ground truth
+	 * after its last pair.
+	 * If one of the evaluations fails, its error is raised and no results are
+	 * returned.
+	 *
+	 * @return A list of reports as returned by createReport, in the order of
+	 *         the pairs.
+	 */
+	boost::python::list evaluateBatch(boost::python::object pairs, unsigned int numThreads) {
+
+		size_t numPairs = boost::python::len(pairs);
+
+		std::vector<boost::shared_ptr<GroundTruth> > groundTruths;
+		std::map<PyObject*, size_t>                  groundTruthIndices;
+
+		std::vector<size_t>                         pairGroundTruths;
+		std::vector<boost::python::handle<> >       recArrays;
+		std::vector<boost::shared_ptr<Evaluation> > evaluations;
+
+		for (size_t i = 0; i < numPairs; i++) {
+
+			boost::python::object pair = pairs[i];
+
+			if (boost::python::len(pair) != 2)
+				UTIL_THROW_EXCEPTION(
+						UsageError,
+						"batch entries have to be (ground truth, reconstruction) pairs");
+
+			boost::python::object gt  = pair[0];
+			boost::python::object rec = pair[1];
+
+			// pairs keeps the ground truth objects alive, their addresses
+			// identify them
+			if (!groundTruthIndices.count(gt.ptr())) {
+
+				groundTruthIndices[gt.ptr()] = groundTruths.size();
+				groundTruths.push_back(boost::make_shared<GroundTruth>(gt.ptr(), _reportTed));
+			}
+
+			const GroundTruth& groundTruth = *groundTruths[groundTruthIndices[gt.ptr()]];
+
+			recArrays.push_back(boost::python::handle<>((PyObject*)toLabelArray(rec.ptr(), 2, 3)));
+
+			checkShapes(groundTruth.labels(), (PyArrayObject*)recArrays.back().get());
+
+			pairGroundTruths.push_back(groundTruthIndices[gt.ptr()]);
+			evaluations.push_back(boost::make_shared<Evaluation>(createEvaluation(groundTruth.labels())));
+		}
+
+		// the pairs run in parallel already, split the threads between them
+		// instead of letting each TED start one per CPU
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+		unsigned int numParallelPairs = std::max<size_t>(1, std::min<size_t>(numThreads, numPairs));
+
+		foreach (boost::shared_ptr<Evaluation> evaluation, evaluations)
+			evaluation->numThreads = std::max(1u, numThreads/numParallelPairs);
+
+		// the number of pairs still to evaluate against each ground truth
+		std::vector<size_t> remainingPairs(groundTruths.size(), 0);
+		foreach (size_t groundTruthIndex, pairGroundTruths)
+			remainingPairs[groundTruthIndex]++;
+
+		std::mutex remainingMutex;
+
+		LOG_DEBUG(pytedlog)
+				<< "evaluating " << numPairs << " pairs against "
+				<< groundTruths.size() << " ground truths" << std::endl;
+
+		{
+			ScopedGilRelease noGil;
+
+			parallelFor(0, groundTruths.size(), [&](size_t i) {
+
+				visitLabels(groundTruths[i]->labels(), *groundTruths[i]);
+
+			}, numThreads);
+
+			parallelFor(0, numPairs, [&](size_t i) {
+
+				GroundTruth& groundTruth = *groundTruths[pairGroundTruths[i]];
+				Evaluation&  evaluation  = *evaluations[i];
+
+				evaluation.setGroundTruth(*groundTruth.stack);
+
+				visitLabels(groundTruth.labels(), (PyArrayObject*)recArrays[i].get(), evaluation);
+				evaluation.evaluate();
+
+				// keep only what the report needs, the batch can be large
+				evaluation.releaseInputs();
+
+				std::lock_guard<std::mutex> lock(remainingMutex);
+				if (--remainingPairs[pairGroundTruths[i]] == 0)
+					groundTruth.stack = pipeline::Value<ImageStack>();
+
+			}, numThreads);
+		}
+
+		boost::python::list reports;
+		for (size_t i = 0; i < numPairs; i++)
+			reports.append(toSummary(*evaluations[i], PyArray_NDIM(groundTruths[pairGroundTruths[i]]->labels())));
+
+		return reports;
 	}
 
 private:
 
-	pipeline::Value<ImageStack> imageStackFromArray(PyObject* a) {
+	/**
+	 * The part of the evaluation that does not need the Python interpreter.
+	 */
+	struct Evaluation {
+
+		Evaluation(
+				bool reportTed_,
+				bool reportVoiRand_,
+				bool reportVolumes_,
+				size_t width_,
+				size_t height_,
+				size_t depth_) :
+			reportTed(reportTed_),
+			reportVoiRand(reportVoiRand_),
+			reportVolumes(reportVolumes_),
+			width(width_),
+			height(height_),
+			depth(depth_),
+			groundTruthPrepared(false),
+			numThreads(0),
+			table(true /* ignore background */),
+			numSplits(0),
+			numMerges(0),
+			numFalsePositives(0),
+			numFalseNegatives(0) {}
+
+		/**
+		 * Use ground truth labels that have been checked and converted
+		 * already. The sections are shared, not copied.
+		 */
+		void setGroundTruth(const ImageStack& stack) {
+
+			for (unsigned int z = 0; z < stack.size(); z++)
+				groundTruth->add(stack[z]);
+
+			groundTruthPrepared = true;
+		}
 
-		// create (expect?) a C contiguous uint32 array
-		PyArray_Descr* descr = PyArray_DescrFromType(NPY_UINT32);
-		PyArrayObject* array = (PyArrayObject*)(PyArray_FromAny(a, descr, 2, 3, 0, NULL));
+		/**
+		 * Read the labels of ground truth and reconstruction.
+		 */
+		template <typename GtType, typename RecType>
+		void operator()(const GtType* gt, const RecType* rec, size_t size) {
 
-		if (array == NULL)
-			UTIL_THROW_EXCEPTION(
-					UsageError,
-					"conversion to array did not work");
+			StageMetrics::Timer readTimer(&metrics, "read labels");
 
-		LOG_DEBUG(pytedlog) << "converted to array" << std::endl;
+			if (!groundTruthPrepared)
+				checkLabels(gt, size);
+			checkLabels(rec, size);
 
-		int dims = PyArray_NDIM(array);
-		if (dims != 2 and dims != 3)
-			UTIL_THROW_EXCEPTION(
-					UsageError,
-					"only arrays of dimensions 2 or 3 are supported.");
+			// the TED needs them as image stacks
+			if (reportTed) {
+
+				if (!groundTruthPrepared)
+					groundTruth = toImageStack(gt, width, height, depth);
+				reconstruction = toImageStack(rec, width, height, depth);
+			}
+
+			readTimer.addCount("locations", size);
+			readTimer.stop();
+
+			// VOI and RAND read the labels directly
+			if (reportVoiRand) {
+
+				StageMetrics::Timer tableTimer(&metrics, "contingency table");
+				table.add(rec, rec + size, gt);
+				tableTimer.addCount("locations", size);
+			}
+		}
+
+		/**
+		 * Compute the errors.
+		 */
+		void evaluate() {
+
+			if (reportVoiRand) {
+
+				StageMetrics::Timer timer(&metrics, "voi and rand");
+				table.computeVariationOfInformation(voiErrors);
+				table.computeRandIndex(randErrors);
+			}
+
+			if (!reportTed)
+				return;
+
+			TedEngine::Options options = TedEngine::Options::fromProgramOptions();
+			if (numThreads > 0)
+				options.numThreads = numThreads;
+
+			pipeline::Process<TolerantEditDistance> ted(options, false);
+			ted->setInput("ground truth", groundTruth);
+			ted->setInput("reconstruction", reconstruction);
+
+			pipeline::Value<TolerantEditDistanceErrors> errors = ted->getOutput("errors");
+			pipeline::Value<StageMetrics>               tedMetrics = ted->getOutput("metrics");
+
+			metrics.add(*tedMetrics);
+
+			numSplits         = errors->getNumSplits();
+			numMerges         = errors->getNumMerges();
+			numFalsePositives = errors->getNumFalsePositives();
+			numFalseNegatives = errors->getNumFalseNegatives();
+
+			foreach (float gtLabel, errors->getSplitLabels())
+				splits[gtLabel] = errors->getSplits(gtLabel);
+			foreach (float recLabel, errors->getMergeLabels())
+				merges[recLabel] = errors->getMerges(recLabel);
+			if (errors->hasBackgroundLabel()) {
+
+				falsePositives = errors->getFalsePositives();
+				falseNegatives = errors->getFalseNegatives();
+			}
+
+			if (reportVolumes) {
+
+				correctedReconstruction = ted->getOutput("corrected reconstruction");
+				splitLocations          = ted->getOutput("splits");
+				mergeLocations          = ted->getOutput("merges");
+				fpLocations             = ted->getOutput("false positives");
+				fnLocations             = ted->getOutput("false negatives");
+
+				// make sure they are computed before we get the GIL back
+				correctedReconstruction->size();
+				splitLocations->size();
+				mergeLocations->size();
+				fpLocations->size();
+				fnLocations->size();
+			}
+		}
+
+		/**
+		 * Release the labels and the contingency table after evaluate(),
+		 * which the report does not need.
+		 */
+		void releaseInputs() {
+
+			groundTruth    = pipeline::Value<ImageStack>();
+			reconstruction = pipeline::Value<ImageStack>();
+			table = ContingencyTable(table.ignoresBackground());
+		}
+
+		bool reportTed;
+		bool reportVoiRand;
+		bool reportVolumes;
 
 		size_t width, height, depth;
 
-		if (dims == 2) {
+		bool groundTruthPrepared;
 
-			depth = 1;
-			height = PyArray_DIM(array, 0);
-			width = PyArray_DIM(array, 1);
+		// the number of threads of the TED, 0 for the program option
+		// evaluation.numThreads
+		unsigned int numThreads;
 
-		} else {
+		// the time and memory of the stages of this evaluation
+		StageMetrics metrics;
+
+		ContingencyTable             table;
+		VariationOfInformationErrors voiErrors;
+		RandIndexErrors              randErrors;
+
+		pipeline::Value<ImageStack> groundTruth;
+		pipeline::Value<ImageStack> reconstruction;
+
+		unsigned int numSplits;
+		unsigned int numMerges;
+		unsigned int numFalsePositives;
+		unsigned int numFalseNegatives;
+
+		std::map<float, std::set<float> > splits;
+		std::map<float, std::set<float> > merges;
+		std::set<float>                   falsePositives;
+		std::set<float>                   falseNegatives;
 
-			depth =  PyArray_DIM(array, 0);
-			height = PyArray_DIM(array, 1);
-			width = PyArray_DIM(array, 2);
+		pipeline::Value<ImageStack> correctedReconstruction;
+		pipeline::Value<ImageStack> splitLocations;
+		pipeline::Value<ImageStack> mergeLocations;
+		pipeline::Value<ImageStack> fpLocations;
+		pipeline::Value<ImageStack> fnLocations;
+	};
+
+	/**
+	 * Ground truth labels, checked and converted once for all evaluations
+	 * against them.
+	 */
+	struct GroundTruth {
+
+		GroundTruth(PyObject* gt, bool reportTed_) :
+			array((PyObject*)toLabelArray(gt, 2, 3)),
+			reportTed(reportTed_) {}
+
+		PyArrayObject* labels() const { return (PyArrayObject*)array.get(); }
+
+		template <typename T>
+		void operator()(const T* gt, size_t size) {
+
+			checkLabels(gt, size);
+
+			if (!reportTed)
+				return;
+
+			int dims = PyArray_NDIM(labels());
+
+			stack = toImageStack(
+					gt,
+					PyArray_DIM(labels(), dims - 1),
+					PyArray_DIM(labels(), dims - 2),
+					(dims == 3 ? PyArray_DIM(labels(), 0) : 1));
 		}
 
-		LOG_DEBUG(pytedlog) << "copying data..." << std::endl;
+		boost::python::handle<> array;
+
+		bool reportTed;
+
+		pipeline::Value<ImageStack> stack;
+	};
+
+	Evaluation createEvaluation(PyArrayObject* gtLabels) {
+
+		int dims = PyArray_NDIM(gtLabels);
+
+		return Evaluation(
+				_reportTed,
+				_reportVoi || _reportRand,
+				_reportVolumes,
+				PyArray_DIM(gtLabels, dims - 1),
+				PyArray_DIM(gtLabels, dims - 2),
+				(dims == 3 ? PyArray_DIM(gtLabels, 0) : 1));
+	}
+
+	void checkShapes(PyArrayObject* gtLabels, PyArrayObject* recLabels) {
+
+		int dims = PyArray_NDIM(gtLabels);
+
+		if (PyArray_NDIM(recLabels) != dims)
+			UTIL_THROW_EXCEPTION(
+					SizeMismatchError,
+					"ground truth and reconstruction have different dimensions");
+
+		for (int i = 0; i < dims; i++)
+			if (PyArray_DIM(gtLabels, i) != PyArray_DIM(recLabels, i))
+				UTIL_THROW_EXCEPTION(
+						SizeMismatchError,
+						"ground truth and reconstruction have different size");
+	}
+
+	template <typename T>
+	static pipeline::Value<ImageStack> toImageStack(const T* labels, size_t width, size_t height, size_t depth) {
 
 		pipeline::Value<ImageStack> stack;
+
 		for (size_t z = 0; z < depth; z++) {
 
 			boost::shared_ptr<Image> image = boost::make_shared<Image>(width, height);
-			for (size_t y = 0; y < height; y++)
-				for (size_t x = 0; x < width; x++) {
-
-					uint32_t value;
-					if (dims == 2)
-						value = *static_cast<uint32_t*>(PyArray_GETPTR2(array, y, x));
-					else
-						value = *static_cast<uint32_t*>(PyArray_GETPTR3(array, z, y, x));
-
-					if (value > 16777216)
-						UTIL_THROW_EXCEPTION(
-								Exception,
-								"array contains value " << value << " which can not be represented exactly in float (which we unfortunately still use...)");
-					(*image)(x,y) = value;
-				}
+
+			const T* section = labels + z*width*height;
+			std::copy(section, section + width*height, image->data());
 
 			stack->add(image);
 		}
 
-		LOG_DEBUG(pytedlog) << "done" << std::endl;
-
 		return stack;
 	}
 
+	boost::python::dict toSummary(Evaluation& evaluation, int dims) {
+
+		boost::python::dict summary;
+
+		if (_reportVoi) {
+
+			summary["voi_split"] = evaluation.voiErrors.getSplitEntropy();
+			summary["voi_merge"] = evaluation.voiErrors.getMergeEntropy();
+		}
+
+		if (_reportRand) {
+
+			summary["rand_index"] = evaluation.randErrors.getRandIndex();
+			summary["rand_precision"] = evaluation.randErrors.getPrecision();
+			summary["rand_recall"] = evaluation.randErrors.getRecall();
+			summary["adapted_rand_error"] = evaluation.randErrors.getAdaptedRandError();
+		}
+
+		if (_reportTed) {
+
+			summary["ted_fs"] = evaluation.numSplits;
+			summary["ted_fm"] = evaluation.numMerges;
+			summary["ted_fp"] = evaluation.numFalsePositives;
+			summary["ted_fn"] = evaluation.numFalseNegatives;
+			summary["ted_total"] = evaluation.numSplits + evaluation.numMerges + evaluation.numFalsePositives + evaluation.numFalseNegatives;
+
+			summary["ted_splits"] = toDict(evaluation.splits);
+			summary["ted_merges"] = toDict(evaluation.merges);
+			summary["ted_false_positives"] = toList(evaluation.falsePositives);
+			summary["ted_false_negatives"] = toList(evaluation.falseNegatives);
+
+			if (_reportVolumes) {
+
+				summary["ted_corrected_reconstruction"] = toArray(*evaluation.correctedReconstruction, dims);
+				summary["ted_split_locations"] = toArray(*evaluation.splitLocations, dims);
+				summary["ted_merge_locations"] = toArray(*evaluation.mergeLocations, dims);
+				summary["ted_fp_locations"] = toArray(*evaluation.fpLocations, dims);
+				summary["ted_fn_locations"] = toArray(*evaluation.fnLocations, dims);
+			}
+		}
+
+		summary["metrics"] = toDict(evaluation.metrics);
+
+		summary["ted_version"] = std::string(__git_sha1);
+		return summary;
+	}
+
+	boost::python::dict toDict(const StageMetrics& metrics) {
+
+		boost::python::dict dict;
+		foreach (const StageMetrics::Stage& stage, metrics.getStages()) {
+
+			boost::python::dict counts;
+			for (std::map<std::string, size_t>::const_iterator i = stage.counts.begin(); i != stage.counts.end(); i++)
+				counts[i->first] = i->second;
+
+			boost::python::dict entry;
+			entry["calls"]          = stage.calls;
+			entry["wall_time"]      = stage.wallTime;
+			entry["cpu_time"]       = stage.cpuTime;
+			entry["peak_rss_delta"] = stage.peakRssDelta;
+			entry["counts"]         = counts;
+
+			dict[stage.name] = entry;
+		}
+
+		return dict;
+	}
+
+	boost::python::list toList(const std::set<float>& labels) {
+
+		boost::python::list list;
+		foreach (float label, labels)
+			list.append(static_cast<long long>(label));
+
+		return list;
+	}
+
+	boost::python::dict toDict(const std::map<float, std::set<float> >& labels) {
+
+		boost::python::dict dict;
+		for (std::map<float, std::set<float> >::const_iterator i = labels.begin(); i != labels.end(); i++)
+			dict[static_cast<long long>(i->first)] = toList(i->second);
+
+		return dict;
+	}
+
+	/**
+	 * Copy an image stack into a new float32 array of the given dimensions.
+	 * The sections of an image stack are separate buffers, a single array
+	 * can therefore not share their memory.
+	 */
+	boost::python::object toArray(const ImageStack& stack, int dims) {
+
+		npy_intp shape[3];
+		if (dims == 2) {
+
+			shape[0] = stack.height();
+			shape[1] = stack.width();
+
+		} else {
+
+			shape[0] = stack.size();
+			shape[1] = stack.height();
+			shape[2] = stack.width();
+		}
+
+		PyObject* array = PyArray_SimpleNew(dims, shape, NPY_FLOAT);
+
+		if (array == NULL)
+			boost::python::throw_error_already_set();
+
+		float* data = static_cast<float*>(PyArray_DATA((PyArrayObject*)array));
+
+		size_t sectionSize = static_cast<size_t>(stack.width())*stack.height();
+		for (unsigned int z = 0; z < stack.size(); z++)
+			std::copy(stack[z]->data(), stack[z]->data() + sectionSize, data + z*sectionSize);
+
+		return boost::python::object(boost::python::handle<>(array));
+	}
+
 	void initialize() {
 
 		// import_array is a macro expanding to returning different types across 
@@ -134,4 +579,5 @@ private:
 	bool _reportTed;
 	bool _reportRand;
 	bool _reportVoi;
+	bool _reportVolumes;
 };
@@ -0,0 +1,33 @@
+#ifndef PYTED_SCOPED_GIL_RELEASE_H__
+#define PYTED_SCOPED_GIL_RELEASE_H__
+
+#include <Python.h>
+
+/**
+ * Releases the global interpreter lock for the lifetime of this object, such
+ * that other Python threads can run while we compute. No Python API must be
+ * used in the meantime. The lock is acquired again when the object goes out
+ * of scope, also if an exception is thrown.
+ */
+class ScopedGilRelease {
+
+public:
+
+	ScopedGilRelease() :
+		_state(PyEval_SaveThread()) {}
+
+	~ScopedGilRelease() {
+
+		PyEval_RestoreThread(_state);
+	}
+
+private:
+
+	ScopedGilRelease(const ScopedGilRelease&);
+	ScopedGilRelease& operator=(const ScopedGilRelease&);
+
+	PyThreadState* _state;
+};
+
+#endif // PYTED_SCOPED_GIL_RELEASE_H__
+
@@ -41,6 +41,7 @@ def test(ba, bb):
     cremi_result_rand = evaluate.adapted_rand(bv)
 
     t = pyted.Ted()
+    t.report_ted(False)
     ted_result = t.create_report(a, b)
 
     print("CREMI:")
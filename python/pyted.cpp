@@ -4,6 +4,7 @@
 
 #include <util/exceptions.h>
 #include "PyTed.h"
+#include "PyContingencyTable.h"
 #include "logging.h"
 
 template <typename Map, typename K, typename V>
@@ -81,7 +82,19 @@ BOOST_PYTHON_MODULE(pyted) {
 			.def("report_ted", &PyTed::reportTed)
 			.def("report_rand", &PyTed::reportRand)
 			.def("report_voi", &PyTed::reportVoi)
+			.def("report_volumes", &PyTed::reportVolumes)
 			.def("create_report", &PyTed::createReport)
+			.def("evaluate_batch", &PyTed::evaluateBatch, (boost::python::arg("pairs"), boost::python::arg("num_threads") = 0))
+			;
+
+	boost::python::class_<PyContingencyTable>("ContingencyTable", boost::python::init<boost::python::optional<bool> >())
+			.def("add", &PyContingencyTable::add)
+			.def("merge", &PyContingencyTable::merge)
+			.def("serialize", &PyContingencyTable::serialize)
+			.def("deserialize", &PyContingencyTable::deserialize)
+			.def("num_locations", &PyContingencyTable::numLocations)
+			.def("voi", &PyContingencyTable::getVariationOfInformation)
+			.def("rand", &PyContingencyTable::getRandIndex)
 			;
 }
 